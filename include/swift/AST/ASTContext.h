@@ -36,6 +36,7 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/Mutex.h"
 #include <functional>
 #include <memory>
 #include <utility>
@@ -712,6 +713,13 @@ public:
   /// \returns the previous generation number.
   unsigned bumpGeneration() { return CurrentGeneration++; }
 
+  /// Returns the lock held while declarations and types are read from
+  /// serialized modules into this context.
+  ///
+  /// The lock is recursive, since reading one declaration can pull in others
+  /// from any module loaded into the context.
+  llvm::sys::Mutex &getDeserializationMutex() const;
+
   /// \brief Produce a "normal" conformance for a nominal type.
   NormalProtocolConformance *
   getConformance(Type conformingType,
@@ -66,6 +66,10 @@ public:
   /// Useful when you want to enable -O LLVM opts but not -O SIL opts.
   bool DisableSILPerfOptimizations = false;
 
+  /// Assume that code will be executed in a single-threaded environment and
+  /// emit non-atomic reference counting operations.
+  bool AssumeSingleThreaded = false;
+
   /// Controls whether or not paranoid verification checks are run.
   bool VerifyAll = false;
 
@@ -0,0 +1,123 @@
+//===--- BinarySwiftDeps.h - Binary reference dependencies ------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines a compact binary format for Swift reference dependency
+/// (".swiftdeps") files, which can be read in place from a mapped file.
+///
+/// A file consists of
+/// - the header: the signature, then the format version, the number of
+///   entries, the number of names and the index of the interface hash in the
+///   names (or \ref NoName), each as a uint32_t;
+/// - the entries, each as a uint32_t index into the names, a uint8_t
+///   \ref Section, a uint8_t set of \ref EntryFlags and two bytes of padding;
+/// - the offsets of the names into the string data, as one uint32_t per name
+///   and one for the end of the string data;
+/// - the string data.
+///
+/// All integers are little-endian. Every name is stored only once. The names
+/// of members are stored as the mangled name of their type, a null character
+/// and the member name, which is how the driver keys them.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_BASIC_BINARYSWIFTDEPS_H
+#define SWIFT_BASIC_BINARYSWIFTDEPS_H
+
+#include "swift/Basic/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstdint>
+#include <vector>
+
+namespace swift {
+namespace binary_swiftdeps {
+
+/// The first bytes of every binary dependency file. This can't be the start
+/// of a valid YAML dependency file.
+const char Signature[4] = { '\xDE', 'S', 'D', 'P' };
+
+/// Changed whenever the format changes incompatibly.
+const uint32_t FormatVersion = 1;
+
+/// Used in place of a name index if there is no such name.
+const uint32_t NoName = ~0U;
+
+/// The kinds of entry, matching the keys of the YAML format.
+enum class Section : uint8_t {
+  ProvidesTopLevel,
+  ProvidesNominal,
+  ProvidesMember,
+  ProvidesDynamicLookup,
+  DependsTopLevel,
+  DependsNominal,
+  DependsMember,
+  DependsDynamicLookup,
+  DependsExternal,
+};
+
+/// The last valid Section.
+const Section LastSection = Section::DependsExternal;
+
+enum EntryFlags : uint8_t {
+  /// The dependency is cascading, i.e. it isn't marked "!private" in YAML.
+  IsCascading = 1 << 0,
+};
+
+/// Returns true if \p data starts like a binary dependency file.
+inline bool hasSignature(StringRef data) {
+  return data.startswith(StringRef(Signature, sizeof(Signature)));
+}
+
+/// Collects the entries of a binary dependency file, and writes it out.
+class Writer {
+  struct Entry {
+    uint32_t Name;
+    Section Kind;
+    uint8_t Flags;
+  };
+
+  llvm::StringMap<uint32_t> NameIndices;
+  std::vector<StringRef> Names;
+  std::vector<Entry> Entries;
+  uint32_t InterfaceHash = NoName;
+
+  uint32_t getNameIndex(StringRef name);
+
+public:
+  /// Adds an entry for \p name. Member names must already be in the form
+  /// described above.
+  void addEntry(Section kind, StringRef name, bool isCascading = true);
+
+  void setInterfaceHash(StringRef hash) {
+    InterfaceHash = getNameIndex(hash);
+  }
+
+  void write(raw_ostream &out) const;
+};
+
+/// Reads a binary dependency file in place.
+///
+/// The names passed to \p entryCallback and \p interfaceHashCallback point
+/// into \p data.
+///
+/// \returns true if \p data is not a valid binary dependency file. The
+/// callbacks may already have been called when this happens.
+bool read(StringRef data,
+          llvm::function_ref<void(Section, StringRef, bool)> entryCallback,
+          llvm::function_ref<void(StringRef)> interfaceHashCallback);
+
+} // end namespace binary_swiftdeps
+} // end namespace swift
+
+#endif // SWIFT_BASIC_BINARYSWIFTDEPS_H
@@ -18,6 +18,7 @@
 #include <vector>
 #include <cassert>
 #include <cstdint>
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "swift/Basic/Malloc.h"
 
@@ -69,6 +70,7 @@ struct DemangleOptions {
 };
 
 class Node;
+class NodeArena;
 typedef std::shared_ptr<Node> NodePointer;
 
 enum class FunctionSigSpecializationParamKind : unsigned {
@@ -157,8 +159,8 @@ private:
     IndexType IndexPayload;
   };
 
-  // FIXME: use allocator.
-  typedef std::vector<NodePointer> NodeVector;
+  // Most nodes have at most two children, which are stored inline.
+  typedef llvm::SmallVector<NodePointer, 2> NodeVector;
   NodeVector Children;
 
   Node(Kind k)
@@ -250,6 +252,15 @@ demangleSymbolAsNode(const std::string &mangledName,
   return demangleSymbolAsNode(mangledName.data(), mangledName.size(), options);
 }
 
+/// \brief Demangle the given string as a Swift symbol, creating the nodes in
+/// \p arena.
+///
+/// The returned tree must be released before \p arena is reset or destroyed.
+NodePointer
+demangleSymbolAsNode(const char *mangledName, size_t mangledNameLength,
+                     NodeArena &arena,
+                     const DemangleOptions &options = DemangleOptions());
+
 /// \brief Demangle the given string as a Swift symbol.
 ///
 /// Typical usage:
@@ -300,6 +311,15 @@ demangleTypeAsNode(const std::string &mangledName,
   return demangleTypeAsNode(mangledName.data(), mangledName.size(), options);
 }
 
+/// \brief Demangle the given string as a Swift type, creating the nodes in
+/// \p arena.
+///
+/// The returned tree must be released before \p arena is reset or destroyed.
+NodePointer
+demangleTypeAsNode(const char *mangledName, size_t mangledNameLength,
+                   NodeArena &arena,
+                   const DemangleOptions &options = DemangleOptions());
+
 /// \brief Demangle the given string as a Swift type mangling.
 ///
 /// \param mangledName The mangled string.
@@ -350,7 +370,56 @@ std::string mangleNode(const NodePointer &root);
 std::string nodeToString(NodePointer Root,
                          const DemangleOptions &Options = DemangleOptions());
 
+/// A bump-pointer arena to demangle into.
+///
+/// The nodes created in an arena, and their reference counts, are carved out
+/// of a few large slabs instead of being allocated one by one, and the slabs
+/// are freed all at once. All the NodePointers into an arena must be released
+/// before the arena is reset or destroyed.
+class NodeArena {
+  struct Slab;
+  Slab *Slabs = nullptr;
+  char *CurPtr = nullptr;
+  char *End = nullptr;
+
+  void *allocateSlow(size_t Size, size_t Alignment);
+
+public:
+  NodeArena() = default;
+  NodeArena(const NodeArena &) = delete;
+  NodeArena &operator=(const NodeArena &) = delete;
+  ~NodeArena();
+
+  void *allocate(size_t Size, size_t Alignment) {
+    uintptr_t Aligned = (uintptr_t(CurPtr) + Alignment - 1) & ~(Alignment - 1);
+    if (CurPtr && Aligned + Size <= uintptr_t(End)) {
+      CurPtr = reinterpret_cast<char *>(Aligned + Size);
+      return reinterpret_cast<void *>(Aligned);
+    }
+    return allocateSlow(Size, Alignment);
+  }
+
+  /// Frees all the nodes, keeping one slab around for reuse.
+  void reset();
+};
+
 struct NodeFactory {
+  /// Create a node in \p Arena, or on the heap if \p Arena is null.
+  static NodePointer create(NodeArena *Arena, Node::Kind K);
+  static NodePointer create(NodeArena *Arena, Node::Kind K,
+                            Node::IndexType Index);
+  static NodePointer create(NodeArena *Arena, Node::Kind K,
+                            std::string &&Text);
+  static NodePointer create(NodeArena *Arena, Node::Kind K,
+                            llvm::StringRef Text) {
+    return create(Arena, K, Text.str());
+  }
+  template <size_t N>
+  static NodePointer create(NodeArena *Arena, Node::Kind K,
+                            const char (&Text)[N]) {
+    return create(Arena, K, llvm::StringRef(Text));
+  }
+
   static NodePointer create(Node::Kind K) {
     return NodePointer(new Node(K));
   }
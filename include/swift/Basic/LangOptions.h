@@ -21,6 +21,7 @@
 #include "swift/Basic/LLVM.h"
 #include "clang/Basic/VersionTuple.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
@@ -133,6 +134,11 @@ namespace swift {
     /// allocated by the constraint solver.
     unsigned SolverMemoryThreshold = 15000000;
 
+    /// \brief The upper bound, in milliseconds, of the time the constraint
+    /// solver may spend on a single expression, if any. With a bound of 0, the
+    /// solver gives up on every expression that needs a search.
+    Optional<unsigned> SolverExpressionTimeThreshold;
+
     /// \brief Perform all dynamic allocations using malloc/free instead of
     /// optimized custom allocator, so that memory debugging tools can be used.
     bool UseMalloc = false;
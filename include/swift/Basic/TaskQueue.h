@@ -18,6 +18,7 @@
 #include "llvm/Config/config.h"
 #include "llvm/Support/Program.h"
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <queue>
@@ -97,6 +98,18 @@ public:
     TaskSignalledCallback;
 #pragma clang diagnostic pop
 
+  /// \brief A callback which will be executed when the timer set with
+  /// \ref armTimer expires.
+  typedef std::function<void()> TimerCallback;
+
+private:
+  /// When the armed timer expires.
+  std::chrono::steady_clock::time_point TimerDeadline;
+
+  /// The callback of the armed timer, if any.
+  TimerCallback Timer;
+
+public:
   /// \brief Indicates whether TaskQueue supports buffering output on the
   /// current system.
   ///
@@ -113,6 +126,18 @@ public:
   /// parallel
   unsigned getNumberOfParallelTasks() const;
 
+  /// \brief Asks the TaskQueue to call \p Callback from \ref execute once
+  /// \p Timeout has passed, even if no task has finished by then.
+  ///
+  /// The timer fires at most once and replaces any timer which was armed
+  /// before; \p Callback may add tasks and arm the timer again. The timer is
+  /// disarmed when \ref execute returns. This has no effect on systems which
+  /// do not support parallel execution.
+  void armTimer(std::chrono::milliseconds Timeout, TimerCallback Callback) {
+    TimerDeadline = std::chrono::steady_clock::now() + Timeout;
+    Timer = std::move(Callback);
+  }
+
   /// \brief Adds a task to the TaskQueue.
   ///
   /// \param ExecPath the path to the executable which the task should execute
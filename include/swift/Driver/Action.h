@@ -136,6 +136,8 @@ public:
     };
     Status status = UpToDate;
     llvm::sys::TimeValue previousModTime;
+    /// How long the last compilation of this input took, or zero if unknown.
+    llvm::sys::TimeValue previousDuration;
 
     InputInfo() = default;
     InputInfo(Status stat, llvm::sys::TimeValue time)
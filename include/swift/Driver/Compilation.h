@@ -132,6 +132,10 @@ private:
   /// rebuilt.
   bool ShowIncrementalBuildDecisions = false;
 
+  /// When true, a new job is not started while the load average leaves no
+  /// free processor for it.
+  bool LimitToSystemLoad = false;
+
   static const Job *unwrap(const std::unique_ptr<const Job> &p) {
     return p.get();
   }
@@ -189,6 +193,10 @@ public:
     ShowIncrementalBuildDecisions = value;
   }
 
+  void setLimitsToSystemLoad(bool value = true) {
+    LimitToSystemLoad = value;
+  }
+
   void setCompilationRecordPath(StringRef path) {
     assert(CompilationRecordPath.empty() && "already set");
     CompilationRecordPath = path;
@@ -80,6 +80,10 @@ private:
   using DependencyMaskTy = OptionSet<DependencyKind>;
   using DependencyFlagsTy = OptionSet<DependencyFlags>;
 
+  /// Identifies a name in the graph. Every name is stored only once, no matter
+  /// how many nodes provide or depend on it.
+  using NameID = unsigned;
+
   struct DependencyEntryTy {
     const void *node;
     DependencyMaskTy kindMask;
@@ -88,11 +92,25 @@ private:
   static_assert(std::is_move_constructible<DependencyEntryTy>::value, "");
 
   struct ProvidesEntryTy {
-    std::string name;
+    NameID name;
     DependencyMaskTy kindMask;
   };
   static_assert(std::is_move_constructible<ProvidesEntryTy>::value, "");
 
+  struct DependentsTy {
+    /// The nodes which depend on the name.
+    std::vector<DependencyEntryTy> nodes;
+    /// The kinds of dependency on the name which have been marked dirty.
+    DependencyMaskTy markedKinds;
+  };
+  static_assert(std::is_move_constructible<DependentsTy>::value, "");
+
+  /// Maps each name in the graph to its ID.
+  llvm::StringMap<NameID> NameIDs;
+
+  /// The names in the graph, indexed by ID. These are owned by NameIDs.
+  std::vector<StringRef> Names;
+
   /// The "outgoing" edge map. This lists all outgoing (kind, string) edges
   /// representing satisfied dependencies from a particular node.
   ///
@@ -107,14 +125,14 @@ private:
   /// well as a flag marking whether that (kind, string) pair has been marked
   /// dirty.
   ///
-  /// The representation is a map from strings to kind mask / node pairs, plus
-  /// a mask of kinds that have been marked dirty. This is because it is
-  /// unusual (though not impossible) for dependencies of different kinds to
-  /// have the same strings. In the case of multiple incoming edges with the
+  /// The representation is indexed by NameID, and holds kind mask / node
+  /// pairs, plus a mask of kinds that have been marked dirty. This is because
+  /// it is unusual (though not impossible) for dependencies of different kinds
+  /// to have the same strings. In the case of multiple incoming edges with the
   /// same string, the kinds are combined into the one field.
   ///
   /// \sa DependencyMaskTy
-  llvm::StringMap<std::pair<std::vector<DependencyEntryTy>, DependencyMaskTy>> Dependencies;
+  std::vector<DependentsTy> Dependencies;
 
   /// The set of marked nodes.
   llvm::SmallPtrSet<const void *, 16> Marked;
@@ -131,6 +149,9 @@ private:
 
   LoadResult loadFromBuffer(const void *node, llvm::MemoryBuffer &buffer);
 
+  /// Returns the ID of \p name, adding it to the graph if necessary.
+  NameID getNameID(StringRef name);
+
   // FIXME: We should be able to use llvm::mapped_iterator for this, but
   // StringMapConstIterator isn't quite an InputIterator (no ->).
   class StringSetIterator {
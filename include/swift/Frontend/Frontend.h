@@ -45,6 +45,7 @@
 
 namespace swift {
 
+class ExpressionTimingReport;
 class SerializedModuleLoader;
 
 /// The abstract configuration of the compiler, including:
@@ -308,6 +309,7 @@ class CompilerInstance {
 
   DependencyTracker *DepTracker = nullptr;
   ReferencedNameTracker *NameTracker = nullptr;
+  ExpressionTimingReport *ExprTimingReport = nullptr;
 
   Module *MainModule = nullptr;
   SerializedModuleLoader *SML = nullptr;
@@ -366,6 +368,14 @@ public:
     return NameTracker;
   }
 
+  void setExpressionTimingReport(ExpressionTimingReport *report) {
+    assert(!PrimarySourceFile && "must be called before performSema()");
+    ExprTimingReport = report;
+  }
+  ExpressionTimingReport *getExpressionTimingReport() {
+    return ExprTimingReport;
+  }
+
   /// Set the SIL module for this compilation instance.
   ///
   /// The CompilerInstance takes ownership of the given SILModule object.
@@ -112,6 +112,10 @@ public:
   /// The path to which we should output a Swift reference dependencies file.
   std::string ReferenceDependenciesFilePath;
 
+  /// Whether the reference dependencies file should be written in the binary
+  /// format rather than as YAML.
+  bool EmitBinaryReferenceDependencies = false;
+
   /// The path to which we should output fixits as source edits.
   std::string FixitsOutputPath;
 
@@ -134,6 +138,12 @@ public:
   /// Intended for debugging purposes only.
   unsigned WarnLongFunctionBodies = 0;
 
+  /// If non-empty, the path to which a JSON report of the expressions which
+  /// took the longest to type-check should be written.
+  ///
+  /// Intended for debugging purposes only.
+  std::string ExpressionTypeCheckReportPath;
+
   enum ActionType {
     NoneAction, ///< No specific action
     Parse, ///< Parse and type-check only
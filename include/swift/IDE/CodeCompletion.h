@@ -800,6 +800,10 @@ public:
   CompletionKind CodeCompletionKind = CompletionKind::None;
   bool HasExpectedTypeRelation = false;
 
+  /// \brief If not empty, the cached module results whose name doesn't start
+  /// with this prefix (ignoring case) may be left out.
+  StringRef ResultNamePrefix;
+
   CodeCompletionContext(CodeCompletionCache &Cache)
       : Cache(Cache) {}
 
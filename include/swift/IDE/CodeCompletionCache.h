@@ -59,7 +59,13 @@ public:
   ~CodeCompletionCache();
 
   static ValueRefCntPtr createValue();
-  Optional<ValueRefCntPtr> get(const Key &K);
+
+  /// Returns the results cached for \p K.
+  ///
+  /// If \p NamePrefix is not empty, the results may be limited to those whose
+  /// name starts with it (ignoring case). Such partial results are never kept
+  /// in memory.
+  Optional<ValueRefCntPtr> get(const Key &K, StringRef NamePrefix = "");
   void set(const Key &K, ValueRefCntPtr V) { setImpl(K, V, /*setChain*/ true); }
 
 private:
@@ -81,10 +87,19 @@ public:
   OnDiskCodeCompletionCache(Twine cacheDirectory);
   ~OnDiskCodeCompletionCache();
 
-  Optional<ValueRefCntPtr> get(const Key &K);
+  /// Reads the results cached for \p K, failing if they are out of date.
+  ///
+  /// If \p namePrefix is not empty, only the results whose name starts with
+  /// it (ignoring case) are read.
+  Optional<ValueRefCntPtr> get(const Key &K, StringRef namePrefix = "");
   std::error_code set(const Key &K, ValueRefCntPtr V);
 
-  static Optional<ValueRefCntPtr> getFromFile(StringRef filename);
+  /// Reads the results cached in \p filename, even if they are out of date.
+  ///
+  /// If \p namePrefix is not empty, only the results whose name starts with
+  /// it (ignoring case) are read.
+  static Optional<ValueRefCntPtr> getFromFile(StringRef filename,
+                                              StringRef namePrefix = "");
 };
 
 struct RequestedCachedModule {
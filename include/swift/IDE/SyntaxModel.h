@@ -23,6 +23,7 @@ namespace swift {
   class Decl;
   class ModuleDecl;
   class SourceFile;
+  class Token;
 
 namespace ide {
 
@@ -184,6 +185,11 @@ class SyntaxModelContext {
 
 public:
   explicit SyntaxModelContext(SourceFile &SrcFile);
+
+  /// Builds the syntax model from tokens that were already lexed from the
+  /// buffer of \p SrcFile, with comments kept and string interpolations
+  /// tokenized.
+  SyntaxModelContext(SourceFile &SrcFile, ArrayRef<Token> Tokens);
   ~SyntaxModelContext();
 
   bool walk(SyntaxModelWalker &Walker);
@@ -12,8 +12,11 @@
 #ifndef SWIFT_RUNTIME_CONCURRENTUTILS_H
 #define SWIFT_RUNTIME_CONCURRENTUTILS_H
 #include <iterator>
+#include <algorithm>
 #include <atomic>
+#include <new>
 #include <stdint.h>
+#include "swift/Runtime/Mutex.h"
 
 #if defined(__FreeBSD__)
 #include <stdio.h>
@@ -123,9 +126,22 @@ template <class ElemTy> struct ConcurrentList {
   std::atomic<ConcurrentListNode<ElemTy> *> First;
 };
 
-/// A concurrent map that is implemented using a binary tree. It supports
-/// concurrent insertions but does not support removals or rebalancing of
-/// the tree.
+/// A concurrent map that is implemented using an open-addressed hash table.
+/// It supports concurrent insertions but does not support removals.
+///
+/// Readers never take a lock and never write to shared memory: a lookup is
+/// a linear probe over an array of (hash, node) slots. Writers are
+/// serialized by a lock that is only taken when a lookup misses. Growing
+/// the table is incremental: a larger table is published immediately and
+/// every subsequent insertion migrates a few slots of the old table into
+/// it, so no single insertion pays for rehashing the whole map. Readers
+/// consult the old table until its migration is complete. Retired tables
+/// are kept alive until the map is destroyed, since a reader may still be
+/// probing them; their total size is bounded by the size of the current
+/// table.
+///
+/// Entries are allocated individually and never move, so pointers returned
+/// by find and getOrInsert remain valid for the lifetime of the map.
 ///
 /// The entry type must provide the following operations:
 ///
@@ -136,80 +152,263 @@ template <class ElemTy> struct ConcurrentList {
 ///   /// to find or getOrInsert.
 ///   int compareWithKey(KeyTy key) const;
 ///
+///   /// Hash a key.  Keys that compare equal must have equal hashes.
+///   static size_t getKeyHash(KeyTy key);
+///
 ///   /// Return the amount of extra trailing space required by an entry,
 ///   /// where KeyTy is the type of the first argument to getOrInsert and
 ///   /// ArgTys is the type of the remaining arguments.
 ///   static size_t getExtraAllocationSize(KeyTy key, ArgTys...)
 template <class EntryTy> class ConcurrentMap {
   struct Node {
-    std::atomic<Node*> Left;
-    std::atomic<Node*> Right;
     EntryTy Payload;
 
     template <class... Args>
-    Node(Args &&... args)
-      : Left(nullptr), Right(nullptr), Payload(std::forward<Args>(args)...) {}
+    Node(Args &&... args) : Payload(std::forward<Args>(args)...) {}
 
     Node(const Node &) = delete;
     Node &operator=(const Node &) = delete;
+  };
+
+  /// A slot in the hash table. The hash is stored inline so that probing
+  /// only dereferences a node whose hash already matches.
+  ///
+  /// A slot is filled exactly once, by a writer holding the lock: the hash
+  /// is stored first and then published by a release store of the node.
+  struct Slot {
+    std::atomic<size_t> Hash;
+    std::atomic<Node*> Ptr;
+
+    Slot() : Hash(0), Ptr(nullptr) {}
+  };
+
+  struct Table {
+    /// The number of slots minus one. The number of slots is a power of 2.
+    size_t Mask;
 
-    ~Node() {
-      // These can be relaxed accesses because there is no safe way for
-      // another thread to race an access to this node with our destruction
-      // of it.
-      ::delete Left.load(std::memory_order_relaxed);
-      ::delete Right.load(std::memory_order_relaxed);
+    /// The table whose entries are being migrated into this one, or null
+    /// once the migration is complete.
+    std::atomic<Table*> Source;
+
+    /// The next table in the list of retired tables.
+    Table *NextRetired;
+
+    explicit Table(size_t capacity)
+      : Mask(capacity - 1), Source(nullptr), NextRetired(nullptr) {
+      for (size_t i = 0; i != capacity; ++i)
+        ::new (&getSlots()[i]) Slot();
     }
 
-#ifndef NDEBUG
-    void dump() const {
-      auto L = Left.load(std::memory_order_acquire);
-      auto R = Right.load(std::memory_order_acquire);
-      printf("\"%p\" [ label = \" {<f0> %08lx | {<f1> | <f2>}}\" "
-             "style=\"rounded\" shape=\"record\"];\n",
-             this, (long) Payload.getKeyValueForDump());
-
-      if (L) {
-        L->dump();
-        printf("\"%p\":f1 -> \"%p\":f0;\n", this, L);
+    Table(const Table &) = delete;
+    Table &operator=(const Table &) = delete;
+
+    size_t getCapacity() const { return Mask + 1; }
+
+    Slot *getSlots() { return reinterpret_cast<Slot*>(this + 1); }
+
+    static Table *allocate(size_t capacity) {
+      void *memory = ::operator new(sizeof(Table) + capacity * sizeof(Slot));
+      return ::new (memory) Table(capacity);
+    }
+
+    static void deallocate(Table *table) {
+      table->~Table();
+      ::operator delete(table);
+    }
+
+    /// Probe for the given key. Safe to call concurrently with insertion.
+    template <class KeyTy>
+    Node *probe(const KeyTy &key, size_t hash) {
+      Slot *slots = getSlots();
+      for (size_t i = hash & Mask; ; i = (i + 1) & Mask) {
+        Node *node = slots[i].Ptr.load(std::memory_order_acquire);
+        if (!node)
+          return nullptr;
+        if (slots[i].Hash.load(std::memory_order_relaxed) == hash &&
+            node->Payload.compareWithKey(key) == 0)
+          return node;
       }
-      if (R) {
-        R->dump();
-        printf("\"%p\":f2 -> \"%p\":f0;\n", this, R);
+    }
+
+    /// Place a node in the first free slot of its probe sequence. Must be
+    /// called with the writer lock held, and the key must not already be
+    /// present in the table.
+    void insert(Node *node, size_t hash) {
+      Slot *slots = getSlots();
+      for (size_t i = hash & Mask; ; i = (i + 1) & Mask) {
+        if (slots[i].Ptr.load(std::memory_order_relaxed))
+          continue;
+        slots[i].Hash.store(hash, std::memory_order_relaxed);
+        slots[i].Ptr.store(node, std::memory_order_release);
+        return;
       }
     }
-#endif
   };
 
-  /// The root of the tree.
-  std::atomic<Node*> Root;
+  /// State that is only accessed by writers, under the lock. It is
+  /// allocated on the first insertion so that a map is just two words and
+  /// all-zero is a valid state.
+  struct WriterState {
+    swift::Mutex Lock;
+
+    /// The number of entries in the map.
+    size_t Count = 0;
+
+    /// The next slot of the current table's source to migrate.
+    size_t MigrationIndex = 0;
+
+    /// Tables that have been fully migrated, but may still be in use by
+    /// concurrent readers.
+    Table *Retired = nullptr;
+  };
+
+  /// The number of slots in the first table allocated.
+  static const size_t InitialCapacity = 16;
+
+  /// The number of source slots migrated by each insertion while a table
+  /// is growing. A table grows when it is 3/4 full, so this is more than
+  /// enough to finish a migration before the next one is needed.
+  static const size_t MigrationBatchSize = 8;
+
+  /// The current table. Insertions always go into this table.
+  std::atomic<Table*> Current;
+
+  /// The writer state, or null if nothing has been inserted yet.
+  std::atomic<WriterState*> Writer;
+
+  template <class KeyTy>
+  static Node *findInTable(Table *table, const KeyTy &key, size_t hash) {
+    // Load the source before probing: if we observe the migration as
+    // complete, everything it moved into this table is visible to us.
+    Table *source = table->Source.load(std::memory_order_acquire);
+    if (Node *node = table->probe(key, hash))
+      return node;
+    if (source)
+      return source->probe(key, hash);
+    return nullptr;
+  }
+
+  WriterState *getWriterState() {
+    WriterState *writer = Writer.load(std::memory_order_acquire);
+    if (writer)
+      return writer;
+
+    auto newWriter = new WriterState();
+    if (std::atomic_compare_exchange_strong_explicit(&Writer, &writer,
+                                                     newWriter,
+                                                     std::memory_order_acq_rel,
+                                                     std::memory_order_acquire))
+      return newWriter;
+
+    // Another thread beat us to it.
+    delete newWriter;
+    return writer;
+  }
+
+  /// Move up to \p count slots of the table's source into it.
+  /// Must be called with the writer lock held.
+  static void migrate(WriterState *writer, Table *table, size_t count) {
+    Table *source = table->Source.load(std::memory_order_relaxed);
+    if (!source)
+      return;
+
+    size_t capacity = source->getCapacity();
+    size_t end = writer->MigrationIndex + std::min(count, capacity);
+    if (end > capacity)
+      end = capacity;
+
+    Slot *slots = source->getSlots();
+    for (size_t i = writer->MigrationIndex; i != end; ++i) {
+      if (Node *node = slots[i].Ptr.load(std::memory_order_relaxed))
+        table->insert(node, slots[i].Hash.load(std::memory_order_relaxed));
+    }
+    writer->MigrationIndex = end;
+
+    if (end == capacity) {
+      source->NextRetired = writer->Retired;
+      writer->Retired = source;
+      table->Source.store(nullptr, std::memory_order_release);
+    }
+  }
+
+  /// Make sure the current table has room for one more entry, and return it.
+  /// Must be called with the writer lock held.
+  Table *prepareForInsertion(WriterState *writer) {
+    Table *table = Current.load(std::memory_order_relaxed);
+    if (!table) {
+      table = Table::allocate(InitialCapacity);
+      Current.store(table, std::memory_order_release);
+      return table;
+    }
+
+    migrate(writer, table, MigrationBatchSize);
+
+    // Keep the load factor at or below 3/4.
+    if ((writer->Count + 1) * 4 <= table->getCapacity() * 3)
+      return table;
 
-  /// This member stores the address of the last node that was found by the
-  /// search procedure. We cache the last search to accelerate code that
-  /// searches the same value in a loop.
-  std::atomic<Node*> LastSearch;
+    // Finish any outstanding migration before starting another one.
+    migrate(writer, table, table->getCapacity());
+
+    Table *newTable = Table::allocate(table->getCapacity() * 2);
+    newTable->Source.store(table, std::memory_order_relaxed);
+    writer->MigrationIndex = 0;
+    Current.store(newTable, std::memory_order_release);
+    return newTable;
+  }
 
 public:
-  constexpr ConcurrentMap() : Root(nullptr), LastSearch(nullptr) {}
+  constexpr ConcurrentMap() : Current(nullptr), Writer(nullptr) {}
 
   ConcurrentMap(const ConcurrentMap &) = delete;
   ConcurrentMap &operator=(const ConcurrentMap &) = delete;
 
   ~ConcurrentMap() {
-    ::delete Root.load(std::memory_order_relaxed);
+    // There is no safe way for another thread to race with our destruction,
+    // so relaxed accesses are fine here.
+    WriterState *writer = Writer.load(std::memory_order_relaxed);
+    Table *table = Current.load(std::memory_order_relaxed);
+    if (table) {
+      // Once the migration is complete, every node is in exactly one slot
+      // of the current table.
+      migrate(writer, table, table->getCapacity());
+      Slot *slots = table->getSlots();
+      for (size_t i = 0, e = table->getCapacity(); i != e; ++i) {
+        if (Node *node = slots[i].Ptr.load(std::memory_order_relaxed)) {
+          node->~Node();
+          ::operator delete(node);
+        }
+      }
+      Table::deallocate(table);
+    }
+    if (writer) {
+      for (Table *retired = writer->Retired; retired; ) {
+        Table *next = retired->NextRetired;
+        Table::deallocate(retired);
+        retired = next;
+      }
+      delete writer;
+    }
   }
 
 #ifndef NDEBUG
   void dump() const {
-    auto R = Root.load(std::memory_order_acquire);
-    printf("digraph g {\n"
-           "graph [ rankdir = \"TB\"];\n"
-           "node  [ fontsize = \"16\" ];\n"
-           "edge  [ ];\n");
-    if (R) {
-      R->dump();
+    auto table = Current.load(std::memory_order_acquire);
+    if (!table) {
+      printf("<empty>\n");
+      return;
+    }
+    Slot *slots = table->getSlots();
+    for (size_t i = 0, e = table->getCapacity(); i != e; ++i) {
+      Node *node = slots[i].Ptr.load(std::memory_order_acquire);
+      if (!node)
+        continue;
+      printf("[%zu] hash %zx key %08lx\n", i,
+             slots[i].Hash.load(std::memory_order_relaxed),
+             (long) node->Payload.getKeyIntValueForDump());
     }
-    printf("\n}\n");
+    if (table->Source.load(std::memory_order_acquire))
+      printf("<migration in progress>\n");
   }
 #endif
 
@@ -217,27 +416,12 @@ public:
   /// \returns a pointer to the value or null if the value is not in the map.
   template <class KeyTy>
   EntryTy *find(const KeyTy &key) {
-    // Check if we are looking for the same key that we looked for in the last
-    // time we called this function.
-    if (Node *last = LastSearch.load(std::memory_order_acquire)) {
-      if (last->Payload.compareWithKey(key) == 0)
-        return &last->Payload;
-    }
-
-    // Search the tree, starting from the root.
-    Node *node = Root.load(std::memory_order_acquire);
-    while (node) {
-      int comparisonResult = node->Payload.compareWithKey(key);
-      if (comparisonResult == 0) {
-        LastSearch.store(node, std::memory_order_release);
-        return &node->Payload;
-      } else if (comparisonResult < 0) {
-        node = node->Left.load(std::memory_order_acquire);
-      } else {
-        node = node->Right.load(std::memory_order_acquire);
-      }
-    }
+    Table *table = Current.load(std::memory_order_acquire);
+    if (!table)
+      return nullptr;
 
+    if (Node *node = findInTable(table, key, EntryTy::getKeyHash(key)))
+      return &node->Payload;
     return nullptr;
   }
 
@@ -247,69 +431,34 @@ public:
   ///   or already existed (false)
   template <class KeyTy, class... ArgTys>
   std::pair<EntryTy*, bool> getOrInsert(KeyTy key, ArgTys &&... args) {
-    // Check if we are looking for the same key that we looked for the
-    // last time we called this function.
-    if (Node *last = LastSearch.load(std::memory_order_acquire)) {
-      if (last && last->Payload.compareWithKey(key) == 0)
-        return { &last->Payload, false };
-    }
-
-    // The node we allocated.
-    Node *newNode = nullptr;
-
-    // Start from the root.
-    auto edge = &Root;
-
-    while (true) {
-      // Load the edge.
-      Node *node = edge->load(std::memory_order_acquire);
-
-      // If there's a node there, it's either a match or we're going to
-      // one of its children.
-      if (node) {
-      searchFromNode:
+    size_t hash = EntryTy::getKeyHash(key);
 
-        // Compare our key against the node's key.
-        int comparisonResult = node->Payload.compareWithKey(key);
-
-        // If it's equal, we can use this node.
-        if (comparisonResult == 0) {
-          // Destroy the node we allocated before if we're carrying one around.
-          ::delete newNode;
+    // Try a lock-free lookup first; the vast majority of calls are hits.
+    if (Table *table = Current.load(std::memory_order_acquire)) {
+      if (Node *node = findInTable(table, key, hash))
+        return { &node->Payload, false };
+    }
 
-          // Cache and report that we found an existing node.
-          LastSearch.store(node, std::memory_order_release);
-          return { &node->Payload, false };
-        }
+    WriterState *writer = getWriterState();
+    swift::ScopedLock guard(writer->Lock);
 
-        // Otherwise, select the appropriate child edge and descend.
-        edge = (comparisonResult < 0 ? &node->Left : &node->Right);
-        continue;
-      }
+    // Search again now that we hold the lock: another thread may have
+    // inserted the key since we last looked.
+    if (Table *table = Current.load(std::memory_order_acquire)) {
+      if (Node *node = findInTable(table, key, hash))
+        return { &node->Payload, false };
+    }
 
-      // Create a new node.
-      if (!newNode) {
-        size_t allocSize =
-          sizeof(Node) + EntryTy::getExtraAllocationSize(key, args...);
-        void *memory = ::operator new(allocSize);
-        newNode = ::new (memory) Node(key, std::forward<ArgTys>(args)...);
-      }
+    Table *table = prepareForInsertion(writer);
 
-      // Try to set the edge to the new node.
-      if (std::atomic_compare_exchange_strong_explicit(edge, &node, newNode,
-                                                  std::memory_order_acq_rel,
-                                                  std::memory_order_acquire)) {
-        // If that succeeded, cache and report that we created a new node.
-        LastSearch.store(newNode, std::memory_order_release);
-        return { &newNode->Payload, true };
-      }
+    size_t allocSize =
+      sizeof(Node) + EntryTy::getExtraAllocationSize(key, args...);
+    void *memory = ::operator new(allocSize);
+    Node *newNode = ::new (memory) Node(key, std::forward<ArgTys>(args)...);
 
-      // Otherwise, we lost the race because some other thread initialized
-      // the edge before us.  node will be set to the current value;
-      // repeat the search from there.
-      assert(node && "spurious failure from compare_exchange_strong?");
-      goto searchFromNode;
-    }
+    table->insert(newNode, hash);
+    ++writer->Count;
+    return { &newNode->Payload, true };
   }
 };
 
@@ -72,6 +72,28 @@
 #error Masking ISAs are incompatible with opaque ISAs
 #endif
 
+/// Does the current Swift platform support C++ thread_local storage for
+/// trivially-constructible values?  Older Apple deployment targets do not,
+/// so code that uses SWIFT_RUNTIME_ATTRIBUTE_THREAD_LOCAL must provide a
+/// fallback.
+#ifndef SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL
+#if defined(__clang__)
+# if __has_feature(cxx_thread_local)
+#  define SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL 1
+# else
+#  define SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL 0
+# endif
+#elif defined(__GNUC__) || defined(_MSC_VER)
+# define SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL 1
+#else
+# define SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL 0
+#endif
+#endif
+
+#if SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL
+# define SWIFT_RUNTIME_ATTRIBUTE_THREAD_LOCAL thread_local
+#endif
+
 // We try to avoid global constructors in the runtime as much as possible.
 // These macros delimit allowed global ctors.
 #if __clang__
@@ -18,5 +18,57 @@
 #define SWIFT_RUNTIME_HEAP_H
 
 #include <llvm/Support/Compiler.h>
+#include <stddef.h>
+#include "swift/Runtime/Config.h"
+
+/// Is the size-class slab allocator available?
+///
+/// With Objective-C interop, Swift objects can be freed by the Objective-C
+/// runtime with free(), so everything must come from malloc. The slab
+/// allocator also relies on thread-local caches.
+#ifndef SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR
+#if !SWIFT_OBJC_INTEROP && !defined(_MSC_VER) && \
+    SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL
+#define SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR 1
+#else
+#define SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR 0
+#endif
+#endif
+
+namespace swift {
+
+#if SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR
+
+/// The largest allocation served by the slab allocator.
+static const size_t SlabAllocatorMaxSize = 256;
+
+/// The alignment of every allocation from the slab allocator.
+static const size_t SlabAllocatorAlignment = 16;
+
+/// Is the slab allocator used by swift_slowAlloc and swift_slowDealloc?
+///
+/// This is decided once per process, by setting the environment variable
+/// SWIFT_RUNTIME_SLAB_ALLOCATOR to 1.
+bool _swift_isSlabAllocatorEnabled();
+
+/// Allocate \p size bytes, which must be at most SlabAllocatorMaxSize, from
+/// the calling thread's size-class cache. Never returns null.
+void *_swift_slabAlloc(size_t size);
+
+/// Return memory allocated by _swift_slabAlloc. \p size must be the size
+/// that was passed when allocating, or the one _swift_slabAllocSize returns.
+void _swift_slabDealloc(void *ptr, size_t size);
+
+/// Returns the usable size of a block allocated by _swift_slabAlloc, which is
+/// the size of its size class, or 0 if \p ptr wasn't allocated by the slab
+/// allocator.
+///
+/// swift_slowDealloc uses this to recognize slab blocks, since the size it is
+/// passed may be smaller than the size that was allocated.
+size_t _swift_slabAllocSize(const void *ptr);
+
+#endif
+
+} // end namespace swift
 
 #endif /* SWIFT_RUNTIME_HEAP_H */
@@ -3443,6 +3443,19 @@ extern "C"
 void swift_registerTypeMetadataRecords(const TypeMetadataRecord *begin,
                                        const TypeMetadataRecord *end);
 
+/// Report the memory used for metadata by each metadata cache.
+///
+/// The callback is invoked once per cache with the name of the cache, the
+/// number of bytes the cache has reserved for metadata, and how many of
+/// those bytes are wasted to fragmentation. Several caches may share a
+/// name; for example, every generic type has its own "GenericCache".
+SWIFT_RUNTIME_EXPORT
+extern "C"
+void swift_enumerateMetadataAllocatorStatistics(
+    void (*callback)(const char *cacheName, size_t bytesReserved,
+                     size_t bytesWasted, void *context),
+    void *context);
+
 /// Return the type name for a given type metadata.
 std::string nameForMetadata(const Metadata *type,
                             bool qualified = true);
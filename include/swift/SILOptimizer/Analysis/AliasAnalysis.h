@@ -18,6 +18,7 @@
 #include "swift/SILOptimizer/Analysis/Analysis.h"
 #include "swift/SILOptimizer/Analysis/SideEffectAnalysis.h"
 #include "llvm/ADT/DenseMap.h"
+#include <memory>
 
 using swift::RetainObserveKind;
 
@@ -102,30 +103,70 @@ private:
   /// never change.
   llvm::DenseMap<TBAACacheKey, bool> TypesMayAliasCache;
 
-  /// AliasAnalysis value cache.
-  ///
-  /// The alias() method uses this map to cache queries.
-  llvm::DenseMap<AliasKeyTy, AliasResult> AliasCache;
-
   using MemoryBehavior = SILInstruction::MemoryBehavior;
-  /// MemoryBehavior value cache.
+
+  /// The alias and memory behavior caches of the queries about the values of
+  /// one function.
   ///
-  /// The computeMemoryBehavior() method uses this map to cache queries.
-  llvm::DenseMap<MemBehaviorKeyTy, MemoryBehavior> MemoryBehaviorCache;
-
-  /// The AliasAnalysis cache can't directly map a pair of ValueBase pointers
-  /// to alias results because we'd like to be able to remove deleted pointers
-  /// without having to scan the whole map. So, instead of storing pointers we
-  /// map pointers to indices and store the indices.
-  ValueEnumerator<ValueBase*> AliasValueBaseToIndex;
-  
-  /// Same as AliasValueBaseToIndex, map a pointer to the indices for
-  /// MemoryBehaviorCache.
+  /// Keeping the caches per function lets the invalidation of a function
+  /// throw away only that function's results. The results for all the other
+  /// functions stay valid, which matters in whole-module optimization.
+  struct FunctionCache {
+    /// AliasAnalysis value cache.
+    ///
+    /// The alias() method uses this map to cache queries.
+    llvm::DenseMap<AliasKeyTy, AliasResult> AliasCache;
+
+    /// MemoryBehavior value cache.
+    ///
+    /// The computeMemoryBehavior() method uses this map to cache queries.
+    llvm::DenseMap<MemBehaviorKeyTy, MemoryBehavior> MemoryBehaviorCache;
+
+    /// The AliasAnalysis cache can't directly map a pair of ValueBase
+    /// pointers to alias results because we'd like to be able to remove
+    /// deleted pointers without having to scan the whole map. So, instead of
+    /// storing pointers we map pointers to indices and store the indices.
+    ValueEnumerator<ValueBase*> AliasValueBaseToIndex;
+
+    /// Same as AliasValueBaseToIndex, map a pointer to the indices for
+    /// MemoryBehaviorCache.
+    ///
+    /// NOTE: we do not use the same ValueEnumerator for the alias cache,
+    /// as when either cache is cleared, we can not clear the ValueEnumerator
+    /// because doing so could give rise to collisions in the other cache.
+    ValueEnumerator<ValueBase*> MemoryBehaviorValueBaseToIndex;
+  };
+
+  /// The caches of the functions queries were made about.
   ///
-  /// NOTE: we do not use the same ValueEnumerator for the alias cache, 
-  /// as when either cache is cleared, we can not clear the ValueEnumerator
-  /// because doing so could give rise to collisions in the other cache.
-  ValueEnumerator<ValueBase*> MemoryBehaviorValueBaseToIndex;
+  /// Queries about values which are not in the same function, or not in any
+  /// function at all, are cached under the null function.
+  llvm::DenseMap<SILFunction *, std::unique_ptr<FunctionCache>> FunctionCaches;
+
+  /// The number of results in all the function caches.
+  size_t NumCachedResults = 0;
+
+  /// Returns the cache for queries about \p V1 and \p V2, creating it if
+  /// needed.
+  FunctionCache &getFunctionCache(SILValue V1, SILValue V2);
+
+  /// Encodes the alias query as a AliasKeyTy.
+  /// The parameters to this function are identical to the parameters of alias()
+  /// and this method serializes them into a key for the alias cache \p FC.
+  AliasKeyTy toAliasKey(FunctionCache &FC, SILValue V1, SILValue V2,
+                        SILType Type1, SILType Type2);
+
+  /// Encodes the memory behavior query as a MemBehaviorKeyTy for the memory
+  /// behavior cache \p FC.
+  MemBehaviorKeyTy toMemoryBehaviorKey(FunctionCache &FC, SILValue V1,
+                                       SILValue V2, RetainObserveKind K);
+
+  /// Drops the caches of \p F.
+  void eraseFunctionCache(SILFunction *F);
+
+  /// Returns the function \p V belongs to, or null if it is not part of a
+  /// function.
+  static SILFunction *getFunctionOf(ValueBase *V);
 
   AliasResult aliasAddressProjection(SILValue V1, SILValue V2,
                                      SILValue O1, SILValue O2);
@@ -141,9 +182,15 @@ private:
   virtual void handleDeleteNotification(ValueBase *I) override {
     // The pointer I is going away.  We can't scan the whole cache and remove
     // all of the occurrences of the pointer. Instead we remove the pointer
-    // from the cache that translates pointers to indices.
-    AliasValueBaseToIndex.invalidateValue(I);
-    MemoryBehaviorValueBaseToIndex.invalidateValue(I);
+    // from the caches that translate pointers to indices. A value is only
+    // ever enumerated by the cache of its own function or the shared one.
+    for (SILFunction *F : { getFunctionOf(I), (SILFunction *)nullptr }) {
+      auto It = FunctionCaches.find(F);
+      if (It == FunctionCaches.end())
+        continue;
+      It->second->AliasValueBaseToIndex.invalidateValue(I);
+      It->second->MemoryBehaviorValueBaseToIndex.invalidateValue(I);
+    }
   }
 
   virtual bool needsNotifications() override { return true; }
@@ -255,23 +302,13 @@ public:
   /// Returns true if \p Ptr may be released by the builtin \p BI.
   bool canBuiltinDecrementRefCount(BuiltinInst *BI, SILValue Ptr);
 
-  /// Encodes the alias query as a AliasKeyTy.
-  /// The parameters to this function are identical to the parameters of alias()
-  /// and this method serializes them into a key for the alias analysis cache.
-  AliasKeyTy toAliasKey(SILValue V1, SILValue V2, SILType Type1, SILType Type2);
-
-  /// Encodes the memory behavior query as a MemBehaviorKeyTy.
-  MemBehaviorKeyTy toMemoryBehaviorKey(SILValue V1, SILValue V2, RetainObserveKind K);
-
   virtual void invalidate(SILAnalysis::InvalidationKind K) override {
-    AliasCache.clear();
-    MemoryBehaviorCache.clear();
+    FunctionCaches.clear();
+    NumCachedResults = 0;
   }
 
-  virtual void invalidate(SILFunction *,
-                          SILAnalysis::InvalidationKind K) override {
-    invalidate(K);
-  }
+  virtual void invalidate(SILFunction *F,
+                          SILAnalysis::InvalidationKind K) override;
 };
 
 
@@ -19,6 +19,7 @@
 
 #include "swift/SILOptimizer/Analysis/Analysis.h"
 #include "swift/SIL/SILInstruction.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 
 namespace swift {
@@ -288,23 +289,38 @@ protected:
   /// Returns the ID of the current update-cycle.
   int getCurrentUpdateID() const { return CurrentUpdateID; }
 
-  /// Invalidates \p FInfo, including all analysis data which depend on it, i.e.
-  /// the callers.
-  template<typename FunctionInfo>
-  void invalidateIncludingAllCallers(FunctionInfo *FInfo) {
+  /// Calls \p Visit for \p FInfo and for all functions whose analysis data
+  /// depend on it, i.e. the callers, transitively.
+  ///
+  /// \p Visit is called for a function after its callers have been looked
+  /// at, so it may invalidate the function.
+  template<typename FunctionInfo, typename VisitorTy>
+  void visitIncludingAllCallers(FunctionInfo *FInfo, VisitorTy Visit) {
     llvm::SmallVector<FunctionInfo *, 8> WorkList;
+    llvm::SmallPtrSet<FunctionInfo *, 8> Visited;
     WorkList.push_back(FInfo);
+    Visited.insert(FInfo);
 
     while (!WorkList.empty()) {
       FunctionInfo *FInfo = WorkList.pop_back_val();
       for (const auto &E : FInfo->Callers) {
-        if (E.isValid() && E.Caller->isValid())
+        if (E.isValid() && E.Caller->isValid() &&
+            Visited.insert(E.Caller).second)
           WorkList.push_back(E.Caller);
       }
+      Visit(FInfo);
+    }
+  }
+
+  /// Invalidates \p FInfo, including all analysis data which depend on it, i.e.
+  /// the callers.
+  template<typename FunctionInfo>
+  void invalidateIncludingAllCallers(FunctionInfo *FInfo) {
+    visitIncludingAllCallers(FInfo, [](FunctionInfo *FInfo) {
       FInfo->clear();
       FInfo->Callers.clear();
       FInfo->UpdateID = 0;
-    }
+    });
   }
 };
 
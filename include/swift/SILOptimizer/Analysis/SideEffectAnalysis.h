@@ -18,6 +18,7 @@
 #include "swift/SILOptimizer/Analysis/BottomUpIPAnalysis.h"
 #include "swift/SILOptimizer/Analysis/ArraySemantic.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallVector.h"
 
@@ -374,6 +375,12 @@ public:
 
   /// Get the side-effects of a call site.
   void getEffects(FunctionEffects &ApplyEffects, FullApplySite FAS);
+
+  /// Calls \p Visit for \p F and for all functions whose side-effects were
+  /// computed from the side-effects of \p F, i.e. its callers, transitively.
+  /// These are the functions invalidate(F) invalidates.
+  void visitIncludingAllCallers(SILFunction *F,
+                                llvm::function_ref<void(SILFunction *)> Visit);
   
   /// No invalidation is needed. See comment for SideEffectAnalysis.
   virtual void invalidate(InvalidationKind K) override;
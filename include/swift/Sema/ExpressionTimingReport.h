@@ -0,0 +1,68 @@
+//===--- ExpressionTimingReport.h - Expression type-checking times -*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a report of the expressions which took the longest to
+// type-check, for finding the expressions that make the solver slow.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SWIFT_SEMA_EXPRESSIONTIMINGREPORT_H
+#define SWIFT_SEMA_EXPRESSIONTIMINGREPORT_H
+
+#include "swift/Basic/LLVM.h"
+#include "swift/Basic/SourceLoc.h"
+#include <vector>
+
+namespace swift {
+
+class SourceManager;
+
+/// Collects the cost of type-checking each expression, across all of the type
+/// checkers used by a compilation.
+class ExpressionTimingReport {
+public:
+  struct Entry {
+    /// The location of the expression.
+    SourceLoc Loc;
+
+    /// The wall time taken to type-check the expression, in milliseconds.
+    double WallTimeMS;
+
+    /// The number of states the constraint solver explored.
+    unsigned StatesExplored;
+
+    /// The memory allocated by the constraint solver, in bytes.
+    size_t SolverMemory;
+
+    /// Whether the solver gave up because the expression was too complex.
+    bool TooComplex;
+  };
+
+private:
+  std::vector<Entry> Entries;
+
+public:
+  void record(const Entry &entry) {
+    Entries.push_back(entry);
+  }
+
+  ArrayRef<Entry> getEntries() const { return Entries; }
+
+  /// Writes the report as JSON, listing at most \p maxEntries of the
+  /// expressions which took the longest to type-check.
+  void writeJSON(raw_ostream &os, SourceManager &SM,
+                 unsigned maxEntries = 100) const;
+};
+
+} // end namespace swift
+
+#endif // SWIFT_SEMA_EXPRESSIONTIMINGREPORT_H
@@ -28,6 +28,9 @@
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
+#include <atomic>
+#include <vector>
 
 namespace llvm {
   class BitstreamCursor;
@@ -138,23 +141,70 @@ private:
   SmallVector<LinkLibrary, 8> LinkLibraries;
 
 public:
+  /// The part of \c Serialized that doesn't depend on the type of the value,
+  /// so that entries of all kinds can be published together.
+  class SerializedBase {
+  protected:
+    /// The opaque value of the entry, either the deserialized value or its
+    /// offset. Only accessed with the deserialization lock held.
+    void *Raw;
+
+    /// The last published copy of \c Raw, which may be read without the
+    /// lock. Entries are only published once the outermost deserialization
+    /// scope that read them ends, so other threads never see a
+    /// partially-deserialized declaration.
+    std::atomic<void *> Published;
+
+    explicit SerializedBase(void *raw) : Raw(raw), Published(raw) {}
+
+    SerializedBase(const SerializedBase &other)
+      : Raw(other.Raw),
+        Published(other.Published.load(std::memory_order_relaxed)) {}
+
+    SerializedBase &operator=(const SerializedBase &other) {
+      Raw = other.Raw;
+      Published.store(other.Published.load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+      return *this;
+    }
+
+  public:
+    void publish() {
+      Published.store(Raw, std::memory_order_release);
+    }
+  };
+
   template <typename T>
-  class Serialized {
+  class Serialized : public SerializedBase {
   private:
     using RawBitOffset = decltype(DeclTypeCursor.GetCurrentBitNo());
 
     using ImplTy = PointerUnion<T, serialization::BitOffset>;
-    ImplTy Value;
+
+    ImplTy getValue() const {
+      return ImplTy::getFromOpaqueValue(Raw);
+    }
 
   public:
-    /*implicit*/ Serialized(serialization::BitOffset offset) : Value(offset) {}
+    /*implicit*/ Serialized(serialization::BitOffset offset)
+      : SerializedBase(ImplTy(offset).getOpaqueValue()) {}
 
     bool isComplete() const {
-      return Value.template is<T>();
+      return getValue().template is<T>();
     }
 
     T get() const {
-      return Value.template get<T>();
+      return getValue().template get<T>();
+    }
+
+    /// Returns the value if it has been published, or a null value if the
+    /// caller has to take the deserialization lock and look again.
+    T getPublished() const {
+      auto published = ImplTy::getFromOpaqueValue(
+          Published.load(std::memory_order_acquire));
+      if (published.template is<T>())
+        return published.template get<T>();
+      return T();
     }
 
     /*implicit*/ operator T() const {
@@ -162,25 +212,52 @@ public:
     }
 
     /*implicit*/ operator serialization::BitOffset() const {
-      return Value.template get<serialization::BitOffset>();
+      return getValue().template get<serialization::BitOffset>();
     }
 
     /*implicit*/ operator RawBitOffset() const {
-      return Value.template get<serialization::BitOffset>();
+      return getValue().template get<serialization::BitOffset>();
     }
 
     template <typename Derived>
     Serialized &operator=(Derived deserialized) {
-      assert(!isComplete() || ImplTy(deserialized) == Value);
-      Value = deserialized;
+      assert(!isComplete() || ImplTy(deserialized) == getValue());
+      Raw = ImplTy(deserialized).getOpaqueValue();
       return *this;
     }
 
     void unsafeOverwrite(T t) {
-      Value = t;
+      Raw = ImplTy(t).getOpaqueValue();
     }
   };
 
+  /// Holds the deserialization lock of the module's ASTContext while
+  /// declarations, types and conformances are read from the module.
+  ///
+  /// Scopes nest, across modules too. Only the outermost scope on a thread
+  /// takes the lock, so reading a declaration that pulls in others costs one
+  /// lock for all of them. Entries passed to \c publishLater are published
+  /// when the outermost scope ends.
+  class DeserializationScope {
+    llvm::sys::Mutex &Mutex;
+
+    /// Whether this scope holds the lock.
+    bool IsOutermost;
+
+    /// The entries to publish, if this is the outermost scope.
+    std::vector<SerializedBase *> Pending;
+
+  public:
+    explicit DeserializationScope(const ModuleFile &MF);
+    ~DeserializationScope();
+
+    DeserializationScope(const DeserializationScope &) = delete;
+    DeserializationScope &operator=(const DeserializationScope &) = delete;
+
+    /// Publishes \p entry once the outermost scope on this thread ends.
+    static void publishLater(SerializedBase &entry);
+  };
+
   /// A class for holding a value that can be partially deserialized.
   ///
   /// This class assumes that "T()" is not a valid deserialized value.
@@ -270,6 +347,57 @@ private:
   /// Identifiers referenced by this module.
   std::vector<SerializedIdentifier> Identifiers;
 
+  /// A table of the comment block, which is only read when it is first looked
+  /// into.
+  ///
+  /// The record and its blob point into the module doc buffer, which is alive
+  /// as long as the ModuleFile. Looking into a table that has been read doesn't
+  /// take the deserialization lock.
+  template <typename Table>
+  class LazyTable {
+    using ReaderTy = std::unique_ptr<Table> (ModuleFile::*)(ArrayRef<uint64_t>,
+                                                            StringRef);
+    ModuleFile *Owner = nullptr;
+    ReaderTy Reader = nullptr;
+    SmallVector<uint64_t, 2> Fields;
+    StringRef BlobData;
+    mutable std::unique_ptr<Table> Owned;
+    mutable std::atomic<Table *> Loaded{nullptr};
+
+  public:
+    /// Remembers where the table is, to read it with \p reader later.
+    void set(ModuleFile *owner, ReaderTy reader, ArrayRef<uint64_t> fields,
+             StringRef blobData) {
+      assert(!isLoaded() && "table has already been read");
+      Owner = owner;
+      Reader = reader;
+      Fields.assign(fields.begin(), fields.end());
+      BlobData = blobData;
+    }
+
+    /// Whether the module has this table at all.
+    explicit operator bool() const { return Reader != nullptr; }
+
+    /// Whether the table has been read.
+    bool isLoaded() const {
+      return Loaded.load(std::memory_order_acquire) != nullptr;
+    }
+
+    Table &operator*() const {
+      assert(Reader && "module does not have this table");
+      if (Table *table = Loaded.load(std::memory_order_acquire))
+        return *table;
+
+      DeserializationScope scope(*Owner);
+      if (!Owned) {
+        Owned = (Owner->*Reader)(Fields, BlobData);
+        Loaded.store(Owned.get(), std::memory_order_release);
+      }
+      return *Owned;
+    }
+    Table *operator->() const { return &**this; }
+  };
+
   class DeclTableInfo;
   using SerializedDeclTable =
       llvm::OnDiskIterableChainedHashTable<DeclTableInfo>;
@@ -306,7 +434,9 @@ private:
 
   using GroupNameTable = llvm::DenseMap<unsigned, StringRef>;
 
-  std::unique_ptr<GroupNameTable> GroupNamesMap;
+  /// Building the group name map walks every group name of the module, and
+  /// it is only needed to print the module's interface.
+  LazyTable<GroupNameTable> GroupNamesMap;
   std::unique_ptr<SerializedDeclCommentTable> DeclCommentTable;
 
   struct {
@@ -42,6 +42,7 @@ namespace swift {
   class DelayedParsingCallbacks;
   class DiagnosticConsumer;
   class DiagnosticEngine;
+  class ExpressionTimingReport;
   class FileUnit;
   class GenericParamList;
   class GenericSignature;
@@ -127,6 +128,24 @@ namespace swift {
                               bool TokenizeInterpolatedString = true,
                               ArrayRef<Token> SplitTokens = ArrayRef<Token>());
 
+  /// \brief Lex and return a vector of tokens for the given buffer, which is
+  /// the result of replacing a range of a buffer that was already tokenized.
+  ///
+  /// Only the lines around the replaced range are lexed again; the tokens
+  /// before and after them are taken from \p OldTokens and moved to the new
+  /// buffer.
+  ///
+  /// \param OldTokens The result of \c tokenize on \p OldText, with comments
+  /// kept and string interpolations tokenized. Their text must still be alive.
+  /// \param EditOffset The offset of the replaced range.
+  /// \param EditOldLength The length of the replaced range in \p OldText.
+  /// \param EditNewLength The length of the text that replaced it.
+  std::vector<Token> retokenize(const LangOptions &LangOpts,
+                                const SourceManager &SM, unsigned BufferID,
+                                ArrayRef<Token> OldTokens, StringRef OldText,
+                                unsigned EditOffset, unsigned EditOldLength,
+                                unsigned EditNewLength);
+
   /// Once parsing is complete, this walks the AST to resolve imports, record
   /// operators, and do other top-level validation.
   ///
@@ -164,10 +183,14 @@ namespace swift {
   ///
   /// \param WarnLongFunctionBodies If non-zero, warn when a function body takes
   /// longer than this many milliseconds to type-check
+  ///
+  /// \param ExprTimingReport If non-null, the cost of type-checking each
+  /// expression is recorded here.
   void performTypeChecking(SourceFile &SF, TopLevelContext &TLC,
                            OptionSet<TypeCheckingFlags> Options,
                            unsigned StartElem = 0,
-                           unsigned WarnLongFunctionBodies = 0);
+                           unsigned WarnLongFunctionBodies = 0,
+                           ExpressionTimingReport *ExprTimingReport = nullptr);
 
   /// Once type checking is complete, this walks protocol requirements
   /// to resolve default witnesses.
@@ -91,6 +91,9 @@ struct ASTContext::Implementation {
   /// The last resolver.
   LazyResolver *Resolver = nullptr;
 
+  /// Serializes reading from the serialized modules of this context.
+  llvm::sys::Mutex DeserializationMutex;
+
   llvm::StringMap<char, llvm::BumpPtrAllocator&> IdentifierTable;
 
   /// The declaration of Swift.AssignmentPrecedence.
@@ -526,6 +529,10 @@ void ASTContext::setLazyResolver(LazyResolver *resolver) {
   }
 }
 
+llvm::sys::Mutex &ASTContext::getDeserializationMutex() const {
+  return Impl.DeserializationMutex;
+}
+
 /// getIdentifier - Return the uniqued and AST-Context-owned version of the
 /// specified string.
 Identifier ASTContext::getIdentifier(StringRef Str) const {
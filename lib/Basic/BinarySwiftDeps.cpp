@@ -0,0 +1,126 @@
+//===--- BinarySwiftDeps.cpp - Binary reference dependencies --------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/BinarySwiftDeps.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace swift;
+using namespace swift::binary_swiftdeps;
+using namespace llvm::support;
+
+/// The size of the header, including the signature.
+static const size_t HeaderSize = sizeof(Signature) + 4 * sizeof(uint32_t);
+
+/// The size of each entry.
+static const size_t EntrySize = sizeof(uint32_t) + 4;
+
+uint32_t Writer::getNameIndex(StringRef name) {
+  auto insertResult =
+    NameIndices.insert(std::make_pair(name, uint32_t(Names.size())));
+  if (insertResult.second)
+    Names.push_back(insertResult.first->getKey());
+  return insertResult.first->getValue();
+}
+
+void Writer::addEntry(Section kind, StringRef name, bool isCascading) {
+  Entries.push_back({getNameIndex(name), kind,
+                     uint8_t(isCascading ? EntryFlags::IsCascading : 0)});
+}
+
+void Writer::write(raw_ostream &out) const {
+  endian::Writer<little> writer(out);
+
+  out.write(Signature, sizeof(Signature));
+  writer.write<uint32_t>(FormatVersion);
+  writer.write<uint32_t>(Entries.size());
+  writer.write<uint32_t>(Names.size());
+  writer.write<uint32_t>(InterfaceHash);
+
+  for (const Entry &entry : Entries) {
+    writer.write<uint32_t>(entry.Name);
+    writer.write<uint8_t>(static_cast<uint8_t>(entry.Kind));
+    writer.write<uint8_t>(entry.Flags);
+    writer.write<uint16_t>(0);
+  }
+
+  uint32_t offset = 0;
+  for (StringRef name : Names) {
+    writer.write<uint32_t>(offset);
+    offset += name.size();
+  }
+  writer.write<uint32_t>(offset);
+
+  for (StringRef name : Names)
+    out << name;
+}
+
+bool binary_swiftdeps::read(
+    StringRef data,
+    llvm::function_ref<void(Section, StringRef, bool)> entryCallback,
+    llvm::function_ref<void(StringRef)> interfaceHashCallback) {
+  if (data.size() < HeaderSize || !hasSignature(data))
+    return true;
+
+  auto *next = reinterpret_cast<const uint8_t *>(data.data()) +
+               sizeof(Signature);
+  uint32_t version = endian::readNext<uint32_t, little, unaligned>(next);
+  uint32_t numEntries = endian::readNext<uint32_t, little, unaligned>(next);
+  uint32_t numNames = endian::readNext<uint32_t, little, unaligned>(next);
+  uint32_t interfaceHash = endian::readNext<uint32_t, little, unaligned>(next);
+  if (version != FormatVersion)
+    return true;
+
+  // Check that the tables fit before looking at any of them.
+  uint64_t stringDataStart = HeaderSize + uint64_t(numEntries) * EntrySize +
+                             (uint64_t(numNames) + 1) * sizeof(uint32_t);
+  if (stringDataStart > data.size())
+    return true;
+
+  auto *entries = next;
+  auto *offsets = entries + numEntries * EntrySize;
+  StringRef stringData = data.substr(stringDataStart);
+
+  auto getName = [&](uint32_t index, StringRef &name) -> bool {
+    if (index >= numNames)
+      return true;
+    auto *offset = offsets + index * sizeof(uint32_t);
+    uint32_t start = endian::readNext<uint32_t, little, unaligned>(offset);
+    uint32_t end = endian::readNext<uint32_t, little, unaligned>(offset);
+    if (start > end || end > stringData.size())
+      return true;
+    name = stringData.slice(start, end);
+    return false;
+  };
+
+  for (uint32_t i = 0; i < numEntries; ++i) {
+    uint32_t nameIndex = endian::readNext<uint32_t, little, unaligned>(next);
+    uint8_t kind = endian::readNext<uint8_t, little, unaligned>(next);
+    uint8_t flags = endian::readNext<uint8_t, little, unaligned>(next);
+    next += sizeof(uint16_t);
+
+    StringRef name;
+    if (kind > static_cast<uint8_t>(LastSection) || getName(nameIndex, name))
+      return true;
+    entryCallback(static_cast<Section>(kind), name,
+                  flags & EntryFlags::IsCascading);
+  }
+
+  if (interfaceHash != NoName) {
+    StringRef hash;
+    if (getName(interfaceHash, hash))
+      return true;
+    interfaceHashCallback(hash);
+  }
+
+  return false;
+}
@@ -35,6 +35,10 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/YAMLParser.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
 using namespace swift;
 using namespace swift::sys;
 using namespace swift::driver;
@@ -83,6 +87,54 @@ namespace {
     ///
     /// Only intended for source files.
     llvm::SmallDenseMap<const Job *, bool, 16> UnfinishedCommands;
+
+    /// When each job that has been handed to the TaskQueue began execution.
+    llvm::SmallDenseMap<const Job *, llvm::sys::TimeValue, 16> StartTimes;
+
+    /// How long each job that finished execution took to run.
+    llvm::SmallDenseMap<const Job *, llvm::sys::TimeValue, 16> Durations;
+  };
+
+  /// Jobs which are ready to run but have not been handed to the TaskQueue.
+  ///
+  /// Jobs which became ready in an earlier scheduling round are run first.
+  /// Within a round, the jobs which are expected to take the longest are run
+  /// first, so that a long job is not left running on its own at the end of
+  /// the build. Ties are broken by the order in which the jobs became ready.
+  class ReadyJobQueue {
+    struct Entry {
+      unsigned Round;
+      uint64_t Cost;
+      unsigned Sequence;
+      const Job *Cmd;
+    };
+
+    std::vector<Entry> Heap;
+    unsigned NextSequence = 0;
+
+    /// The heap comparator: returns true if \p LHS should run after \p RHS.
+    static bool runsAfter(const Entry &LHS, const Entry &RHS) {
+      if (LHS.Round != RHS.Round)
+        return LHS.Round > RHS.Round;
+      if (LHS.Cost != RHS.Cost)
+        return LHS.Cost < RHS.Cost;
+      return LHS.Sequence > RHS.Sequence;
+    }
+
+  public:
+    bool empty() const { return Heap.empty(); }
+
+    void push(const Job *Cmd, unsigned Round, uint64_t Cost) {
+      Heap.push_back({Round, Cost, NextSequence++, Cmd});
+      std::push_heap(Heap.begin(), Heap.end(), runsAfter);
+    }
+
+    const Job *pop() {
+      std::pop_heap(Heap.begin(), Heap.end(), runsAfter);
+      const Job *Cmd = Heap.back().Cmd;
+      Heap.pop_back();
+      return Cmd;
+    }
   };
 }
 
@@ -106,6 +158,18 @@ static const Job *findUnfinishedJob(ArrayRef<const Job *> JL,
 using InputInfoMap =
   llvm::SmallMapVector<const llvm::opt::Arg *, CompileJobAction::InputInfo, 16>;
 
+/// Returns how long the given job took to run in this build or, if it did not
+/// run, in the build before.
+static llvm::sys::TimeValue getLastDuration(const Job *cmd,
+                                            const PerformJobsState &endState) {
+  auto iter = endState.Durations.find(cmd);
+  if (iter != endState.Durations.end())
+    return iter->second;
+  if (auto *compileAction = dyn_cast<CompileJobAction>(&cmd->getSource()))
+    return compileAction->getInputInfo().previousDuration;
+  return llvm::sys::TimeValue();
+}
+
 static void populateInputInfoMap(InputInfoMap &inputs,
                                  const PerformJobsState &endState) {
   for (auto &entry : endState.UnfinishedCommands) {
@@ -114,6 +178,7 @@ static void populateInputInfoMap(InputInfoMap &inputs,
 
       CompileJobAction::InputInfo info;
       info.previousModTime = entry.first->getInputModTime();
+      info.previousDuration = getLastDuration(entry.first, endState);
       info.status = entry.second ?
           CompileJobAction::InputInfo::NeedsCascadingBuild :
           CompileJobAction::InputInfo::NeedsNonCascadingBuild;
@@ -131,6 +196,7 @@ static void populateInputInfoMap(InputInfoMap &inputs,
 
       CompileJobAction::InputInfo info;
       info.previousModTime = entry->getInputModTime();
+      info.previousDuration = getLastDuration(entry, endState);
       info.status = CompileJobAction::InputInfo::UpToDate;
       inputs[&inputFile->getInputArg()] = info;
     }
@@ -213,6 +279,92 @@ static void writeCompilationRecord(StringRef path, StringRef argsHash,
     writeTimeValue(out, entry.second.previousModTime);
     out << "\n";
   }
+
+  // Record how long each input took to compile, so that the next build can
+  // start the longest jobs first.
+  bool wroteDurationsKey = false;
+  for (auto &entry : inputs) {
+    if (entry.second.previousDuration.usec() == 0)
+      continue;
+    if (!wroteDurationsKey) {
+      out << "durations:\n";
+      wroteDurationsKey = true;
+    }
+    out << "  \"" << llvm::yaml::escape(entry.first->getValue()) << "\": ";
+    writeTimeValue(out, entry.second.previousDuration);
+    out << "\n";
+  }
+}
+
+/// Estimates how long each compile job will take to run. Only the relative
+/// order of the estimates is meaningful.
+///
+/// Jobs which ran in the previous build are expected to take as long as they
+/// did then. Other jobs are estimated from the size of their inputs, scaled
+/// by the average speed of the jobs whose duration is known.
+template <typename JobRange>
+static void estimateJobCosts(const JobRange &jobs,
+                             llvm::DenseMap<const Job *, uint64_t> &costs) {
+  SmallVector<std::pair<const Job *, uint64_t>, 16> unknownCosts;
+  uint64_t knownMicroseconds = 0;
+  uint64_t knownBytes = 0;
+
+  for (const Job *cmd : jobs) {
+    auto *compileAction = dyn_cast<CompileJobAction>(&cmd->getSource());
+    if (!compileAction)
+      continue;
+
+    uint64_t inputBytes = 0;
+    for (auto *action : compileAction->getInputs()) {
+      auto *inputFile = dyn_cast<InputAction>(action);
+      if (!inputFile)
+        continue;
+      uint64_t size;
+      if (!llvm::sys::fs::file_size(inputFile->getInputArg().getValue(), size))
+        inputBytes += size;
+    }
+
+    uint64_t duration = compileAction->getInputInfo().previousDuration.usec();
+    if (duration == 0) {
+      unknownCosts.push_back({cmd, inputBytes});
+      continue;
+    }
+
+    costs[cmd] = duration;
+    knownMicroseconds += duration;
+    knownBytes += inputBytes;
+  }
+
+  double microsecondsPerByte = 1.0;
+  if (knownMicroseconds != 0 && knownBytes != 0)
+    microsecondsPerByte = double(knownMicroseconds) / knownBytes;
+  for (auto &entry : unknownCosts)
+    costs[entry.first] = uint64_t(entry.second * microsecondsPerByte);
+}
+
+/// How long to wait before checking the system load again when it kept a
+/// job from starting.
+static const std::chrono::milliseconds LoadRecheckInterval(1000);
+
+/// Returns true if the system is too busy to start another job, given that
+/// \p numRunning jobs of this compilation are already executing and up to
+/// \p maxParallel may execute at once.
+///
+/// The load average includes the jobs of this compilation, so only the load
+/// beyond them counts against the processors available to the build.
+static bool isSystemOverloaded(unsigned numRunning, unsigned maxParallel) {
+#if LLVM_ON_UNIX
+  double loadAverage;
+  if (getloadavg(&loadAverage, 1) != 1)
+    return false;
+
+  static const unsigned numProcessors =
+    std::max(std::thread::hardware_concurrency(), 1U);
+  double otherLoad = std::max(loadAverage - numRunning, 0.0);
+  return otherLoad + numRunning + 1 > std::max(numProcessors, maxParallel);
+#else
+  return false;
+#endif
 }
 
 static bool writeFilelistIfNecessary(const Job *job, DiagnosticEngine &diags) {
@@ -286,6 +438,39 @@ int Compilation::performJobsImpl() {
     });
   };
 
+  // Commands are handed to the TaskQueue only once they can start running,
+  // so that the order in which they run can be chosen as late as possible.
+  ReadyJobQueue ReadyCommands;
+  unsigned NumExecutingCommands = 0;
+  unsigned SchedulingRound = 0;
+
+  // When commands run in parallel, start the ones that are expected to take
+  // the longest first.
+  llvm::DenseMap<const Job *, uint64_t> EstimatedCosts;
+  if (NumberOfParallelCommands > 1)
+    estimateJobCosts(getJobs(), EstimatedCosts);
+
+  // Hand ready commands to the TaskQueue while there are free slots and, if
+  // requested, the system isn't overloaded. At least one command is always
+  // kept running. If the load holds a free slot back, check again after a
+  // while rather than only once another command finishes.
+  std::function<void()> startReadyCommands = [&] {
+    while (!ReadyCommands.empty() &&
+           NumExecutingCommands < NumberOfParallelCommands &&
+           (NumExecutingCommands == 0 || !LimitToSystemLoad ||
+            !isSystemOverloaded(NumExecutingCommands,
+                                NumberOfParallelCommands))) {
+      const Job *Cmd = ReadyCommands.pop();
+      ++NumExecutingCommands;
+      TQ->addTask(Cmd->getExecutable(), Cmd->getArguments(), llvm::None,
+                  (void *)Cmd);
+    }
+
+    if (!ReadyCommands.empty() &&
+        NumExecutingCommands < NumberOfParallelCommands)
+      TQ->armTimer(LoadRecheckInterval, startReadyCommands);
+  };
+
   // Set up scheduleCommandIfNecessaryAndPossible.
   // This will only schedule the given command if it has not been scheduled
   // and if all of its inputs are in FinishedCommands.
@@ -307,8 +492,7 @@ int Compilation::performJobsImpl() {
     assert(Cmd->getExtraEnvironment().empty() &&
            "not implemented for compilations with multiple jobs");
     State.ScheduledCommands.insert(Cmd);
-    TQ->addTask(Cmd->getExecutable(), Cmd->getArguments(), llvm::None,
-                (void *)Cmd);
+    ReadyCommands.push(Cmd, SchedulingRound, EstimatedCosts.lookup(Cmd));
   };
 
   // When a task finishes, we need to reevaluate the other commands that
@@ -379,6 +563,10 @@ int Compilation::performJobsImpl() {
     }
   }
 
+  // Commands found to be out of date from here on run after the ones that
+  // were scheduled initially.
+  ++SchedulingRound;
+
   if (getIncrementalBuildEnabled()) {
     SmallVector<const Job *, 16> AdditionalOutOfDateCommands;
 
@@ -425,9 +613,10 @@ int Compilation::performJobsImpl() {
   // Set up a callback which will be called immediately after a task has
   // started. This callback may be used to provide output indicating that the
   // task began.
-  auto taskBegan = [this] (ProcessId Pid, void *Context) {
+  auto taskBegan = [&] (ProcessId Pid, void *Context) {
     // TODO: properly handle task began.
     const Job *BeganCmd = (const Job *)Context;
+    State.StartTimes[BeganCmd] = llvm::sys::TimeValue::now();
 
     // For verbose output, print out each command as it begins execution.
     if (Level == OutputLevel::Verbose)
@@ -444,6 +633,15 @@ int Compilation::performJobsImpl() {
   auto taskFinished = [&] (ProcessId Pid, int ReturnCode, StringRef Output,
                            void *Context) -> TaskFinishedResponse {
     const Job *FinishedCmd = (const Job *)Context;
+    --NumExecutingCommands;
+    ++SchedulingRound;
+
+    auto StartTime = State.StartTimes.find(FinishedCmd);
+    if (StartTime != State.StartTimes.end()) {
+      State.Durations[FinishedCmd] =
+          llvm::sys::TimeValue::now() - StartTime->second;
+      State.StartTimes.erase(StartTime);
+    }
 
     if (Level == OutputLevel::Parseable) {
       // Parseable output was requested.
@@ -522,6 +720,8 @@ int Compilation::performJobsImpl() {
   auto taskSignalled = [&] (ProcessId Pid, StringRef ErrorMsg, StringRef Output,
                             void *Context) -> TaskFinishedResponse {
     const Job *SignalledCmd = (const Job *)Context;
+    --NumExecutingCommands;
+    State.StartTimes.erase(SignalledCmd);
 
     if (Level == OutputLevel::Parseable) {
       // Parseable output was requested.
@@ -547,9 +747,21 @@ int Compilation::performJobsImpl() {
     return TaskFinishedResponse::StopExecution;
   };
 
+  // Start more commands whenever one finishes and the build goes on.
+  auto taskFinishedAndStartReady =
+      [&] (ProcessId Pid, int ReturnCode, StringRef Output,
+           void *Context) -> TaskFinishedResponse {
+    auto Response = taskFinished(Pid, ReturnCode, Output, Context);
+    if (Response == TaskFinishedResponse::ContinueExecution)
+      startReadyCommands();
+    return Response;
+  };
+
   do {
+    startReadyCommands();
+
     // Ask the TaskQueue to execute.
-    TQ->execute(taskBegan, taskFinished, taskSignalled);
+    TQ->execute(taskBegan, taskFinishedAndStartReady, taskSignalled);
 
     // Mark all remaining deferred commands as skipped.
     for (const Job *Cmd : DeferredCommands) {
@@ -564,7 +776,7 @@ int Compilation::performJobsImpl() {
     }
 
     // ...which may allow us to go on and do later tasks.
-  } while (Result == 0 && TQ->hasRemainingTasks());
+  } while (Result == 0 && !ReadyCommands.empty());
 
   if (Result == 0) {
     assert(State.BlockingCommands.empty() &&
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "swift/Driver/DependencyGraph.h"
+#include "swift/Basic/BinarySwiftDeps.h"
 #include "swift/Basic/DemangleWrappers.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
@@ -49,6 +50,82 @@ using DependencyKind = DependencyGraphImpl::DependencyKind;
 using DependencyCallbackTy = LoadResult(StringRef, DependencyKind, bool);
 using InterfaceHashCallbackTy = LoadResult(StringRef);
 
+/// Reads a dependency file in the binary format, whose entries refer to the
+/// file's contents directly.
+static LoadResult
+parseBinaryDependencyFile(StringRef data,
+                          llvm::function_ref<DependencyCallbackTy> providesCallback,
+                          llvm::function_ref<DependencyCallbackTy> dependsCallback,
+                          llvm::function_ref<InterfaceHashCallbackTy> interfaceHashCallback) {
+  using binary_swiftdeps::Section;
+
+  LoadResult result = LoadResult::UpToDate;
+  auto updateResult = [&result](LoadResult update) {
+    if (result != LoadResult::HadError && update != LoadResult::UpToDate)
+      result = update;
+  };
+
+  auto entryCallback = [&](Section section, StringRef name, bool isCascading) {
+    DependencyKind kind;
+    bool isDepends;
+    switch (section) {
+    case Section::ProvidesTopLevel:
+      kind = DependencyKind::TopLevelName;
+      isDepends = false;
+      break;
+    case Section::ProvidesNominal:
+      kind = DependencyKind::NominalType;
+      isDepends = false;
+      break;
+    case Section::ProvidesMember:
+      kind = DependencyKind::NominalTypeMember;
+      isDepends = false;
+      break;
+    case Section::ProvidesDynamicLookup:
+      kind = DependencyKind::DynamicLookupName;
+      isDepends = false;
+      break;
+    case Section::DependsTopLevel:
+      kind = DependencyKind::TopLevelName;
+      isDepends = true;
+      break;
+    case Section::DependsNominal:
+      kind = DependencyKind::NominalType;
+      isDepends = true;
+      break;
+    case Section::DependsMember:
+      kind = DependencyKind::NominalTypeMember;
+      isDepends = true;
+      break;
+    case Section::DependsDynamicLookup:
+      kind = DependencyKind::DynamicLookupName;
+      isDepends = true;
+      break;
+    case Section::DependsExternal:
+      kind = DependencyKind::ExternalFile;
+      isDepends = true;
+      break;
+    }
+
+    // Nothing provides things privately.
+    if (!isDepends && !isCascading) {
+      updateResult(LoadResult::HadError);
+      return;
+    }
+
+    auto &callback = isDepends ? dependsCallback : providesCallback;
+    updateResult(callback(name, kind, isCascading));
+  };
+
+  auto hashCallback = [&](StringRef hash) {
+    updateResult(interfaceHashCallback(hash));
+  };
+
+  if (binary_swiftdeps::read(data, entryCallback, hashCallback))
+    return LoadResult::HadError;
+  return result;
+}
+
 static LoadResult
 parseDependencyFile(llvm::MemoryBuffer &buffer,
                     llvm::function_ref<DependencyCallbackTy> providesCallback,
@@ -56,6 +133,10 @@ parseDependencyFile(llvm::MemoryBuffer &buffer,
                     llvm::function_ref<InterfaceHashCallbackTy> interfaceHashCallback) {
   namespace yaml = llvm::yaml;
 
+  if (binary_swiftdeps::hasSignature(buffer.getBuffer()))
+    return parseBinaryDependencyFile(buffer.getBuffer(), providesCallback,
+                                     dependsCallback, interfaceHashCallback);
+
   // FIXME: Switch to a format other than YAML.
   llvm::SourceMgr SM;
   yaml::Stream stream(buffer.getMemBufferRef(), SM);
@@ -219,6 +300,16 @@ DependencyGraphImpl::loadFromString(const void *node, StringRef data) {
   return loadFromBuffer(node, *buffer);
 }
 
+DependencyGraphImpl::NameID DependencyGraphImpl::getNameID(StringRef name) {
+  auto insertResult =
+    NameIDs.insert(std::make_pair(name, NameID(Names.size())));
+  if (insertResult.second) {
+    Names.push_back(insertResult.first->getKey());
+    Dependencies.emplace_back();
+  }
+  return insertResult.first->getValue();
+}
+
 LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
                                                llvm::MemoryBuffer &buffer) {
   auto &provides = Provides[node];
@@ -228,8 +319,8 @@ LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
     if (kind == DependencyKind::ExternalFile)
       ExternalDependencies.insert(name);
 
-    auto &entries = Dependencies[name];
-    auto iter = std::find_if(entries.first.begin(), entries.first.end(),
+    auto &entries = Dependencies[getNameID(name)];
+    auto iter = std::find_if(entries.nodes.begin(), entries.nodes.end(),
                              [node](const DependencyEntryTy &entry) -> bool {
       return node == entry.node;
     });
@@ -238,14 +329,14 @@ LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
     if (isCascading)
       flags |= DependencyFlags::IsCascading;
 
-    if (iter == entries.first.end()) {
-      entries.first.push_back({node, kind, flags});
+    if (iter == entries.nodes.end()) {
+      entries.nodes.push_back({node, kind, flags});
     } else {
       iter->kindMask |= kind;
       iter->flags |= flags;
     }
 
-    if (isCascading && (entries.second & kind))
+    if (isCascading && (entries.markedKinds & kind))
       return LoadResult::AffectsDownstream;
     return LoadResult::UpToDate;
   };
@@ -254,13 +345,14 @@ LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
       [this, node, &provides](StringRef name, DependencyKind kind,
                               bool isCascading) -> LoadResult {
     assert(isCascading);
+    NameID nameID = getNameID(name);
     auto iter = std::find_if(provides.begin(), provides.end(),
-                             [name](const ProvidesEntryTy &entry) -> bool {
-      return name == entry.name;
+                             [nameID](const ProvidesEntryTy &entry) -> bool {
+      return nameID == entry.name;
     });
 
     if (iter == provides.end())
-      provides.push_back({name, kind});
+      provides.push_back({nameID, kind});
     else
       iter->kindMask |= kind;
 
@@ -291,11 +383,12 @@ LoadResult DependencyGraphImpl::loadFromBuffer(const void *node,
 
 void DependencyGraphImpl::markExternal(SmallVectorImpl<const void *> &visited,
                                        StringRef externalDependency) {
-  auto allDependents = Dependencies.find(externalDependency);
-  assert(allDependents != Dependencies.end() && "not a dependency!");
-  allDependents->second.second |= DependencyKind::ExternalFile;
+  auto nameID = NameIDs.find(externalDependency);
+  assert(nameID != NameIDs.end() && "not a dependency!");
+  auto &allDependents = Dependencies[nameID->getValue()];
+  allDependents.markedKinds |= DependencyKind::ExternalFile;
 
-  for (const auto &dependent : allDependents->second.first) {
+  for (const auto &dependent : allDependents.nodes) {
     if (!dependent.kindMask.contains(DependencyKind::ExternalFile))
       continue;
     if (isMarked(dependent.node))
@@ -328,17 +421,17 @@ DependencyGraphImpl::markTransitive(SmallVectorImpl<const void *> &visited,
       return;
 
     for (const auto &provided : allProvided->second) {
-      auto allDependents = Dependencies.find(provided.name);
-      if (allDependents == Dependencies.end())
+      auto &allDependents = Dependencies[provided.name];
+      if (allDependents.nodes.empty())
         continue;
 
-      if (allDependents->second.second.contains(provided.kindMask))
+      if (allDependents.markedKinds.contains(provided.kindMask))
         continue;
 
       // Record that we've traversed this dependency.
-      allDependents->second.second |= provided.kindMask;
+      allDependents.markedKinds |= provided.kindMask;
 
-      for (const auto &dependent : allDependents->second.first) {
+      for (const auto &dependent : allDependents.nodes) {
         if (dependent.node == next)
           continue;
         auto intersectingKinds = provided.kindMask & dependent.kindMask;
@@ -353,7 +446,8 @@ DependencyGraphImpl::markTransitive(SmallVectorImpl<const void *> &visited,
           newReason = {scratchAlloc.Allocate(reason.size()+1), reason.size()+1};
           std::uninitialized_copy(reason.begin(), reason.end(),
                                   newReason.begin());
-          new (&newReason.back()) MarkTracerImpl::Entry({next, provided.name,
+          new (&newReason.back()) MarkTracerImpl::Entry({next,
+                                                         Names[provided.name],
                                                          intersectingKinds});
         }
         worklist.push_back({ newReason, dependent.node, isCascading });
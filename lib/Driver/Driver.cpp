@@ -215,6 +215,7 @@ static bool populateOutOfDateMap(InputInfoMap &map, StringRef argsHashStr,
   SmallString<64> scratch;
 
   llvm::StringMap<InputInfo> previousInputs;
+  llvm::StringMap<llvm::sys::TimeValue> previousDurations;
   bool versionValid = false;
   bool optionsMatch = true;
 
@@ -316,9 +317,36 @@ static bool populateOutOfDateMap(InputInfoMap &map, StringRef argsHashStr,
         auto inputName = key->getValue(scratch);
         previousInputs[inputName] = { *previousBuildState, timeValue };
       }
+
+    } else if (keyStr == "durations") {
+      auto *durationMap = dyn_cast<yaml::MappingNode>(i->getValue());
+      if (!durationMap)
+        return true;
+
+      // FIXME: LLVM's YAML support does incremental parsing in such a way that
+      // for-range loops break.
+      for (auto i = durationMap->begin(), e = durationMap->end(); i != e; ++i) {
+        auto *key = dyn_cast<yaml::ScalarNode>(i->getKey());
+        if (!key)
+          return true;
+
+        llvm::sys::TimeValue duration;
+        if (readTimeValue(i->getValue(), duration))
+          return true;
+
+        previousDurations[key->getValue(scratch)] = duration;
+      }
     }
   }
 
+  // Durations are only used to decide which jobs to start first, so they
+  // don't have to match up with the inputs.
+  for (auto &entry : previousDurations) {
+    auto iter = previousInputs.find(entry.getKey());
+    if (iter != previousInputs.end())
+      iter->getValue().previousDuration = entry.getValue();
+  }
+
   if (!versionValid || !optionsMatch)
     return true;
 
@@ -360,6 +388,8 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
     ArgList->hasArg(options::OPT_driver_skip_execution);
   bool ShowIncrementalBuildDecisions =
     ArgList->hasArg(options::OPT_driver_show_incremental);
+  bool LimitToSystemLoad =
+    ArgList->hasArg(options::OPT_driver_limit_to_system_load);
 
   bool Incremental = ArgList->hasArg(options::OPT_incremental) &&
     !ArgList->hasArg(options::OPT_whole_module_optimization) &&
@@ -514,6 +544,9 @@ std::unique_ptr<Compilation> Driver::buildCompilation(
   if (ShowIncrementalBuildDecisions)
     C->setShowsIncrementalBuildDecisions();
 
+  if (LimitToSystemLoad)
+    C->setLimitsToSystemLoad();
+
   // This has to happen after building jobs, because otherwise we won't even
   // emit .swiftdeps files for the next build.
   if (rebuildEverything)
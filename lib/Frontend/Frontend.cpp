@@ -498,7 +498,8 @@ void CompilerInstance::performSema() {
       if (mainIsPrimary) {
         performTypeChecking(MainFile, PersistentState.getTopLevelContext(),
                             TypeCheckOptions, CurTUElem,
-                            options.WarnLongFunctionBodies);
+                            options.WarnLongFunctionBodies,
+                            ExprTimingReport);
       }
       CurTUElem = MainFile.Decls.size();
     } while (!Done);
@@ -518,7 +519,8 @@ void CompilerInstance::performSema() {
       if (PrimaryBufferID == NO_SUCH_BUFFER || SF == PrimarySourceFile)
         performTypeChecking(*SF, PersistentState.getTopLevelContext(),
                             TypeCheckOptions, /*curElem*/0,
-                            options.WarnLongFunctionBodies);
+                            options.WarnLongFunctionBodies,
+                            ExprTimingReport);
 
   // Even if there were no source files, we should still record known
   // protocols.
@@ -30,6 +30,7 @@
 #include "swift/AST/NameLookup.h"
 #include "swift/AST/ReferencedNameTracker.h"
 #include "swift/AST/TypeRefinementContext.h"
+#include "swift/Basic/BinarySwiftDeps.h"
 #include "swift/Basic/Dwarf.h"
 #include "swift/Basic/Fallthrough.h"
 #include "swift/Basic/FileSystem.h"
@@ -42,6 +43,7 @@
 #include "swift/Immediate/Immediate.h"
 #include "swift/Option/Options.h"
 #include "swift/PrintAsObjC/PrintAsObjC.h"
+#include "swift/Sema/ExpressionTimingReport.h"
 #include "swift/Serialization/SerializationOptions.h"
 #include "swift/SILOptimizer/PassManager/Passes.h"
 
@@ -180,6 +182,87 @@ static std::string mangleTypeAsContext(const NominalTypeDecl *type) {
   return mangler.finalize();
 }
 
+namespace {
+/// Writes the entries of a Swift-style dependencies file, either as YAML or
+/// in the binary format described in BinarySwiftDeps.h.
+class ReferenceDependencyWriter {
+  raw_ostream &out;
+  Optional<binary_swiftdeps::Writer> binaryWriter;
+  binary_swiftdeps::Section section = binary_swiftdeps::Section();
+
+  static StringRef getSectionKey(binary_swiftdeps::Section section) {
+    using binary_swiftdeps::Section;
+    switch (section) {
+    case Section::ProvidesTopLevel: return "provides-top-level";
+    case Section::ProvidesNominal: return "provides-nominal";
+    case Section::ProvidesMember: return "provides-member";
+    case Section::ProvidesDynamicLookup: return "provides-dynamic-lookup";
+    case Section::DependsTopLevel: return "depends-top-level";
+    case Section::DependsNominal: return "depends-nominal";
+    case Section::DependsMember: return "depends-member";
+    case Section::DependsDynamicLookup: return "depends-dynamic-lookup";
+    case Section::DependsExternal: return "depends-external";
+    }
+    llvm_unreachable("unhandled section");
+  }
+
+public:
+  ReferenceDependencyWriter(raw_ostream &out, bool binary) : out(out) {
+    if (binary)
+      binaryWriter.emplace();
+    else
+      out << "### Swift dependencies file v0 ###\n";
+  }
+
+  /// Starts the list of entries of the given kind.
+  void beginSection(binary_swiftdeps::Section newSection) {
+    section = newSection;
+    if (!binaryWriter)
+      out << getSectionKey(section) << ":\n";
+  }
+
+  void addName(StringRef name, bool isCascading = true) {
+    if (binaryWriter) {
+      binaryWriter->addEntry(section, name, isCascading);
+      return;
+    }
+    out << "- ";
+    if (!isCascading)
+      out << "!private ";
+    out << "\"" << llvm::yaml::escape(name) << "\"\n";
+  }
+
+  void addMember(StringRef mangledTypeName, StringRef memberName,
+                 bool isCascading = true) {
+    if (binaryWriter) {
+      SmallString<64> key{mangledTypeName};
+      key.push_back('\0');
+      key += memberName;
+      binaryWriter->addEntry(section, key, isCascading);
+      return;
+    }
+    out << "- ";
+    if (!isCascading)
+      out << "!private ";
+    out << "[\"" << llvm::yaml::escape(mangledTypeName) << "\", \""
+        << llvm::yaml::escape(memberName) << "\"]\n";
+  }
+
+  void setInterfaceHash(StringRef hash) {
+    if (binaryWriter)
+      binaryWriter->setInterfaceHash(hash);
+    else
+      out << "interface-hash: \"" << hash << "\"\n";
+  }
+
+  /// Writes out any entries which have not been written yet.
+  void finish() {
+    if (binaryWriter)
+      binaryWriter->write(out);
+  }
+};
+} // end anonymous namespace
+
 /// Emits a Swift-style dependencies file.
 static bool emitReferenceDependencies(DiagnosticEngine &diags,
                                       SourceFile *SF,
@@ -202,16 +285,13 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
     return true;
   }
 
-  auto escape = [](Identifier name) -> std::string {
-    return llvm::yaml::escape(name.str());
-  };
-
-  out << "### Swift dependencies file v0 ###\n";
+  using binary_swiftdeps::Section;
+  ReferenceDependencyWriter writer(out, opts.EmitBinaryReferenceDependencies);
 
   llvm::MapVector<const NominalTypeDecl *, bool> extendedNominals;
   llvm::SmallVector<const ExtensionDecl *, 8> extensionsWithJustMembers;
 
-  out << "provides-top-level:\n";
+  writer.beginSection(Section::ProvidesTopLevel);
   for (const Decl *D : SF->Decls) {
     switch (D->getKind()) {
     case DeclKind::Module:
@@ -250,11 +330,11 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
     case DeclKind::InfixOperator:
     case DeclKind::PrefixOperator:
     case DeclKind::PostfixOperator:
-      out << "- \"" << escape(cast<OperatorDecl>(D)->getName()) << "\"\n";
+      writer.addName(cast<OperatorDecl>(D)->getName().str());
       break;
 
     case DeclKind::PrecedenceGroup:
-      out << "- \"" << escape(cast<PrecedenceGroupDecl>(D)->getName()) << "\"\n";
+      writer.addName(cast<PrecedenceGroupDecl>(D)->getName().str());
       break;
 
     case DeclKind::Enum:
@@ -268,7 +348,7 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
           NTD->getFormalAccess() <= Accessibility::FilePrivate) {
         break;
       }
-      out << "- \"" << escape(NTD->getName()) << "\"\n";
+      writer.addName(NTD->getName().str());
       extendedNominals[NTD] |= true;
       findNominals(extendedNominals, NTD->getMembers());
       break;
@@ -284,7 +364,7 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
           VD->getFormalAccess() <= Accessibility::FilePrivate) {
         break;
       }
-      out << "- \"" << escape(VD->getName()) << "\"\n";
+      writer.addName(VD->getName().str());
       break;
     }
 
@@ -306,21 +386,16 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
     }
   }
 
-  out << "provides-nominal:\n";
+  writer.beginSection(Section::ProvidesNominal);
   for (auto entry : extendedNominals) {
     if (!entry.second)
       continue;
-    out << "- \"";
-    out << mangleTypeAsContext(entry.first);
-    out << "\"\n";
+    writer.addName(mangleTypeAsContext(entry.first));
   }
 
-  out << "provides-member:\n";
-  for (auto entry : extendedNominals) {
-    out << "- [\"";
-    out << mangleTypeAsContext(entry.first);
-    out << "\", \"\"]\n";
-  }
+  writer.beginSection(Section::ProvidesMember);
+  for (auto entry : extendedNominals)
+    writer.addMember(mangleTypeAsContext(entry.first), "");
 
   // This is also part of "provides-member".
   for (auto *ED : extensionsWithJustMembers) {
@@ -333,8 +408,7 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
           VD->getFormalAccess() <= Accessibility::FilePrivate) {
         continue;
       }
-      out << "- [\"" << mangledName << "\", \""
-          << escape(VD->getName()) << "\"]\n";
+      writer.addMember(mangledName, VD->getName().str());
     }
   }
 
@@ -342,36 +416,32 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
     // FIXME: This requires a traversal of the whole file to compute.
     // We should (a) see if there's a cheaper way to keep it up to date,
     // and/or (b) see if we can fast-path cases where there's no ObjC involved.
-    out << "provides-dynamic-lookup:\n";
+    writer.beginSection(Section::ProvidesDynamicLookup);
     class ValueDeclPrinter : public VisibleDeclConsumer {
     private:
-      raw_ostream &out;
-      std::string (*escape)(Identifier);
+      ReferenceDependencyWriter &writer;
     public:
-      ValueDeclPrinter(raw_ostream &out, decltype(escape) escape)
-        : out(out), escape(escape) {}
+      explicit ValueDeclPrinter(ReferenceDependencyWriter &writer)
+        : writer(writer) {}
 
       void foundDecl(ValueDecl *VD, DeclVisibilityKind Reason) override {
-        out << "- \"" << escape(VD->getName()) << "\"\n";
+        writer.addName(VD->getName().str());
       }
     };
-    ValueDeclPrinter printer(out, escape);
+    ValueDeclPrinter printer(writer);
     SF->lookupClassMembers({}, printer);
   }
 
   ReferencedNameTracker *tracker = SF->getReferencedNameTracker();
 
   // FIXME: Sort these?
-  out << "depends-top-level:\n";
+  writer.beginSection(Section::DependsTopLevel);
   for (auto &entry : tracker->getTopLevelNames()) {
     assert(!entry.first.empty());
-    out << "- ";
-    if (!entry.second)
-      out << "!private ";
-    out << "\"" << escape(entry.first) << "\"\n";
+    writer.addName(entry.first.str(), entry.second);
   }
 
-  out << "depends-member:\n";
+  writer.beginSection(Section::DependsMember);
   auto &memberLookupTable = tracker->getUsedMembers();
   using TableEntryTy = std::pair<ReferencedNameTracker::MemberPair, bool>;
   std::vector<TableEntryTy> sortedMembers{
@@ -398,18 +468,14 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
         entry.first.first->getFormalAccess() <= Accessibility::FilePrivate)
       continue;
 
-    out << "- ";
-    if (!entry.second)
-      out << "!private ";
-    out << "[\"";
-    out << mangleTypeAsContext(entry.first.first);
-    out << "\", \"";
+    StringRef memberName;
     if (!entry.first.second.empty())
-      out << escape(entry.first.second);
-    out << "\"]\n";
+      memberName = entry.first.second.str();
+    writer.addMember(mangleTypeAsContext(entry.first.first), memberName,
+                     entry.second);
   }
 
-  out << "depends-nominal:\n";
+  writer.beginSection(Section::DependsNominal);
   for (auto i = sortedMembers.begin(), e = sortedMembers.end(); i != e; ++i) {
     bool isCascading = i->second;
     while (i+1 != e && i[0].first.first == i[1].first.first) {
@@ -421,36 +487,49 @@ static bool emitReferenceDependencies(DiagnosticEngine &diags,
         i->first.first->getFormalAccess() <= Accessibility::FilePrivate)
       continue;
 
-    out << "- ";
-    if (!isCascading)
-      out << "!private ";
-    out << "\"";
-    out <<  mangleTypeAsContext(i->first.first);
-    out << "\"\n";
+    writer.addName(mangleTypeAsContext(i->first.first), isCascading);
   }
 
   // FIXME: Sort these?
-  out << "depends-dynamic-lookup:\n";
+  writer.beginSection(Section::DependsDynamicLookup);
   for (auto &entry : tracker->getDynamicLookupNames()) {
     assert(!entry.first.empty());
-    out << "- ";
-    if (!entry.second)
-      out << "!private ";
-    out << "\"" << escape(entry.first) << "\"\n";
+    writer.addName(entry.first.str(), entry.second);
   }
 
-  out << "depends-external:\n";
-  for (auto &entry : depTracker.getDependencies()) {
-    out << "- \"" << llvm::yaml::escape(entry) << "\"\n";
-  }
+  writer.beginSection(Section::DependsExternal);
+  for (auto &entry : depTracker.getDependencies())
+    writer.addName(entry);
 
   llvm::SmallString<32> interfaceHash;
   SF->getInterfaceHash(interfaceHash);
-  out << "interface-hash: \"" << interfaceHash << "\"\n";
+  writer.setInterfaceHash(interfaceHash);
+  writer.finish();
 
   return false;
 }
 
+/// Writes out the report of the expressions which took the longest to
+/// type-check.
+static bool emitExpressionTimingReport(DiagnosticEngine &diags,
+                                       SourceManager &SM,
+                                       const ExpressionTimingReport &report,
+                                       const FrontendOptions &opts) {
+  std::error_code EC;
+  llvm::raw_fd_ostream out(opts.ExpressionTypeCheckReportPath, EC,
+                           llvm::sys::fs::F_None);
+
+  if (out.has_error() || EC) {
+    diags.diagnose(SourceLoc(), diag::error_opening_output,
+                   opts.ExpressionTypeCheckReportPath, EC.message());
+    out.clear_error();
+    return true;
+  }
+
+  report.writeJSON(out, SM);
+  return false;
+}
+
 /// Writes SIL out to the given file.
 static bool writeSIL(SILModule &SM, Module *M, bool EmitVerboseSIL,
                      StringRef OutputFilename, bool SortSIL) {
@@ -701,6 +780,10 @@ static bool performCompile(CompilerInstance &Instance,
   if (shouldTrackReferences)
     Instance.setReferencedNameTracker(&nameTracker);
 
+  ExpressionTimingReport exprTimingReport;
+  if (!opts.ExpressionTypeCheckReportPath.empty())
+    Instance.setExpressionTimingReport(&exprTimingReport);
+
   if (Action == FrontendOptions::DumpParse ||
       Action == FrontendOptions::DumpInterfaceHash)
     Instance.performParseOnly();
@@ -763,6 +846,10 @@ static bool performCompile(CompilerInstance &Instance,
     emitReferenceDependencies(Context.Diags, Instance.getPrimarySourceFile(),
                               *Instance.getDependencyTracker(), opts);
 
+  if (!opts.ExpressionTypeCheckReportPath.empty())
+    (void)emitExpressionTimingReport(Context.Diags, Instance.getSourceMgr(),
+                                     exprTimingReport, opts);
+
   if (Context.hadError())
     return true;
 
@@ -2,6 +2,7 @@
 #include "swift/Basic/Cache.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -38,7 +39,7 @@ CodeCompletionCache::ValueRefCntPtr CodeCompletionCache::createValue() {
 }
 
 Optional<CodeCompletionCache::ValueRefCntPtr>
-CodeCompletionCache::get(const Key &K) {
+CodeCompletionCache::get(const Key &K, StringRef NamePrefix) {
   auto &TheCache = Impl->TheCache;
   llvm::Optional<ValueRefCntPtr> V = TheCache.get(K);
   if (V) {
@@ -51,9 +52,11 @@ CodeCompletionCache::get(const Key &K) {
       V = None;
       TheCache.remove(K);
     }
-  } else if (nextCache && (V = nextCache->get(K))) {
-    // Hit the chained cache. Update our own cache to match.
-    setImpl(K, *V, /*setChain*/ false);
+  } else if (nextCache && (V = nextCache->get(K, NamePrefix))) {
+    // Hit the chained cache. Update our own cache to match, unless we only
+    // read some of the results.
+    if (NamePrefix.empty())
+      setImpl(K, *V, /*setChain*/ false);
   }
   return V;
 }
@@ -88,13 +91,7 @@ CodeCompletionCache::~CodeCompletionCache() {}
 ///
 /// This should be incremented any time we commit a change to the format of the
 /// cached results. This isn't expected to change very often.
-static constexpr uint32_t onDiskCompletionCacheVersion = 0;
-
-static StringRef copyString(llvm::BumpPtrAllocator &Allocator, StringRef Str) {
-  char *Mem = Allocator.Allocate<char>(Str.size());
-  std::copy(Str.begin(), Str.end(), Mem);
-  return StringRef(Mem, Str.size());
-}
+static constexpr uint32_t onDiskCompletionCacheVersion = 1;
 
 static ArrayRef<StringRef> copyStringArray(llvm::BumpPtrAllocator &Allocator,
                                            ArrayRef<StringRef> Arr) {
@@ -113,11 +110,18 @@ static ArrayRef<std::pair<StringRef, StringRef>> copyStringPairArray(
 }
 
 /// Deserializes CodeCompletionResults from \p in and stores them in \p V.
+///
+/// If \p namePrefix is not empty, only the results whose name starts with it
+/// (ignoring case) are read, using the name index of the file.
+///
+/// Strings are not copied out of \p in; instead the allocator of \p V keeps
+/// the buffer alive.
 /// \see writeCacheModule.
-static bool readCachedModule(llvm::MemoryBuffer *in,
+static bool readCachedModule(std::unique_ptr<llvm::MemoryBuffer> in,
                              const CodeCompletionCache::Key &K,
                              CodeCompletionCache::Value &V,
-                             bool allowOutOfDate = false) {
+                             bool allowOutOfDate = false,
+                             StringRef namePrefix = StringRef()) {
   const char *cursor = in->getBufferStart();
   const char *end = in->getBufferEnd();
 
@@ -130,6 +134,8 @@ static bool readCachedModule(llvm::MemoryBuffer *in,
 
   // HEADER
   {
+    if (end - cursor < 4)
+      return false;
     auto version = read32le(cursor);
     if (version != onDiskCompletionCacheVersion)
       return false; // File written with different format.
@@ -152,14 +158,24 @@ static bool readCachedModule(llvm::MemoryBuffer *in,
 
   // Get the size of the various sections.
   auto resultSize = read32le(cursor);
+  const char *results = cursor;
   const char *resultEnd = cursor + resultSize;
   const char *chunks = resultEnd;
   auto chunkSize = read32le(chunks);
   const char *strings = chunks + chunkSize;
-  auto stringCount = read32le(strings);
-  assert(strings + stringCount == end && "incorrect file size");
-  (void)stringCount; // so it is not seen as "unused" in release builds.
-  
+  auto stringSize = read32le(strings);
+  const char *index = strings + stringSize;
+  auto indexCount = read32le(index);
+  assert(index + indexCount * 2 * sizeof(uint32_t) == end &&
+         "incorrect file size");
+
+  // The results refer to the strings in place, so keep the buffer alive for
+  // as long as their allocator, which other sinks may adopt.
+  std::shared_ptr<llvm::MemoryBuffer> buffer(std::move(in));
+  V.Sink.Allocator = CodeCompletionResultSink::AllocatorPtr(
+      new llvm::BumpPtrAllocator(),
+      [buffer](llvm::BumpPtrAllocator *allocator) { delete allocator; });
+
   // STRINGS
   auto getString = [&](uint32_t index) -> StringRef {
     if (index == ~0u)
@@ -167,7 +183,7 @@ static bool readCachedModule(llvm::MemoryBuffer *in,
 
     const char *p = strings + index;
     auto size = read32le(p);
-    return copyString(*V.Sink.Allocator, StringRef(p, size));
+    return StringRef(p, size);
   };
 
   // CHUNKS
@@ -195,42 +211,32 @@ static bool readCachedModule(llvm::MemoryBuffer *in,
   };
 
   // RESULTS
-  while (cursor != resultEnd) {
-    auto kind = static_cast<CodeCompletionResult::ResultKind>(*cursor++);
-    auto declKind = static_cast<CodeCompletionDeclKind>(*cursor++);
-    auto opKind = static_cast<CodeCompletionOperatorKind>(*cursor++);
-    auto context = static_cast<SemanticContextKind>(*cursor++);
-    auto notRecommended = static_cast<bool>(*cursor++);
-    auto numBytesToErase = static_cast<unsigned>(*cursor++);
-    auto oldCursor = cursor;
-    auto chunkIndex = read32le(cursor);
-    auto IntLength = cursor - oldCursor;
-    auto moduleIndex = read32le(cursor);
-    auto briefDocIndex = read32le(cursor);
-    auto assocUSRCount = read32le(cursor);
-    auto assocUSRsIndex = read32le(cursor);
-    auto declKeywordCount = read32le(cursor);
-    auto declKeywordIndex = read32le(cursor);
+  auto readResult = [&](const char *p) {
+    auto kind = static_cast<CodeCompletionResult::ResultKind>(*p++);
+    auto declKind = static_cast<CodeCompletionDeclKind>(*p++);
+    auto opKind = static_cast<CodeCompletionOperatorKind>(*p++);
+    auto context = static_cast<SemanticContextKind>(*p++);
+    auto notRecommended = static_cast<bool>(*p++);
+    auto numBytesToErase = static_cast<unsigned>(*p++);
+    auto chunkIndex = read32le(p);
+    auto moduleIndex = read32le(p);
+    auto briefDocIndex = read32le(p);
 
-    CodeCompletionString *string = getCompletionString(chunkIndex);
-    auto moduleName = getString(moduleIndex);
-    auto briefDocComment = getString(briefDocIndex);
     SmallVector<StringRef, 4> assocUSRs;
-    for (unsigned i = 0; i < assocUSRCount; ++i) {
-      auto usr = getString(assocUSRsIndex);
-      assocUSRs.push_back(usr);
-      assocUSRsIndex += usr.size() + IntLength;
-    }
+    for (auto count = read32le(p); count; --count)
+      assocUSRs.push_back(getString(read32le(p)));
 
     SmallVector<std::pair<StringRef, StringRef>, 4> declKeywords;
-    for (unsigned i = 0; i < declKeywordCount; ++i) {
-      auto first = getString(declKeywordIndex);
-      declKeywordIndex += first.size() + IntLength;
-      auto second = getString(declKeywordIndex);
-      declKeywordIndex += second.size() + IntLength;
+    for (auto count = read32le(p); count; --count) {
+      auto first = getString(read32le(p));
+      auto second = getString(read32le(p));
       declKeywords.push_back(std::make_pair(first, second));
     }
 
+    CodeCompletionString *string = getCompletionString(chunkIndex);
+    auto moduleName = getString(moduleIndex);
+    auto briefDocComment = getString(briefDocIndex);
+
     CodeCompletionResult *result = nullptr;
     if (kind == CodeCompletionResult::Declaration) {
       result = new (*V.Sink.Allocator) CodeCompletionResult(
@@ -245,8 +251,47 @@ static bool readCachedModule(llvm::MemoryBuffer *in,
     }
 
     V.Sink.Results.push_back(result);
+    return p;
+  };
+
+  if (namePrefix.empty()) {
+    while (cursor != resultEnd)
+      cursor = readResult(cursor);
+    return true;
+  }
+
+  // INDEX
+  auto getIndexEntry = [&](uint32_t i) {
+    const char *p = index + i * 2 * sizeof(uint32_t);
+    auto name = getString(read32le(p));
+    auto resultOffset = read32le(p);
+    return std::make_pair(name, resultOffset);
+  };
+
+  // The entries are sorted by name, ignoring case, so the names that start
+  // with the prefix are contiguous.
+  uint32_t lower = 0, upper = indexCount;
+  while (lower < upper) {
+    uint32_t middle = lower + (upper - lower) / 2;
+    if (getIndexEntry(middle).first.compare_lower(namePrefix) < 0)
+      lower = middle + 1;
+    else
+      upper = middle;
   }
 
+  SmallVector<uint32_t, 32> resultOffsets;
+  for (uint32_t i = lower; i < indexCount; ++i) {
+    auto entry = getIndexEntry(i);
+    if (!entry.first.startswith_lower(namePrefix))
+      break;
+    resultOffsets.push_back(entry.second);
+  }
+
+  // Keep the results in the order they were written.
+  llvm::array_pod_sort(resultOffsets.begin(), resultOffsets.end());
+  for (uint32_t offset : resultOffsets)
+    readResult(results + offset);
+
   return true;
 }
 
@@ -262,7 +307,7 @@ static bool readCachedModule(llvm::MemoryBuffer *in,
 ///     * the original CodeCompletionCache::Key, used for debugging the cache.
 ///
 ///   RESULTS
-///     * A length-prefixed array of fixed size CodeCompletionResults.
+///     * A length-prefixed array of CodeCompletionResults.
 ///     * Contains offsets into CHUNKS and STRINGS.
 ///
 ///   CHUNKS
@@ -271,7 +316,13 @@ static bool readCachedModule(llvm::MemoryBuffer *in,
 ///       CodeCompletionString::Chunks.
 ///
 ///   STRINGS
-///     * A blob of length-prefixed strings referred to in CHUNKS or RESULTS.
+///     * A blob of unique length-prefixed strings referred to in CHUNKS,
+///       RESULTS or INDEX.
+///
+///   INDEX
+///     * A length-prefixed array of (name, result offset) pairs, sorted by
+///       name ignoring case, to find the results whose name has a prefix
+///       without reading the others.
 static void writeCachedModule(llvm::raw_ostream &out,
                               const CodeCompletionCache::Key &K,
                               CodeCompletionCache::Value &V) {
@@ -309,15 +360,20 @@ static void writeCachedModule(llvm::raw_ostream &out,
   endian::Writer<little> chunksLE(chunks);
   std::string strings_;
   llvm::raw_string_ostream strings(strings_);
+  llvm::StringMap<uint32_t> stringIndices;
 
-  auto addString = [&strings](StringRef str) {
+  auto addString = [&strings, &stringIndices](StringRef str) {
     if (str.empty())
       return ~0u;
-    auto size = strings.tell();
+    auto inserted = stringIndices.insert({str, 0});
+    if (!inserted.second)
+      return inserted.first->getValue();
+    auto size = static_cast<uint32_t>(strings.tell());
     endian::Writer<little> LE(strings);
     LE.write(static_cast<uint32_t>(str.size()));
     strings << str;
-    return static_cast<uint32_t>(size);
+    inserted.first->getValue() = size;
+    return size;
   };
 
   auto addCompletionString = [&](const CodeCompletionString *str) {
@@ -337,9 +393,18 @@ static void writeCachedModule(llvm::raw_ostream &out,
   };
 
   // RESULTS
+  std::vector<std::pair<std::string, uint32_t>> names;
+  names.reserve(V.Sink.Results.size());
   {
     endian::Writer<little> LE(results);
     for (CodeCompletionResult *R : V.Sink.Results) {
+      std::string name;
+      {
+        llvm::raw_string_ostream OSS(name);
+        R->getCompletionString()->getName(OSS);
+      }
+      names.push_back({std::move(name), static_cast<uint32_t>(results.tell())});
+
       // FIXME: compress bitfield
       LE.write(static_cast<uint8_t>(R->getKind()));
       if (R->getKind() == CodeCompletionResult::Declaration)
@@ -358,28 +423,33 @@ static void writeCachedModule(llvm::raw_ostream &out,
       LE.write(addString(R->getModuleName()));      // index into strings
       LE.write(addString(R->getBriefDocComment())); // index into strings
       LE.write(static_cast<uint32_t>(R->getAssociatedUSRs().size()));
-      if (R->getAssociatedUSRs().empty()) {
-        LE.write(static_cast<uint32_t>(~0u));
-      } else {
-        LE.write(addString(R->getAssociatedUSRs()[0]));
-        for (unsigned i = 1; i < R->getAssociatedUSRs().size(); ++i) {
-          addString(R->getAssociatedUSRs()[i]); // ignore result
-        }
-      }
+      for (StringRef USR : R->getAssociatedUSRs())
+        LE.write(addString(USR));
       auto AllKeywords = R->getDeclKeywords();
       LE.write(static_cast<uint32_t>(AllKeywords.size()));
-      if (AllKeywords.empty()) {
-        LE.write(static_cast<uint32_t>(~0u));
-      } else {
-        LE.write(addString(AllKeywords[0].first));
-        addString(AllKeywords[0].second);
-        for (unsigned i = 1; i < AllKeywords.size(); ++i) {
-          addString(AllKeywords[i].first);
-          addString(AllKeywords[i].second);
-        }
+      for (auto &Keyword : AllKeywords) {
+        LE.write(addString(Keyword.first));
+        LE.write(addString(Keyword.second));
       }
     }
   }
+
+  // INDEX
+  std::string index_;
+  llvm::raw_string_ostream index(index_);
+  {
+    std::stable_sort(names.begin(), names.end(),
+                     [](const std::pair<std::string, uint32_t> &LHS,
+                        const std::pair<std::string, uint32_t> &RHS) {
+      return StringRef(LHS.first).compare_lower(RHS.first) < 0;
+    });
+    endian::Writer<little> LE(index);
+    for (auto &entry : names) {
+      LE.write(addString(entry.first));
+      LE.write(entry.second);
+    }
+  }
+
   LE.write(static_cast<uint32_t>(results.tell()));
   out << results.str();
 
@@ -390,6 +460,10 @@ static void writeCachedModule(llvm::raw_ostream &out,
   // STRINGS
   LE.write(static_cast<uint32_t>(strings.tell()));
   out << strings.str();
+
+  // INDEX
+  LE.write(static_cast<uint32_t>(names.size()));
+  out << index.str();
 }
 
 /// Get the name for the cached code completion results for a given key \p K in
@@ -421,16 +495,25 @@ static std::string getName(StringRef cacheDirectory,
   return name.str();
 }
 
+/// Opens a cache file, allowing it to be mapped into memory since the results
+/// read from it refer to its strings in place.
+static llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+getCacheFile(StringRef filename) {
+  return llvm::MemoryBuffer::getFile(filename, /*FileSize=*/-1,
+                                     /*RequiresNullTerminator=*/false);
+}
+
 Optional<CodeCompletionCache::ValueRefCntPtr>
-OnDiskCodeCompletionCache::get(const Key &K) {
+OnDiskCodeCompletionCache::get(const Key &K, StringRef namePrefix) {
   // Try to find the cached file.
-  auto bufferOrErr = llvm::MemoryBuffer::getFile(getName(cacheDirectory, K));
+  auto bufferOrErr = getCacheFile(getName(cacheDirectory, K));
   if (!bufferOrErr)
     return None;
 
   // Read the cached results, failing if they are out of date.
   auto V = CodeCompletionCache::createValue();
-  if (!readCachedModule(bufferOrErr.get().get(), K, *V))
+  if (!readCachedModule(std::move(bufferOrErr.get()), K, *V,
+                        /*allowOutOfDate*/ false, namePrefix))
     return None;
 
   return V;
@@ -464,9 +547,10 @@ std::error_code OnDiskCodeCompletionCache::set(const Key &K, ValueRefCntPtr V) {
 }
 
 Optional<CodeCompletionCache::ValueRefCntPtr>
-OnDiskCodeCompletionCache::getFromFile(StringRef filename) {
+OnDiskCodeCompletionCache::getFromFile(StringRef filename,
+                                       StringRef namePrefix) {
   // Try to find the cached file.
-  auto bufferOrErr = llvm::MemoryBuffer::getFile(filename);
+  auto bufferOrErr = getCacheFile(filename);
   if (!bufferOrErr)
     return None;
 
@@ -475,8 +559,8 @@ OnDiskCodeCompletionCache::getFromFile(StringRef filename) {
 
   // Read the cached results.
   auto V = CodeCompletionCache::createValue();
-  if (!readCachedModule(bufferOrErr.get().get(), K, *V,
-                        /*allowOutOfDate*/ true))
+  if (!readCachedModule(std::move(bufferOrErr.get()), K, *V,
+                        /*allowOutOfDate*/ true, namePrefix))
     return None;
 
   return V;
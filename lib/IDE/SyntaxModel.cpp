@@ -47,15 +47,20 @@ struct SyntaxModelContext::Implementation {
 };
 
 SyntaxModelContext::SyntaxModelContext(SourceFile &SrcFile)
+  : SyntaxModelContext(SrcFile,
+                       swift::tokenize(SrcFile.getASTContext().LangOpts,
+                                       SrcFile.getASTContext().SourceMgr,
+                                       *SrcFile.getBufferID(),
+                                       /*Offset=*/0,
+                                       /*EndOffset=*/0,
+                                       /*KeepComments=*/true,
+                                       /*TokenizeInterpolatedString=*/true)) {}
+
+SyntaxModelContext::SyntaxModelContext(SourceFile &SrcFile,
+                                       ArrayRef<Token> Tokens)
   : Impl(*new Implementation(SrcFile)) {
   const bool IsPlayground = Impl.LangOpts.Playground;
   const SourceManager &SM = Impl.SrcMgr;
-  std::vector<Token> Tokens = swift::tokenize(Impl.LangOpts, SM,
-                                              *Impl.SrcFile.getBufferID(),
-                                              /*Offset=*/0,
-                                              /*EndOffset=*/0,
-                                              /*KeepComments=*/true,
-                                           /*TokenizeInterpolatedString=*/true);
   std::vector<SyntaxNode> Nodes;
   SourceLoc AttrLoc;
   SourceLoc UnaryMinusLoc;
@@ -760,33 +760,49 @@ static void performParallelIRGeneration(IRGenOptions &Opts,
     return;
   }
 
-  // Emit the module contents.
-  irgen.emitGlobalTopLevel();
-  
-  for (auto *File : M->getFiles()) {
-    if (SourceFile *SF = dyn_cast<SourceFile>(File)) {
-      IRGenModule *IGM = irgen.getGenModule(SF);
-      IGM->emitSourceFile(*SF, 0);
-    } else {
-      File->collectLinkLibraries([&](LinkLibrary LinkLib) {
-        irgen.getPrimaryIGM()->addLinkLibrary(LinkLib);
-      });
-    }
-  }
-  
   IRGenModule *PrimaryGM = irgen.getPrimaryIGM();
 
-  irgen.emitProtocolConformances();
+  // Each source file gets its own LLVMContext and module, but only the LLVM
+  // passes and code generation below run on multiple threads. IR emission
+  // stays serial: it reads and fills caches that are shared between the
+  // IRGenModules and not synchronized, such as the SILModule's type lowering,
+  // the ASTContext's uniquing tables and the IRGenerator's lazy emission
+  // queues. The timers show how long these serial phases take.
+  {
+    SharedTimer timer("IRGen");
+
+    // Emit the module contents.
+    irgen.emitGlobalTopLevel();
 
-  // Okay, emit any definitions that we suddenly need.
-  irgen.emitLazyDefinitions();
-  
- // Emit symbols for eliminated dead methods.
-  PrimaryGM->emitVTableStubs();
-    
-  // Verify type layout if we were asked to.
-  if (!Opts.VerifyTypeLayoutNames.empty())
-    PrimaryGM->emitTypeVerifier();
+    {
+      SharedTimer timer("IRGen (source files)");
+      for (auto *File : M->getFiles()) {
+        if (SourceFile *SF = dyn_cast<SourceFile>(File)) {
+          IRGenModule *IGM = irgen.getGenModule(SF);
+          IGM->emitSourceFile(*SF, 0);
+        } else {
+          File->collectLinkLibraries([&](LinkLibrary LinkLib) {
+            irgen.getPrimaryIGM()->addLinkLibrary(LinkLib);
+          });
+        }
+      }
+    }
+
+    {
+      SharedTimer timer("IRGen (lazy definitions)");
+      irgen.emitProtocolConformances();
+
+      // Okay, emit any definitions that we suddenly need.
+      irgen.emitLazyDefinitions();
+    }
+
+    // Emit symbols for eliminated dead methods.
+    PrimaryGM->emitVTableStubs();
+
+    // Verify type layout if we were asked to.
+    if (!Opts.VerifyTypeLayoutNames.empty())
+      PrimaryGM->emitTypeVerifier();
+  }
   
   std::for_each(Opts.LinkLibraries.begin(), Opts.LinkLibraries.end(),
                 [&](LinkLibrary linkLib) {
@@ -809,6 +825,9 @@ static void performParallelIRGeneration(IRGenOptions &Opts,
     });
   }
   
+  Optional<SharedTimer> finalizationTimer;
+  finalizationTimer.emplace("IRGen (cross-module linkage and finalization)");
+
   llvm::StringSet<> referencedGlobals;
 
   for (auto it = irgen.begin(); it != irgen.end(); ++it) {
@@ -857,9 +876,15 @@ static void performParallelIRGeneration(IRGenOptions &Opts,
     setModuleFlags(*IGM);
   }
 
+  finalizationTimer.reset();
+
   // Bail out if there are any errors.
   if (Ctx.hadError()) return;
 
+  // The per-module LLVM timers overlap with each other, so also time the
+  // whole parallel phase.
+  SharedTimer timer("LLVM (all threads)");
+
   std::vector<std::thread> Threads;
   llvm::sys::Mutex DiagMutex;
 
@@ -28,6 +28,10 @@
 // FIXME: Figure out if this can be migrated to LLVM.
 #include "clang/Basic/CharInfo.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using namespace swift;
 
 // clang::isIdentifierHead and clang::isIdentifierBody are deliberately not in
@@ -163,6 +167,115 @@ static uint32_t validateUTF8CharacterAndAdvance(const char *&Ptr,
   return EncodedBytes == 4 ? CharValue : ~0U;
 }
 
+//===----------------------------------------------------------------------===//
+// Bulk Scanning Helper Functions
+//===----------------------------------------------------------------------===//
+
+// Most of a source file is ASCII identifiers, whitespace, comments and string
+// literals, where the lexer only has to find the next character that needs a
+// closer look.  These helpers skip the characters that don't, 16 at a time
+// when SSE2 is available.  They always stop at a non-ASCII byte so that the
+// callers still validate UTF-8 exactly as before.
+
+namespace {
+/// A set of ASCII characters the bulk scanners stop at.
+template <char... Stops> struct StopSet;
+
+template <> struct StopSet<> {
+  static bool contains(char C) { return false; }
+#if defined(__SSE2__)
+  static __m128i match(__m128i Chunk) { return _mm_setzero_si128(); }
+#endif
+};
+
+template <char Stop, char... Rest> struct StopSet<Stop, Rest...> {
+  static bool contains(char C) {
+    return C == Stop || StopSet<Rest...>::contains(C);
+  }
+#if defined(__SSE2__)
+  static __m128i match(__m128i Chunk) {
+    return _mm_or_si128(_mm_cmpeq_epi8(Chunk, _mm_set1_epi8(Stop)),
+                        StopSet<Rest...>::match(Chunk));
+  }
+#endif
+};
+} // end anonymous namespace
+
+#if defined(__SSE2__)
+/// Returns a mask of the bytes of \p Chunk that are in ['Lo', 'Hi'].  Bytes
+/// that are not ASCII compare as negative, so they are never in the range.
+static __m128i matchRange(__m128i Chunk, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(Chunk, _mm_set1_epi8(Lo - 1)),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(Hi + 1), Chunk));
+}
+#endif
+
+/// Returns the first character in [Ptr, End) that is either one of \p Stops
+/// or not ASCII, or \p End if there is none.
+template <char... Stops>
+static const char *skipASCIIExcept(const char *Ptr, const char *End) {
+#if defined(__SSE2__)
+  while (End - Ptr >= 16) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i *)Ptr);
+    // The sign bits of the non-ASCII bytes are already set.
+    unsigned Mask = _mm_movemask_epi8(
+        _mm_or_si128(Chunk, StopSet<Stops...>::match(Chunk)));
+    if (Mask)
+      return Ptr + llvm::countTrailingZeros(Mask, llvm::ZB_Undefined);
+    Ptr += 16;
+  }
+#endif
+  while (Ptr != End && (signed char)*Ptr >= 0 &&
+         !StopSet<Stops...>::contains(*Ptr))
+    ++Ptr;
+  return Ptr;
+}
+
+/// Returns the first character in [Ptr, End) that is not one of
+/// [a-zA-Z_$0-9], or \p End if there is none.
+static const char *skipASCIIIdentifierBody(const char *Ptr, const char *End) {
+#if defined(__SSE2__)
+  while (End - Ptr >= 16) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i *)Ptr);
+    // Setting bit 5 maps the uppercase letters onto the lowercase ones, and
+    // nothing else into [a-z].
+    __m128i Lower = _mm_or_si128(Chunk, _mm_set1_epi8(0x20));
+    __m128i Body = _mm_or_si128(
+        _mm_or_si128(matchRange(Lower, 'a', 'z'), matchRange(Chunk, '0', '9')),
+        StopSet<'_', '$'>::match(Chunk));
+    unsigned Mask = ~_mm_movemask_epi8(Body) & 0xFFFF;
+    if (Mask)
+      return Ptr + llvm::countTrailingZeros(Mask, llvm::ZB_Undefined);
+    Ptr += 16;
+  }
+#endif
+  while (Ptr != End && clang::isIdentifierBody(*Ptr, /*dollar*/true))
+    ++Ptr;
+  return Ptr;
+}
+
+/// Returns the first character in [Ptr, End) that a string literal cannot
+/// simply contain: a quote, a backslash, or a character that is not printable
+/// ASCII.  Returns \p End if there is none.
+static const char *skipPlainStringLiteralText(const char *Ptr,
+                                              const char *End) {
+#if defined(__SSE2__)
+  while (End - Ptr >= 16) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i *)Ptr);
+    __m128i Plain = _mm_andnot_si128(StopSet<'"', '\'', '\\'>::match(Chunk),
+                                     matchRange(Chunk, 0x20, 0x7E));
+    unsigned Mask = ~_mm_movemask_epi8(Plain) & 0xFFFF;
+    if (Mask)
+      return Ptr + llvm::countTrailingZeros(Mask, llvm::ZB_Undefined);
+    Ptr += 16;
+  }
+#endif
+  while (Ptr != End && isPrintable(*Ptr) &&
+         !StopSet<'"', '\'', '\\'>::contains(*Ptr))
+    ++Ptr;
+  return Ptr;
+}
+
 //===----------------------------------------------------------------------===//
 // Setup and Helper Methods
 //===----------------------------------------------------------------------===//
@@ -308,6 +421,7 @@ static void diagnoseEmbeddedNul(DiagnosticEngine *Diags, const char *Ptr) {
 
 void Lexer::skipToEndOfLine() {
   while (1) {
+    CurPtr = skipASCIIExcept<'\n', '\r', 0>(CurPtr, BufferEnd);
     switch (*CurPtr++) {
     case '\n':
     case '\r':
@@ -361,6 +475,7 @@ void Lexer::skipSlashStarComment() {
   unsigned Depth = 1;
   
   while (1) {
+    CurPtr = skipASCIIExcept<'*', '/', '\n', '\r', 0>(CurPtr, BufferEnd);
     switch (*CurPtr++) {
     case '*':
       // Check for a '*/'
@@ -568,7 +683,9 @@ void Lexer::lexIdentifier() {
   assert(didStart && "Unexpected start");
   (void) didStart;
 
-  // Lex [a-zA-Z_$0-9[[:XID_Continue:]]]*
+  // Lex [a-zA-Z_$0-9[[:XID_Continue:]]]*, skipping runs of ASCII in bulk.
+  do
+    CurPtr = skipASCIIIdentifierBody(CurPtr, BufferEnd);
   while (advanceIfValidContinuationOfIdentifier(CurPtr, BufferEnd));
 
   tok Kind = kindOfIdentifier(StringRef(TokStart, CurPtr-TokStart), InSILMode);
@@ -1248,6 +1365,8 @@ void Lexer::lexStringLiteral() {
   bool wasErroneous = false;
   
   while (true) {
+    CurPtr = skipPlainStringLiteralText(CurPtr, BufferEnd);
+
     if (*CurPtr == '\\' && *(CurPtr + 1) == '(') {
       // Consume tokens until we hit the corresponding ')'.
       CurPtr += 2;
@@ -1665,6 +1784,9 @@ Restart:
   case '\t':
   case '\f':
   case '\v':
+    // Indentation comes in runs; don't go around the switch for each one.
+    while (*CurPtr == ' ' || *CurPtr == '\t')
+      ++CurPtr;
     goto Restart;  // Skip whitespace.
 
   case -1:
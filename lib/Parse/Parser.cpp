@@ -275,6 +275,111 @@ std::vector<Token> swift::tokenize(const LangOptions &LangOpts,
   return Tokens;
 }
 
+/// Returns true if only whitespace precedes \p Offset on its line.
+///
+/// Neither string literals nor their interpolations can span lines, so a token
+/// starting at such a position is lexed the same way no matter what comes
+/// before the line.
+static bool isAtStartOfLine(StringRef Text, unsigned Offset) {
+  for (; Offset != 0; --Offset) {
+    char C = Text[Offset - 1];
+    if (C == '\n' || C == '\r')
+      return true;
+    if (C != ' ' && C != '\t')
+      return false;
+  }
+  return true;
+}
+
+std::vector<Token> swift::retokenize(const LangOptions &LangOpts,
+                                     const SourceManager &SM,
+                                     unsigned BufferID,
+                                     ArrayRef<Token> OldTokens,
+                                     StringRef OldText,
+                                     unsigned EditOffset,
+                                     unsigned EditOldLength,
+                                     unsigned EditNewLength) {
+  StringRef NewText = SM.extractText(SM.getRangeForBuffer(BufferID));
+  assert(NewText.size() + EditOldLength == OldText.size() + EditNewLength &&
+         "edit does not match the buffers");
+
+  auto getOldOffset = [&](const Token &Tok) -> unsigned {
+    return Tok.getText().data() - OldText.data();
+  };
+  auto reuseOldTokens = [&](ArrayRef<Token> Toks, ptrdiff_t Shift,
+                            std::vector<Token> &Result) {
+    for (Token Tok : Toks) {
+      Tok.setText(NewText.substr(getOldOffset(Tok) + Shift, Tok.getLength()));
+      Result.push_back(Tok);
+    }
+  };
+
+  // Restart lexing at the last token starting a line at or before the edit.
+  unsigned Restart = std::upper_bound(OldTokens.begin(), OldTokens.end(),
+                                      EditOffset,
+                                      [&](unsigned Offset, const Token &Tok) {
+    return Offset < getOldOffset(Tok);
+  }) - OldTokens.begin();
+  unsigned RestartOffset = 0;
+  while (Restart != 0) {
+    --Restart;
+    unsigned Offset = getOldOffset(OldTokens[Restart]);
+    if (isAtStartOfLine(OldText, Offset)) {
+      RestartOffset = Offset;
+      break;
+    }
+  }
+
+  std::vector<Token> Tokens;
+  Tokens.reserve(OldTokens.size());
+  reuseOldTokens(OldTokens.slice(0, Restart), 0, Tokens);
+  OldTokens = OldTokens.slice(Restart);
+
+  Lexer L(LangOpts, SM, BufferID, /*Diags=*/nullptr, /*InSILMode=*/false,
+          CommentRetentionMode::ReturnAsTokens);
+  if (RestartOffset != 0) {
+    SourceLoc Loc = SM.getLocForOffset(BufferID, RestartOffset);
+    L.restoreState(L.getStateForBeginningOfTokenLoc(Loc));
+  }
+
+  unsigned NewEditEnd = EditOffset + EditNewLength;
+  Token Tok;
+  while (true) {
+    L.lex(Tok);
+    if (Tok.is(tok::eof))
+      break;
+
+    // Once past the edit, a token starting a line that also started a line
+    // before the edit is the first of a run the lexer would produce again.
+    unsigned Offset = SM.getLocOffsetInBuffer(Tok.getLoc(), BufferID);
+    if (Offset >= NewEditEnd && Tok.isNot(tok::string_literal) &&
+        isAtStartOfLine(NewText, Offset)) {
+      unsigned OldOffset = Offset - EditNewLength + EditOldLength;
+      auto OldI = std::lower_bound(OldTokens.begin(), OldTokens.end(),
+                                   OldOffset,
+                                   [&](const Token &Tok, unsigned Offset) {
+        return getOldOffset(Tok) < Offset;
+      });
+      if (OldI != OldTokens.end() && getOldOffset(*OldI) == OldOffset &&
+          OldI->getKind() == Tok.getKind() &&
+          OldI->getLength() == Tok.getLength() &&
+          isAtStartOfLine(OldText, OldOffset)) {
+        reuseOldTokens(OldTokens.slice(OldI - OldTokens.begin()),
+                       ptrdiff_t(EditNewLength) - ptrdiff_t(EditOldLength),
+                       Tokens);
+        return Tokens;
+      }
+    }
+
+    if (Tok.is(tok::string_literal))
+      getStringPartTokens(Tok, LangOpts, SM, BufferID, Tokens);
+    else
+      Tokens.push_back(Tok);
+  }
+
+  return Tokens;
+}
+
 //===----------------------------------------------------------------------===//
 // Setup and Helper Methods
 //===----------------------------------------------------------------------===//
@@ -24,18 +24,27 @@
 #include "swift/SIL/SILFunction.h"
 #include "swift/SIL/SILModule.h"
 #include "swift/SIL/InstructionUtils.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace swift;
 
+STATISTIC(NumAliasCacheHits, "Number of alias queries answered by the cache");
+STATISTIC(NumAliasCacheMisses, "Number of alias queries computed");
+STATISTIC(NumFunctionCachesInvalidated,
+          "Number of function alias caches dropped by invalidation");
 
-// The AliasAnalysis Cache must not grow beyond this size.
+// The AliasAnalysis Cache of a function must not grow beyond this size.
 // We limit the size of the AA cache to 2**14 because we want to limit the
 // memory usage of this cache.
 static const int AliasAnalysisMaxCacheSize = 16384;
 
+// The alias and memory behavior caches of all functions together must not
+// grow beyond this size.
+static const size_t AliasAnalysisMaxModuleCacheSize = 16 * 16384;
+
 
 //===----------------------------------------------------------------------===//
 //                                AA Debugging
@@ -534,26 +543,34 @@ bool AliasAnalysis::typesMayAlias(SILType T1, SILType T2) {
 /// to disambiguate the two values.
 AliasResult AliasAnalysis::alias(SILValue V1, SILValue V2,
                                  SILType TBAAType1, SILType TBAAType2) {
-  AliasKeyTy Key = toAliasKey(V1, V2, TBAAType1, TBAAType2);
-
   // Check if we've already computed this result.
-  auto It = AliasCache.find(Key);
-  if (It != AliasCache.end()) {
-    return It->second;
+  {
+    FunctionCache &FC = getFunctionCache(V1, V2);
+    auto It = FC.AliasCache.find(toAliasKey(FC, V1, V2, TBAAType1, TBAAType2));
+    if (It != FC.AliasCache.end()) {
+      ++NumAliasCacheHits;
+      return It->second;
+    }
   }
+  ++NumAliasCacheMisses;
 
-  // Flush the cache if the size of the cache is too large.
-  if (AliasCache.size() > AliasAnalysisMaxCacheSize) {
-    AliasCache.clear();
-    AliasValueBaseToIndex.clear();
+  // Calculate the aliasing result.
+  auto Result = aliasInner(V1, V2, TBAAType1, TBAAType2);
 
-    // Key is no longer valid as we cleared the AliasValueBaseToIndex.
-    Key = toAliasKey(V1, V2, TBAAType1, TBAAType2);
+  // The nested queries of aliasInner may have flushed the caches, so look up
+  // the cache again to store the result.
+  FunctionCache &FC = getFunctionCache(V1, V2);
+
+  // Flush the cache if the size of the cache is too large.
+  if (FC.AliasCache.size() > AliasAnalysisMaxCacheSize) {
+    NumCachedResults -= FC.AliasCache.size();
+    FC.AliasCache.clear();
+    FC.AliasValueBaseToIndex.clear();
   }
 
-  // Calculate the aliasing result and store it in the cache.
-  auto Result = aliasInner(V1, V2, TBAAType1, TBAAType2);
-  AliasCache[Key] = Result;
+  AliasKeyTy Key = toAliasKey(FC, V1, V2, TBAAType1, TBAAType2);
+  if (FC.AliasCache.insert({Key, Result}).second)
+    ++NumCachedResults;
   return Result;
 }
 
@@ -755,12 +772,71 @@ SILAnalysis *swift::createAliasAnalysis(SILModule *M) {
   return new AliasAnalysis(M);
 }
 
-AliasKeyTy AliasAnalysis::toAliasKey(SILValue V1, SILValue V2,
-                                     SILType Type1, SILType Type2) {
-  size_t idx1 = AliasValueBaseToIndex.getIndex(V1);
+SILFunction *AliasAnalysis::getFunctionOf(ValueBase *V) {
+  if (SILBasicBlock *BB = V->getParentBB())
+    return BB->getParent();
+  return nullptr;
+}
+
+AliasAnalysis::FunctionCache &
+AliasAnalysis::getFunctionCache(SILValue V1, SILValue V2) {
+  // Start over if the caches of all functions together got too large.
+  if (NumCachedResults > AliasAnalysisMaxModuleCacheSize)
+    invalidate(InvalidationKind::Everything);
+
+  SILFunction *F = getFunctionOf(V1);
+  if (SILFunction *F2 = getFunctionOf(V2)) {
+    if (!F)
+      F = F2;
+    else if (F != F2)
+      F = nullptr;
+  }
+
+  std::unique_ptr<FunctionCache> &FC = FunctionCaches[F];
+  if (!FC)
+    FC.reset(new FunctionCache());
+  return *FC;
+}
+
+void AliasAnalysis::eraseFunctionCache(SILFunction *F) {
+  auto It = FunctionCaches.find(F);
+  if (It == FunctionCaches.end())
+    return;
+  NumCachedResults -= It->second->AliasCache.size() +
+                      It->second->MemoryBehaviorCache.size();
+  FunctionCaches.erase(It);
+  ++NumFunctionCachesInvalidated;
+}
+
+void AliasAnalysis::invalidate(SILFunction *F, InvalidationKind K) {
+  eraseFunctionCache(F);
+
+  // The cached memory behavior of the applies in the callers of F is computed
+  // from the side-effects of F, so the callers' caches are stale as well.
+  // Drop the caches of the same callers side-effect analysis invalidates.
+  // Side-effect analysis is registered after alias analysis, so its caller
+  // lists have not been cleared for this invalidation yet.
+  SEA->visitIncludingAllCallers(F, [&](SILFunction *Caller) {
+    eraseFunctionCache(Caller);
+  });
+
+  // The shared cache may hold results about values of F, too.
+  auto It = FunctionCaches.find(nullptr);
+  if (It != FunctionCaches.end()) {
+    NumCachedResults -= It->second->AliasCache.size() +
+                        It->second->MemoryBehaviorCache.size();
+    It->second->AliasCache.clear();
+    It->second->MemoryBehaviorCache.clear();
+  }
+}
+
+AliasKeyTy AliasAnalysis::toAliasKey(FunctionCache &FC, SILValue V1,
+                                     SILValue V2, SILType Type1,
+                                     SILType Type2) {
+  size_t idx1 = FC.AliasValueBaseToIndex.getIndex(V1);
   assert(idx1 != std::numeric_limits<size_t>::max() &&
          "~0 index reserved for empty/tombstone keys");
-  size_t idx2 = AliasValueBaseToIndex.getIndex(V2);
+  size_t idx2 = FC.AliasValueBaseToIndex.getIndex(V2);
   assert(idx2 != std::numeric_limits<size_t>::max() &&
          "~0 index reserved for empty/tombstone keys");
   void *t1 = Type1.getOpaqueValue();
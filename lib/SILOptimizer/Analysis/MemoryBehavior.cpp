@@ -17,11 +17,17 @@
 #include "swift/SILOptimizer/Analysis/SideEffectAnalysis.h"
 #include "swift/SILOptimizer/Analysis/ValueTracking.h"
 #include "swift/SIL/SILVisitor.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Debug.h"
 
 using namespace swift;
 
-// The MemoryBehavior Cache must not grow beyond this size.
+STATISTIC(NumMemoryBehaviorCacheHits,
+          "Number of memory behavior queries answered by the cache");
+STATISTIC(NumMemoryBehaviorCacheMisses,
+          "Number of memory behavior queries computed");
+
+// The MemoryBehavior Cache of a function must not grow beyond this size.
 // We limit the size of the MB cache to 2**14 because we want to limit the
 // memory usage of this cache.
 static const int MemoryBehaviorAnalysisMaxCacheSize = 16384;
@@ -303,26 +309,36 @@ MemBehavior MemoryBehaviorVisitor::visitReleaseValueInst(ReleaseValueInst *SI) {
 MemBehavior
 AliasAnalysis::computeMemoryBehavior(SILInstruction *Inst, SILValue V,
                                      RetainObserveKind InspectionMode) {
-  MemBehaviorKeyTy Key = toMemoryBehaviorKey(SILValue(Inst), V,
-                                             InspectionMode);
   // Check if we've already computed this result.
-  auto It = MemoryBehaviorCache.find(Key);
-  if (It != MemoryBehaviorCache.end()) {
-    return It->second;
+  {
+    FunctionCache &FC = getFunctionCache(SILValue(Inst), V);
+    auto It = FC.MemoryBehaviorCache.find(
+        toMemoryBehaviorKey(FC, SILValue(Inst), V, InspectionMode));
+    if (It != FC.MemoryBehaviorCache.end()) {
+      ++NumMemoryBehaviorCacheHits;
+      return It->second;
+    }
   }
+  ++NumMemoryBehaviorCacheMisses;
 
-  // Flush the cache if the size of the cache is too large.
-  if (MemoryBehaviorCache.size() > MemoryBehaviorAnalysisMaxCacheSize) {
-    MemoryBehaviorCache.clear();
-    MemoryBehaviorValueBaseToIndex.clear();
+  // Calculate the memory behavior.
+  auto Result = computeMemoryBehaviorInner(Inst, V, InspectionMode);
 
-    // Key is no longer valid as we cleared the MemoryBehaviorValueBaseToIndex.
-    Key = toMemoryBehaviorKey(SILValue(Inst), V, InspectionMode);
+  // The alias queries of computeMemoryBehaviorInner may have flushed the
+  // caches, so look up the cache again to store the result.
+  FunctionCache &FC = getFunctionCache(SILValue(Inst), V);
+
+  // Flush the cache if the size of the cache is too large.
+  if (FC.MemoryBehaviorCache.size() > MemoryBehaviorAnalysisMaxCacheSize) {
+    NumCachedResults -= FC.MemoryBehaviorCache.size();
+    FC.MemoryBehaviorCache.clear();
+    FC.MemoryBehaviorValueBaseToIndex.clear();
   }
 
-  // Calculate the aliasing result and store it in the cache.
-  auto Result = computeMemoryBehaviorInner(Inst, V, InspectionMode);
-  MemoryBehaviorCache[Key] = Result;
+  MemBehaviorKeyTy Key = toMemoryBehaviorKey(FC, SILValue(Inst), V,
+                                             InspectionMode);
+  if (FC.MemoryBehaviorCache.insert({Key, Result}).second)
+    ++NumCachedResults;
   return Result;
 }
 
@@ -335,12 +351,13 @@ AliasAnalysis::computeMemoryBehaviorInner(SILInstruction *Inst, SILValue V,
   return MemoryBehaviorVisitor(this, SEA, EA, V, InspectionMode).visit(Inst);
 }
 
-MemBehaviorKeyTy AliasAnalysis::toMemoryBehaviorKey(SILValue V1, SILValue V2,
+MemBehaviorKeyTy AliasAnalysis::toMemoryBehaviorKey(FunctionCache &FC,
+                                                    SILValue V1, SILValue V2,
                                                     RetainObserveKind M) {
-  size_t idx1 = MemoryBehaviorValueBaseToIndex.getIndex(V1);
+  size_t idx1 = FC.MemoryBehaviorValueBaseToIndex.getIndex(V1);
   assert(idx1 != std::numeric_limits<size_t>::max() &&
          "~0 index reserved for empty/tombstone keys");
-  size_t idx2 = MemoryBehaviorValueBaseToIndex.getIndex(V2);
+  size_t idx2 = FC.MemoryBehaviorValueBaseToIndex.getIndex(V2);
   assert(idx2 != std::numeric_limits<size_t>::max() &&
          "~0 index reserved for empty/tombstone keys");
   return {idx1, idx2, M};
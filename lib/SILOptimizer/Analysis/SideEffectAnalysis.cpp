@@ -522,6 +522,14 @@ void SideEffectAnalysis::invalidate(SILFunction *F, InvalidationKind K) {
   }
 }
 
+void SideEffectAnalysis::visitIncludingAllCallers(
+    SILFunction *F, llvm::function_ref<void(SILFunction *)> Visit) {
+  if (FunctionInfo *FInfo = Function2Info.lookup(F)) {
+    BottomUpIPAnalysis::visitIncludingAllCallers(
+        FInfo, [&](FunctionInfo *FInfo) { Visit(FInfo->F); });
+  }
+}
+
 SILAnalysis *swift::createSideEffectAnalysis(SILModule *M) {
   return new SideEffectAnalysis();
 }
@@ -258,18 +258,35 @@ void AddSSAPasses(SILPassManager &PM, OptimizationLevelKind OpLevel) {
 }
 
 
+/// Makes all reference counting operations non-atomic if the module is known
+/// to run single-threaded.
+///
+/// This is not an optimization, so it also runs when the performance
+/// optimizations are disabled.
+static void runAssumeSingleThreaded(SILModule &Module) {
+  if (!Module.getOptions().AssumeSingleThreaded)
+    return;
+
+  SILPassManager PM(&Module, "AssumeSingleThreaded");
+  PM.addAssumeSingleThreaded();
+  PM.runOneIteration();
+}
+
 void swift::runSILOptimizationPasses(SILModule &Module) {
   // Verify the module, if required.
   if (Module.getOptions().VerifyAll)
     Module.verify();
 
-  if (Module.getOptions().DisableSILPerfOptimizations)
+  if (Module.getOptions().DisableSILPerfOptimizations) {
+    runAssumeSingleThreaded(Module);
     return;
+  }
 
   if (Module.getOptions().DebugSerialization) {
     SILPassManager PM(&Module);
     PM.addSILLinker();
     PM.run();
+    runAssumeSingleThreaded(Module);
     return;
   }
 
@@ -395,6 +412,11 @@ void swift::runSILOptimizationPasses(SILModule &Module) {
   // Has only an effect if the -gsil option is specified.
   PM.addSILDebugInfoGenerator();
 
+  // Make all reference counting operations non-atomic if the module is known
+  // to run single-threaded.
+  if (Module.getOptions().AssumeSingleThreaded)
+    PM.addAssumeSingleThreaded();
+
   // Call the CFG viewer.
   if (SILViewCFG) {
     PM.addCFGPrinter();
@@ -431,6 +453,11 @@ void swift::runSILPassesForOnone(SILModule &Module) {
   // Has only an effect if the -gsil option is specified.
   PM.addSILDebugInfoGenerator();
 
+  // Make all reference counting operations non-atomic if the module is known
+  // to run single-threaded.
+  if (Module.getOptions().AssumeSingleThreaded)
+    PM.addAssumeSingleThreaded();
+
   PM.runOneIteration();
 
   // Verify the module, if required.
@@ -0,0 +1,71 @@
+//===--- AssumeSingleThreaded.cpp - Assume single-threaded execution  -----===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Assume that the code will be executed in a single-threaded environment.
+//
+// Under this assumption, it is safe to mark all reference counting
+// operations as non-atomic. IRGen lowers non-atomic reference counting
+// instructions to the swift_nonatomic_* runtime entry points, which update
+// the reference count with plain loads and stores instead of atomic
+// read-modify-write operations.
+//
+// The pass is only added to the pipeline if the -assume-single-threaded
+// frontend option is specified. It is the responsibility of the user to
+// guarantee that objects created by the module are never retained or released
+// concurrently by more than one thread.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "assume-single-threaded"
+
+#include "swift/SIL/SILFunction.h"
+#include "swift/SIL/SILInstruction.h"
+#include "swift/SILOptimizer/Analysis/Analysis.h"
+#include "swift/SILOptimizer/PassManager/Passes.h"
+#include "swift/SILOptimizer/PassManager/Transforms.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Debug.h"
+
+using namespace swift;
+
+STATISTIC(NumNonAtomicRC, "Number of reference counting instructions made "
+                          "non-atomic");
+
+namespace {
+
+class AssumeSingleThreaded : public swift::SILFunctionTransform {
+  /// The entry point to the transformation.
+  void run() override {
+    bool Changed = false;
+    for (auto &BB : *getFunction()) {
+      for (auto &I : BB) {
+        auto *RCInst = dyn_cast<RefCountingInst>(&I);
+        if (!RCInst || RCInst->isNonAtomic())
+          continue;
+        RCInst->setNonAtomic();
+        ++NumNonAtomicRC;
+        Changed = true;
+      }
+    }
+
+    if (Changed)
+      invalidateAnalysis(SILAnalysis::InvalidationKind::Instructions);
+  }
+
+  StringRef getName() override { return "Assume single threaded"; }
+};
+
+} // end anonymous namespace
+
+SILTransform *swift::createAssumeSingleThreaded() {
+  return new AssumeSingleThreaded();
+}
@@ -418,6 +418,8 @@ ConstraintSystem::SolverState::~SolverState() {
   #define CS_STATISTIC(Name, Description) JOIN2(Overall,Name) += Name;
   #include "ConstraintSolverStats.def"
 
+  CS.TotalStatesExplored += NumStatesExplored;
+
   // Update the "largest" statistics if this system is larger than the
   // previous one.  
   // FIXME: This is not at all thread-safe.
@@ -1051,14 +1053,11 @@ static bool tryTypeVariableBindings(
   auto &tc = cs.getTypeChecker();
   ++cs.solverState->NumTypeVariablesBound;
   
-  // If the solver has allocated an excessive amount of memory when solving for
-  // this expression, short-circuit the binding operation and mark the parent
-  // expression as "too complex".
-  if (cs.TC.Context.getSolverMemory() >
-        cs.TC.Context.LangOpts.SolverMemoryThreshold) {
-    cs.setExpressionTooComplex(true);
+  // If the solver has allocated an excessive amount of memory or spent too
+  // long when solving for this expression, short-circuit the binding
+  // operation and mark the parent expression as "too complex".
+  if (cs.checkSolverLimits())
     return true;
-  }
 
   for (unsigned tryCount = 0; !anySolved && !bindings.empty(); ++tryCount) {
     // Try each of the bindings in turn.
@@ -1276,6 +1275,190 @@ bool ConstraintSystem::solve(SmallVectorImpl<Solution> &solutions,
   return solutions.empty();
 }
 
+bool ConstraintSystem::checkSolverLimits() {
+  if (getExpressionTooComplex())
+    return true;
+
+  auto &langOpts = TC.getLangOpts();
+  if (TC.Context.getSolverMemory() > langOpts.SolverMemoryThreshold ||
+      (langOpts.SolverExpressionTimeThreshold &&
+       getElapsedTimeMS() >= *langOpts.SolverExpressionTimeThreshold)) {
+    setExpressionTooComplex(true);
+    return true;
+  }
+
+  return false;
+}
+
+/// Append the bytes of the given value to a cache key.
+template<typename T>
+static void appendToKey(std::string &key, const T &value) {
+  key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/// Append a description of the given constraint to a cache key.
+///
+/// Constraints introduced while solving, like the argument conversions of a
+/// chosen overload, are new objects on every path, so they are described by
+/// their contents. Types and locators are uniqued, so their identity
+/// describes them.
+static void appendConstraintToKey(std::string &key, Constraint *constraint) {
+  auto kind = constraint->getKind();
+  appendToKey(key, kind);
+  appendToKey(key, constraint->getLocator());
+  appendToKey(key, constraint->isFavored());
+  appendToKey(key, constraint->shouldRememberChoice());
+
+  // Fixes are rare; don't bother describing them.
+  if (constraint->getFix()) {
+    appendToKey(key, constraint);
+    return;
+  }
+
+  if (kind == ConstraintKind::Disjunction) {
+    auto nested = constraint->getNestedConstraints();
+    appendToKey(key, nested.size());
+    for (auto nestedConstraint : nested)
+      appendConstraintToKey(key, nestedConstraint);
+    return;
+  }
+
+  appendToKey(key, constraint->getFirstType().getPointer());
+  if (kind == ConstraintKind::BindOverload) {
+    auto choice = constraint->getOverloadChoice();
+    appendToKey(key, choice.getKind());
+    appendToKey(key, choice.getBaseType().getPointer());
+    appendToKey(key, choice.getOpaqueChoiceSimple());
+    appendToKey(key, choice.isSpecialized());
+    if (choice.isDecl())
+      appendToKey(key, choice.getFunctionRefKind());
+    return;
+  }
+
+  appendToKey(key, constraint->getSecondType().getPointer());
+  if (Constraint::hasMember(kind)) {
+    appendToKey(key, constraint->getMember().getOpaqueValue());
+    appendToKey(key, constraint->getFunctionRefKind());
+  }
+
+  auto restriction = constraint->getRestriction();
+  appendToKey(key, restriction.hasValue());
+  if (restriction)
+    appendToKey(key, *restriction);
+}
+
+std::string ConstraintSystem::getComponentCacheKey(
+              FreeTypeVariableBinding allowFreeTypeVariables) {
+  // Components without disjunctions are solved without much backtracking.
+  bool anyDisjunctions = false;
+  for (auto &constraint : InactiveConstraints) {
+    if (constraint.getKind() == ConstraintKind::Disjunction) {
+      anyDisjunctions = true;
+      break;
+    }
+  }
+  if (!anyDisjunctions)
+    return std::string();
+
+  std::string key;
+  appendToKey(key, allowFreeTypeVariables);
+  appendToKey(key, solverState->recordFixes);
+
+  // The scores of partial solutions are relative to the current score. The
+  // best score only prunes solutions, so it is checked when an entry is
+  // reused instead; see \c prunesNoMoreThan().
+  appendToKey(key, CurrentScore);
+
+  SmallVector<TypeVariableType *, 16> typeVars;
+  for (auto &constraint : InactiveConstraints) {
+    appendConstraintToKey(key, &constraint);
+    typeVars.append(constraint.getTypeVariables().begin(),
+                    constraint.getTypeVariables().end());
+  }
+
+  // The search depends on the state of the type variables of the component,
+  // of the ones its constraints refer to, and of the ones in their fixed
+  // types. The other type variables which were bound along the current path
+  // don't matter, so the component can be reused on other paths.
+  for (auto typeVar : TypeVariables) {
+    if (!getFixedType(typeVar))
+      typeVars.push_back(typeVar);
+  }
+
+  llvm::SmallPtrSet<TypeVariableType *, 16> visited;
+  while (!typeVars.empty()) {
+    auto typeVar = typeVars.pop_back_val();
+    if (!visited.insert(typeVar).second)
+      continue;
+
+    auto rep = getRepresentative(typeVar);
+    Type fixed = getFixedType(typeVar);
+    appendToKey(key, typeVar);
+    appendToKey(key, rep);
+    appendToKey(key, fixed.getPointer());
+
+    typeVars.push_back(rep);
+    if (fixed)
+      fixed->getTypeVariables(typeVars);
+  }
+
+  return key;
+}
+
+/// Whether the solutions found while \p cachedBest was the best score
+/// include all of the ones that would be found while \p best is.
+static bool prunesNoMoreThan(const Optional<Score> &cachedBest,
+                             const Optional<Score> &best) {
+  return !cachedBest || (best && *best <= *cachedBest);
+}
+
+/// Copy all of the information in the given solution.
+static Solution copySolution(ConstraintSystem &cs, const Solution &solution) {
+  Solution copy(cs, solution.getFixedScore());
+  copy.typeBindings = solution.typeBindings;
+  copy.overloadChoices = solution.overloadChoices;
+  copy.ConstraintRestrictions = solution.ConstraintRestrictions;
+  copy.Fixes = solution.Fixes;
+  copy.DisjunctionChoices = solution.DisjunctionChoices;
+  copy.OpenedTypes = solution.OpenedTypes;
+  copy.OpenedExistentialTypes = solution.OpenedExistentialTypes;
+  return copy;
+}
+
+Solution ConstraintSystem::getComponentDelta(const Solution &solution) {
+  // finalize() records the whole path leading to a solution, but only the
+  // parts decided within the component are valid on another path. Fixes
+  // are already limited to the component by the partial solution scope.
+  Solution delta = copySolution(*this, solution);
+
+  for (auto typeVar : TypeVariables) {
+    if (getFixedType(typeVar))
+      delta.typeBindings.erase(typeVar);
+  }
+
+  for (auto resolved = resolvedOverloadSets;
+       resolved; resolved = resolved->Previous)
+    delta.overloadChoices.erase(resolved->Locator);
+
+  for (auto &restriction : ConstraintRestrictions) {
+    using std::get;
+    CanType first = simplifyType(get<0>(restriction))->getCanonicalType();
+    CanType second = simplifyType(get<1>(restriction))->getCanonicalType();
+    delta.ConstraintRestrictions.erase({first, second});
+  }
+
+  for (auto &choice : DisjunctionChoices)
+    delta.DisjunctionChoices.erase(choice.first);
+
+  for (auto &opened : OpenedTypes)
+    delta.OpenedTypes.erase(opened.first);
+
+  for (auto &openedExistential : OpenedExistentialTypes)
+    delta.OpenedExistentialTypes.erase(openedExistential.first);
+
+  return delta;
+}
+
 bool ConstraintSystem::solveRec(SmallVectorImpl<Solution> &solutions,
                                 FreeTypeVariableBinding allowFreeTypeVariables){
   // If we already failed, or simplification fails, we're done.
@@ -1406,7 +1589,31 @@ bool ConstraintSystem::solveRec(SmallVectorImpl<Solution> &solutions,
       log.indent(solverState->depth * 2) << "(solving component #" 
                                          << component << "\n";
     }
-    {
+
+    // If the same component was already solved in the same state along
+    // another path, reuse its partial solutions.
+    std::string cacheKey = getComponentCacheKey(allowFreeTypeVariables);
+    auto cached = solverState->ComponentSolutions.end();
+    if (!cacheKey.empty())
+      cached = solverState->ComponentSolutions.find(cacheKey);
+    bool reused = cached != solverState->ComponentSolutions.end() &&
+                  prunesNoMoreThan(cached->second.BestScore,
+                                   solverState->BestScore);
+
+    if (reused) {
+      auto &cachedSolutions = cached->second.Solutions;
+      ++solverState->NumComponentsReused;
+      if (TC.getLangOpts().DebugConstraintSolver) {
+        auto &log = getASTContext().TypeCheckerDebug->getStream();
+        log.indent(solverState->depth * 2)
+          << "(reusing " << cachedSolutions.size()
+          << " partial solutions)\n";
+      }
+
+      for (auto &solution : cachedSolutions)
+        partialSolutions[component].push_back(copySolution(*this, solution));
+      failed = cachedSolutions.empty();
+    } else {
       // Introduce a scope for this partial solution.
       SolverScope scope(*this);
       llvm::SaveAndRestore<SolverScope *> 
@@ -1416,6 +1623,10 @@ bool ConstraintSystem::solveRec(SmallVectorImpl<Solution> &solutions,
                                allowFreeTypeVariables);
     }
 
+    // Only remember complete results.
+    bool shouldCache = !reused && !cacheKey.empty() &&
+                       !getExpressionTooComplex();
+
     // Put the constraints back into their original bucket.
     auto &bucket = constraintBuckets[component];
     bucket.splice(bucket.end(), InactiveConstraints);
@@ -1426,6 +1637,12 @@ bool ConstraintSystem::solveRec(SmallVectorImpl<Solution> &solutions,
         log.indent(solverState->depth * 2) << "failed component #" 
                                            << component << ")\n";
       }
+
+      if (shouldCache) {
+        auto &entry = solverState->ComponentSolutions[cacheKey];
+        entry.BestScore = PreviousBestScore;
+        entry.Solutions.clear();
+      }
       
       TypeVariables = std::move(allTypeVariables);
       returnAllConstraints();
@@ -1445,9 +1662,19 @@ bool ConstraintSystem::solveRec(SmallVectorImpl<Solution> &solutions,
     TypeVariables = std::move(allTypeVariables);
 
     // For each of the partial solutions, subtract off the current score.
-    // It doesn't contribute.
-    for (auto &solution : partialSolutions[component])
-      solution.getFixedScore() -= CurrentScore;
+    // It doesn't contribute. Reused solutions have already been adjusted.
+    if (!reused) {
+      for (auto &solution : partialSolutions[component])
+        solution.getFixedScore() -= CurrentScore;
+    }
+
+    if (shouldCache) {
+      auto &entry = solverState->ComponentSolutions[cacheKey];
+      entry.BestScore = PreviousBestScore;
+      entry.Solutions.clear();
+      for (auto &solution : partialSolutions[component])
+        entry.Solutions.push_back(getComponentDelta(solution));
+    }
 
     // Restore the previous best score.
     solverState->BestScore = PreviousBestScore;
@@ -1702,7 +1929,7 @@ bool ConstraintSystem::solveSimplified(
       break;
     
     // If the expression was deemed "too complex", stop now and salvage.
-    if (getExpressionTooComplex())
+    if (checkSolverLimits())
       break;
 
     // Try to solve the system with this option in the disjunction.
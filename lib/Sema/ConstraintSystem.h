@@ -33,7 +33,9 @@
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/TimeValue.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstddef>
 #include <functional>
@@ -915,9 +917,15 @@ private:
   unsigned TypeCounter = 0;
   
   /// \brief The expression being solved has exceeded the solver's memory
-  /// threshold.
+  /// threshold or time budget.
   bool expressionExceededThreshold = false;
 
+  /// \brief When solving started, for enforcing the solver's time budget.
+  llvm::sys::TimeValue StartTime = llvm::sys::TimeValue::now();
+
+  /// \brief The number of solver states explored by all solver attempts.
+  unsigned TotalStatesExplored = 0;
+
   /// \brief Cached member lookups.
   llvm::DenseMap<std::pair<Type, DeclName>, Optional<LookupResult>>
     MemberLookups;
@@ -1036,6 +1044,24 @@ private:
     /// Refers to the innermost partial solution scope.
     SolverScope *PartialSolutionScope = nullptr;
 
+    /// The partial solutions of a connected component which has already been
+    /// solved along another path.
+    struct CachedComponent {
+      /// The best score when the component was solved. Solutions which were
+      /// worse than it have been pruned.
+      Optional<Score> BestScore;
+
+      /// The partial solutions, or none if the component had no solutions.
+      ///
+      /// Each partial solution only describes the decisions made within its
+      /// component; see \c getComponentDelta().
+      std::vector<Solution> Solutions;
+    };
+
+    /// The connected components which have already been solved, keyed by
+    /// \c getComponentCacheKey().
+    llvm::StringMap<CachedComponent> ComponentSolutions;
+
     // Statistics
     #define CS_STATISTIC(Name, Description) unsigned Name = 0;
     #include "ConstraintSolverStats.def"
@@ -1975,6 +2001,19 @@ private:
   /// \returns true if an error occurred, false otherwise.
   bool solveSimplified(SmallVectorImpl<Solution> &solutions,
                        FreeTypeVariableBinding allowFreeTypeVariables);
+
+  /// \brief Compute a key which identifies the connected component currently
+  /// being solved, along with all of the state that solving it depends on.
+  ///
+  /// \returns the key, or an empty string if the component is cheap enough
+  /// to solve that it is not worth caching.
+  std::string
+  getComponentCacheKey(FreeTypeVariableBinding allowFreeTypeVariables);
+
+  /// \brief Copy the parts of the given partial solution which were decided
+  /// while solving its component, leaving out everything that was already
+  /// decided along the current path.
+  Solution getComponentDelta(const Solution &solution);
  public:
   /// \brief Solve the system of constraints.
   ///
@@ -2099,6 +2138,23 @@ public:
     return expressionExceededThreshold;
   }
 
+  /// \brief Check whether the solver has used more memory or time than it is
+  /// allowed to for this expression, and if so, mark the expression as too
+  /// complex.
+  ///
+  /// \returns true if the expression is too complex.
+  bool checkSolverLimits();
+
+  /// \brief Returns the time spent since the constraint system was created,
+  /// in milliseconds.
+  double getElapsedTimeMS() const {
+    auto elapsed = llvm::sys::TimeValue::now() - StartTime;
+    return elapsed.seconds() * 1000.0 + elapsed.nanoseconds() / 1000000.0;
+  }
+
+  /// \brief Returns the number of solver states explored so far.
+  unsigned getTotalStatesExplored() const { return TotalStatesExplored; }
+
   LLVM_ATTRIBUTE_DEPRECATED(
       void dump() LLVM_ATTRIBUTE_USED,
       "only for use within the debugger");
@@ -0,0 +1,114 @@
+//===--- ExpressionTimingReport.cpp - Expression type-checking times ------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Sema/ExpressionTimingReport.h"
+#include "swift/Basic/JSONSerialization.h"
+#include "swift/Basic/SourceManager.h"
+#include <algorithm>
+
+using namespace swift;
+
+namespace {
+  /// An entry of the report, with its location resolved.
+  struct ReportedExpression {
+    std::string File;
+    uint32_t Line = 0;
+    uint32_t Column = 0;
+    double WallTimeMS = 0;
+    uint32_t StatesExplored = 0;
+    uint64_t SolverMemory = 0;
+    bool TooComplex = false;
+  };
+
+  struct Report {
+    uint32_t TotalExpressions = 0;
+    double TotalWallTimeMS = 0;
+    std::vector<ReportedExpression> Expressions;
+  };
+}
+
+namespace swift {
+namespace json {
+  template<>
+  struct ObjectTraits<ReportedExpression> {
+    static void mapping(Output &out, ReportedExpression &value) {
+      out.mapRequired("file", value.File);
+      out.mapRequired("line", value.Line);
+      out.mapRequired("column", value.Column);
+      out.mapRequired("wall-time-ms", value.WallTimeMS);
+      out.mapRequired("states-explored", value.StatesExplored);
+      out.mapRequired("solver-memory", value.SolverMemory);
+      out.mapRequired("too-complex", value.TooComplex);
+    }
+  };
+
+  template<>
+  struct ArrayTraits<std::vector<ReportedExpression>> {
+    static size_t size(Output &out, std::vector<ReportedExpression> &seq) {
+      return seq.size();
+    }
+
+    static ReportedExpression &element(Output &out,
+                                       std::vector<ReportedExpression> &seq,
+                                       size_t index) {
+      if (index >= seq.size())
+        seq.resize(index+1);
+      return seq[index];
+    }
+  };
+
+  template<>
+  struct ObjectTraits<Report> {
+    static void mapping(Output &out, Report &value) {
+      out.mapRequired("total-expressions", value.TotalExpressions);
+      out.mapRequired("total-wall-time-ms", value.TotalWallTimeMS);
+      out.mapRequired("expressions", value.Expressions);
+    }
+  };
+}
+}
+
+void ExpressionTimingReport::writeJSON(raw_ostream &os, SourceManager &SM,
+                                       unsigned maxEntries) const {
+  Report report;
+  report.TotalExpressions = Entries.size();
+  for (auto &entry : Entries)
+    report.TotalWallTimeMS += entry.WallTimeMS;
+
+  std::vector<const Entry *> sorted;
+  sorted.reserve(Entries.size());
+  for (auto &entry : Entries)
+    sorted.push_back(&entry);
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const Entry *lhs, const Entry *rhs) {
+    return lhs->WallTimeMS > rhs->WallTimeMS;
+  });
+  if (sorted.size() > maxEntries)
+    sorted.resize(maxEntries);
+
+  for (auto *entry : sorted) {
+    ReportedExpression expr;
+    if (entry->Loc.isValid()) {
+      expr.File = SM.getBufferIdentifierForLoc(entry->Loc);
+      std::tie(expr.Line, expr.Column) = SM.getLineAndColumn(entry->Loc);
+    }
+    expr.WallTimeMS = entry->WallTimeMS;
+    expr.StatesExplored = entry->StatesExplored;
+    expr.SolverMemory = entry->SolverMemory;
+    expr.TooComplex = entry->TooComplex;
+    report.Expressions.push_back(std::move(expr));
+  }
+
+  json::Output out(os);
+  out << report;
+  os << '\n';
+}
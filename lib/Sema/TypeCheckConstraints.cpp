@@ -27,6 +27,7 @@
 #include "swift/AST/TypeCheckerDebugConsumer.h"
 #include "swift/Basic/Fallthrough.h"
 #include "swift/Parse/Lexer.h"
+#include "swift/Sema/ExpressionTimingReport.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/FoldingSet.h"
@@ -1494,6 +1495,30 @@ namespace {
 }
 
 #pragma mark High-level entry points
+namespace {
+  /// Records the cost of type-checking an expression in the type checker's
+  /// expression timing report, if it has one.
+  class ExpressionTimingRecorder {
+    ConstraintSystem &CS;
+    ExpressionTimingReport *Report;
+    SourceLoc Loc;
+
+  public:
+    ExpressionTimingRecorder(ConstraintSystem &cs, Expr *expr)
+      : CS(cs), Report(cs.getTypeChecker().getExpressionTimingReport()),
+        Loc(expr->getLoc()) {}
+
+    ~ExpressionTimingRecorder() {
+      if (!Report)
+        return;
+
+      Report->record({Loc, CS.getElapsedTimeMS(), CS.getTotalStatesExplored(),
+                      CS.getASTContext().getSolverMemory(),
+                      CS.getExpressionTooComplex()});
+    }
+  };
+} // end anonymous namespace
+
 bool TypeChecker::typeCheckExpression(Expr *&expr, DeclContext *dc,
                                       TypeLoc convertType,
                                       ContextualTypePurpose convertTypePurpose,
@@ -1508,6 +1533,7 @@ bool TypeChecker::typeCheckExpression(Expr *&expr, DeclContext *dc,
     csOptions |= ConstraintSystemFlags::PreferForceUnwrapToOptional;
   ConstraintSystem cs(*this, dc, csOptions);
   cs.baseCS = baseCS;
+  ExpressionTimingRecorder timingRecorder(cs, expr);
   CleanupIllFormedExpressionRAII cleanup(Context, expr);
   ExprCleanser cleanup2(expr);
 
@@ -537,7 +537,8 @@ void swift::typeCheckExternalDefinitions(SourceFile &SF) {
 void swift::performTypeChecking(SourceFile &SF, TopLevelContext &TLC,
                                 OptionSet<TypeCheckingFlags> Options,
                                 unsigned StartElem,
-                                unsigned WarnLongFunctionBodies) {
+                                unsigned WarnLongFunctionBodies,
+                                ExpressionTimingReport *ExprTimingReport) {
   if (SF.ASTStage == SourceFile::TypeChecked)
     return;
 
@@ -556,6 +557,7 @@ void swift::performTypeChecking(SourceFile &SF, TopLevelContext &TLC,
     SharedTimer timer("Type checking / Semantic analysis");
 
     TC.setWarnLongFunctionBodies(WarnLongFunctionBodies);
+    TC.setExpressionTimingReport(ExprTimingReport);
     if (Options.contains(TypeCheckingFlags::DebugTimeFunctionBodies))
       TC.enableDebugTimeFunctionBodies();
 
@@ -36,6 +36,7 @@
 namespace swift {
 
 class ArchetypeBuilder;
+class ExpressionTimingReport;
 class GenericTypeResolver;
 class NominalTypeDecl;
 class NormalProtocolConformance;
@@ -615,6 +616,9 @@ private:
   /// to llvm::errs().
   bool DebugTimeFunctionBodies = false;
 
+  /// If non-null, the cost of type-checking each expression is recorded here.
+  ExpressionTimingReport *ExprTimingReport = nullptr;
+
   /// Indicate that the type checker is checking code that will be
   /// immediately executed. This will suppress certain warnings
   /// when executing scripts.
@@ -645,6 +649,15 @@ public:
     WarnLongFunctionBodies = timeInMS;
   }
 
+  /// Record the cost of type-checking each expression in \p report.
+  void setExpressionTimingReport(ExpressionTimingReport *report) {
+    ExprTimingReport = report;
+  }
+
+  ExpressionTimingReport *getExpressionTimingReport() const {
+    return ExprTimingReport;
+  }
+
   bool getInImmediateMode() {
     return InImmediateMode;
   }
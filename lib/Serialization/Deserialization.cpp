@@ -434,6 +434,7 @@ Pattern *ModuleFile::maybeReadPattern() {
 ProtocolConformanceRef ModuleFile::readConformance(llvm::BitstreamCursor &Cursor){
   using namespace decls_block;
 
+  DeserializationScope scope(*this);
   SmallVector<uint64_t, 16> scratch;
 
   auto next = Cursor.advance(AF_DontPopBlockAtEnd);
@@ -527,9 +528,14 @@ ProtocolConformanceRef ModuleFile::readConformance(llvm::BitstreamCursor &Cursor
 NormalProtocolConformance *ModuleFile::readNormalConformance(
                              NormalConformanceID conformanceID) {
   auto &conformanceEntry = NormalConformances[conformanceID-1];
+  if (auto *published = conformanceEntry.getPublished())
+    return published;
+
+  DeserializationScope scope(*this);
   if (conformanceEntry.isComplete()) {
     return conformanceEntry.get();
   }
+  DeserializationScope::publishLater(conformanceEntry);
 
   using namespace decls_block;
 
@@ -601,6 +607,7 @@ NormalProtocolConformance *ModuleFile::readNormalConformance(
 
 Optional<Substitution>
 ModuleFile::maybeReadSubstitution(llvm::BitstreamCursor &cursor) {
+  DeserializationScope scope(*this);
   BCOffsetRAII lastRecordOffset(cursor);
 
   auto entry = cursor.advance(AF_DontPopBlockAtEnd);
@@ -658,6 +665,7 @@ GenericParamList *ModuleFile::maybeReadGenericParams(DeclContext *DC,
 
   assert(DC && "need a context for the decls in the list");
 
+  DeserializationScope scope(*this);
   BCOffsetRAII lastRecordOffset(Cursor);
   SmallVector<uint64_t, 8> scratch;
   StringRef blobData;
@@ -714,6 +722,7 @@ GenericParamList *ModuleFile::maybeReadGenericParams(DeclContext *DC,
       } else {
         typeOrOffset = archetypes[index];
       }
+      DeserializationScope::publishLater(typeOrOffset);
     }
 
     haveMappedArchetypes = true;
@@ -1423,6 +1432,9 @@ Identifier ModuleFile::getIdentifier(IdentifierID IID) {
 
   assert(!IdentifierData.empty() && "no identifier data in module");
 
+  // The identifier table of the context isn't thread-safe.
+  DeserializationScope scope(*this);
+
   StringRef rawStrPtr = IdentifierData.substr(identRecord.Offset);
   size_t terminatorOffset = rawStrPtr.find('\0');
   assert(terminatorOffset != StringRef::npos &&
@@ -1434,9 +1446,13 @@ Identifier ModuleFile::getIdentifier(IdentifierID IID) {
 DeclContext *ModuleFile::getLocalDeclContext(DeclContextID DCID) {
   assert(DCID != 0 && "invalid local DeclContext ID 0");
   auto &declContextOrOffset = LocalDeclContexts[DCID-1];
+  if (auto *published = declContextOrOffset.getPublished())
+    return published;
 
+  DeserializationScope scope(*this);
   if (declContextOrOffset.isComplete())
     return declContextOrOffset;
+  DeserializationScope::publishLater(declContextOrOffset);
 
   BCOffsetRAII restoreOffset(DeclTypeCursor);
   DeclTypeCursor.JumpToBit(declContextOrOffset);
@@ -1520,9 +1536,13 @@ DeclContext *ModuleFile::getDeclContext(DeclContextID DCID) {
 
   assert(DCID <= DeclContexts.size() && "invalid DeclContext ID");
   auto &declContextOrOffset = DeclContexts[DCID-1];
+  if (auto *published = declContextOrOffset.getPublished())
+    return published;
 
+  DeserializationScope scope(*this);
   if (declContextOrOffset.isComplete())
     return declContextOrOffset;
+  DeserializationScope::publishLater(declContextOrOffset);
 
   BCOffsetRAII restoreOffset(DeclTypeCursor);
   DeclTypeCursor.JumpToBit(declContextOrOffset);
@@ -1592,6 +1612,8 @@ Module *ModuleFile::getModule(ArrayRef<Identifier> name) {
   if (name.empty() || name.front().empty())
     return getContext().TheBuiltinModule;
 
+  DeserializationScope scope(*this);
+
   // FIXME: duplicated from NameBinder::getModule
   if (name.size() == 1 &&
       name.front() == FileContext->getParentModule()->getName()) {
@@ -1827,9 +1849,13 @@ Decl *ModuleFile::getDecl(DeclID DID, Optional<DeclContext *> ForcedContext) {
 
   assert(DID <= Decls.size() && "invalid decl ID");
   auto &declOrOffset = Decls[DID-1];
+  if (Decl *published = declOrOffset.getPublished())
+    return published;
 
+  DeserializationScope scope(*this);
   if (declOrOffset.isComplete())
     return declOrOffset;
+  DeserializationScope::publishLater(declOrOffset);
 
   BCOffsetRAII restoreOffset(DeclTypeCursor);
   DeclTypeCursor.JumpToBit(declOrOffset);
@@ -3405,9 +3431,13 @@ Type ModuleFile::getType(TypeID TID) {
 
   assert(TID <= Types.size() && "invalid decl ID");
   auto &typeOrOffset = Types[TID-1];
+  if (Type published = typeOrOffset.getPublished())
+    return published;
 
+  DeserializationScope scope(*this);
   if (typeOrOffset.isComplete())
     return typeOrOffset;
+  DeserializationScope::publishLater(typeOrOffset);
 
   BCOffsetRAII restoreOffset(DeclTypeCursor);
   DeclTypeCursor.JumpToBit(typeOrOffset);
@@ -4130,6 +4160,7 @@ Type ModuleFile::getType(TypeID TID) {
 void ModuleFile::loadAllMembers(Decl *D, uint64_t contextData) {
   PrettyStackTraceDecl trace("loading members for", D);
 
+  DeserializationScope scope(*this);
   BCOffsetRAII restoreOffset(DeclTypeCursor);
   DeclTypeCursor.JumpToBit(contextData);
   SmallVector<Decl *, 16> members;
@@ -4163,6 +4194,7 @@ ModuleFile::loadAllConformances(const Decl *D, uint64_t contextData,
   std::tie(numConformances, bitPosition)
     = decodeLazyConformanceContextData(contextData);
 
+  DeserializationScope scope(*this);
   BCOffsetRAII restoreOffset(DeclTypeCursor);
   DeclTypeCursor.JumpToBit(bitPosition);
 
@@ -4184,6 +4216,7 @@ void ModuleFile::finishNormalConformance(NormalProtocolConformance *conformance,
   using namespace decls_block;
 
   // Find the conformance record.
+  DeserializationScope scope(*this);
   BCOffsetRAII restoreOffset(DeclTypeCursor);
   DeclTypeCursor.JumpToBit(contextData);
   auto entry = DeclTypeCursor.advance();
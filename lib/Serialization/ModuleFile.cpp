@@ -23,6 +23,7 @@
 #include "swift/Serialization/SerializedModuleLoader.h"
 
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/PrettyStackTrace.h"
@@ -670,7 +671,8 @@ bool ModuleFile::readCommentBlock(llvm::BitstreamCursor &cursor) {
         DeclCommentTable = readDeclCommentTable(scratch, blobData);
         break;
       case comment_block::GROUP_NAMES:
-        GroupNamesMap = readGroupTable(scratch, blobData);
+        GroupNamesMap.set(this, &ModuleFile::readGroupTable, scratch,
+                          blobData);
         break;
       default:
         // Unknown index kind, which this version of the compiler won't use.
@@ -748,6 +750,35 @@ static bool isTargetTooNew(const llvm::Triple &moduleTarget,
   return ctxTarget.isOSVersionLT(major, minor, micro);
 }
 
+/// The entries to publish when the outermost deserialization scope of this
+/// thread ends, or null if the thread isn't deserializing.
+static LLVM_THREAD_LOCAL std::vector<ModuleFile::SerializedBase *> *
+PendingPublication = nullptr;
+
+ModuleFile::DeserializationScope::DeserializationScope(const ModuleFile &MF)
+  : Mutex(MF.getContext().getDeserializationMutex()),
+    IsOutermost(!PendingPublication) {
+  // Nested scopes are entered with the lock already held by this thread.
+  if (IsOutermost) {
+    Mutex.lock();
+    PendingPublication = &Pending;
+  }
+}
+
+ModuleFile::DeserializationScope::~DeserializationScope() {
+  if (!IsOutermost)
+    return;
+  for (auto *entry : Pending)
+    entry->publish();
+  PendingPublication = nullptr;
+  Mutex.unlock();
+}
+
+void ModuleFile::DeserializationScope::publishLater(SerializedBase &entry) {
+  assert(PendingPublication && "not in a deserialization scope");
+  PendingPublication->push_back(&entry);
+}
+
 ModuleFile::ModuleFile(
     std::unique_ptr<llvm::MemoryBuffer> moduleInputBuffer,
     std::unique_ptr<llvm::MemoryBuffer> moduleDocInputBuffer,
@@ -1238,6 +1269,7 @@ void ModuleFile::getImportedModules(
 }
 
 void ModuleFile::getImportDecls(SmallVectorImpl<Decl *> &Results) {
+  DeserializationScope scope(*this);
   if (!Bits.ComputedImportDecls) {
     ASTContext &Ctx = getContext();
     for (auto &Dep : Dependencies) {
@@ -1525,6 +1557,8 @@ ModuleFile::getLocalTypeDecls(SmallVectorImpl<TypeDecl *> &results) {
   if (!LocalTypeDecls)
     return;
 
+  DeserializationScope scope(*this);
+
   for (auto entry : LocalTypeDecls->data()) {
     auto DeclID = entry.first;
     auto TD = cast<TypeDecl>(getDecl(DeclID));
@@ -1558,6 +1592,9 @@ Optional<CommentInfo> ModuleFile::getCommentForDecl(const Decl *D) const {
   if (D->isImplicit())
     return None;
 
+  // Computing the USR may deserialize more of the module.
+  DeserializationScope scope(*this);
+
   if (auto *ED = dyn_cast<ExtensionDecl>(D)) {
     // Compute the USR.
     llvm::SmallString<128> USRBuffer;
@@ -1659,6 +1696,8 @@ ModuleFile::getCommentForDeclByUSR(StringRef USR) const {
   if (!DeclCommentTable)
     return None;
 
+  // Reading a comment allocates it in the ASTContext.
+  DeserializationScope scope(*this);
   auto I = DeclCommentTable->find(USR);
   if (I == DeclCommentTable->end())
     return None;
@@ -1675,6 +1714,7 @@ ModuleFile::getGroupNameByUSR(StringRef USR) const {
 }
 
 Identifier ModuleFile::getDiscriminatorForPrivateValue(const ValueDecl *D) {
+  DeserializationScope scope(*this);
   Identifier discriminator = PrivateDiscriminatorsByValue.lookup(D);
   assert(!discriminator.empty() && "no discriminator found for decl");
   return discriminator;
@@ -17,8 +17,10 @@
 #include "swift/AST/DiagnosticsSema.h"
 #include "swift/Basic/STLExtras.h"
 #include "swift/Basic/SourceManager.h"
+#include "swift/Basic/Timer.h"
 #include "swift/Basic/Version.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Debug.h"
@@ -28,6 +30,36 @@ using namespace swift;
 
 namespace {
 typedef std::pair<Identifier, SourceLoc> AccessPathElem;
+
+/// Times the loading of a module, without the modules it loads in turn, so
+/// that the time spent loading each module is only counted once.
+class ModuleLoadTimer {
+  static LLVM_THREAD_LOCAL ModuleLoadTimer *Innermost;
+
+  ModuleLoadTimer *Outer;
+  std::string Name;
+  Optional<SharedTimer> Timer;
+
+public:
+  explicit ModuleLoadTimer(StringRef moduleName)
+    : Outer(Innermost), Name(("Load module " + moduleName).str()) {
+    // Stop the timer of the module that imports this one; timers with the
+    // same name add up, so it picks up again where it left off.
+    if (Outer)
+      Outer->Timer.reset();
+    Innermost = this;
+    Timer.emplace(Name);
+  }
+
+  ~ModuleLoadTimer() {
+    Timer.reset();
+    Innermost = Outer;
+    if (Outer)
+      Outer->Timer.emplace(Outer->Name);
+  }
+};
+
+LLVM_THREAD_LOCAL ModuleLoadTimer *ModuleLoadTimer::Innermost = nullptr;
 } // end unnamed namespace
 
 // Defined out-of-line so that we can see ~ModuleFile.
@@ -46,8 +78,14 @@ openModuleFiles(StringRef DirName, StringRef ModuleFilename,
   // module documentation file.
   Scratch.clear();
   llvm::sys::path::append(Scratch, DirName, ModuleFilename);
+  // Module files don't need to be null-terminated. LLVM already maps large
+  // files, but only when there is room for the terminator after the end of
+  // the file; this lets files whose size is an exact multiple of the page
+  // size be memory-mapped as well.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> ModuleOrErr =
-    llvm::MemoryBuffer::getFile(StringRef(Scratch.data(), Scratch.size()));
+    llvm::MemoryBuffer::getFile(StringRef(Scratch.data(), Scratch.size()),
+                                /*FileSize=*/-1,
+                                /*RequiresNullTerminator=*/false);
   if (!ModuleOrErr)
     return ModuleOrErr.getError();
 
@@ -56,7 +94,9 @@ openModuleFiles(StringRef DirName, StringRef ModuleFilename,
   Scratch.clear();
   llvm::sys::path::append(Scratch, DirName, ModuleDocFilename);
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> ModuleDocOrErr =
-    llvm::MemoryBuffer::getFile(StringRef(Scratch.data(), Scratch.size()));
+    llvm::MemoryBuffer::getFile(StringRef(Scratch.data(), Scratch.size()),
+                                /*FileSize=*/-1,
+                                /*RequiresNullTerminator=*/false);
   if (!ModuleDocOrErr &&
       ModuleDocOrErr.getError() != std::errc::no_such_file_or_directory) {
     return ModuleDocOrErr.getError();
@@ -362,6 +402,10 @@ Module *SerializedModuleLoader::loadModule(SourceLoc importLoc,
   auto moduleID = path[0];
   bool isFramework = false;
 
+  // Give every module its own timer, so that the expensive imports show up
+  // separately.
+  ModuleLoadTimer timer(moduleID.first.str());
+
   std::unique_ptr<llvm::MemoryBuffer> moduleInputBuffer;
   std::unique_ptr<llvm::MemoryBuffer> moduleDocInputBuffer;
   // First see if we find it in the registered memory buffers.
@@ -16,17 +16,302 @@
 
 #include "swift/Runtime/HeapObject.h"
 #include "swift/Runtime/Heap.h"
+#include "swift/Runtime/Mutex.h"
+#include "swift/Basic/Lazy.h"
 #include "Private.h"
 #include "swift/Runtime/Debug.h"
 #include <stdlib.h>
+#if SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR
+#include <atomic>
+#include <pthread.h>
+#include <string.h>
+#endif
 
 using namespace swift;
 
+/// The alignment malloc guarantees on all supported platforms.
+static const size_t MallocAlignMask = 2 * sizeof(void*) - 1;
+
+#if SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR
+
+// The slab allocator serves small allocations out of per-thread free lists,
+// one per size class. Size classes are multiples of SlabAllocatorAlignment.
+//
+// A thread that runs out of blocks of some size class refills its list
+// with a batch from a central free list, which in turn carves new blocks out
+// of large slabs. A thread whose list grows too long returns a batch to the
+// central list, as does a thread that exits. Slabs are never returned to the
+// system.
+//
+// Slabs are aligned to their size, and a two-level map from slab addresses
+// to size classes lets _swift_slabAllocSize find the size of a block from its
+// address alone.
+
+namespace {
+  const size_t NumSizeClasses = SlabAllocatorMaxSize / SlabAllocatorAlignment;
+
+  /// The size, and alignment, of the slabs carved up by the central free
+  /// lists.
+  const unsigned SlabShift = 16;
+  const size_t SlabSize = size_t(1) << SlabShift;
+
+  /// The slab map covers the low AddressBits of the address space, which is
+  /// all of it on 32-bit platforms and all of user space on the 64-bit ones.
+  const unsigned AddressBits = sizeof(void *) == 8 ? 48 : 32;
+  const unsigned SlabMapLeafBits = 16;
+  const size_t SlabMapLeafSize = size_t(1) << SlabMapLeafBits;
+  const size_t SlabMapRootSize =
+      size_t(1) << (AddressBits - SlabShift - SlabMapLeafBits);
+
+  /// The number of blocks moved between a thread and the central free
+  /// lists at once.
+  const unsigned TransferBatchSize = 32;
+
+  /// The most blocks of one size class that a thread keeps around.
+  const unsigned MaxThreadCachedBlocks = 2 * TransferBatchSize;
+
+  struct FreeBlock {
+    FreeBlock *Next;
+  };
+
+  /// A thread's cache of free blocks. This must be trivially constructible
+  /// and destructible to live in thread-local storage.
+  struct ThreadCache {
+    FreeBlock *FreeLists[NumSizeClasses];
+    unsigned Counts[NumSizeClasses];
+
+    /// Has the cache been registered to be flushed when the thread exits?
+    bool Registered;
+  };
+
+  /// The free list shared by all threads for one size class.
+  struct CentralFreeList {
+    StaticMutex Lock;
+    FreeBlock *Head = nullptr;
+    char *SlabNext = nullptr;
+    char *SlabEnd = nullptr;
+  };
+} // end anonymous namespace
+
+static CentralFreeList CentralFreeLists[NumSizeClasses];
+
+/// Maps each slab to its size class plus one; zero means the address isn't
+/// part of a slab. Leaves are allocated when the first slab in their part of
+/// the address space is, and are never freed.
+static std::atomic<std::atomic<uint8_t> *> SlabMap[SlabMapRootSize];
+
+static SWIFT_RUNTIME_ATTRIBUTE_THREAD_LOCAL ThreadCache CurrentThreadCache;
+
+static size_t getSizeClass(size_t size) {
+  assert(size <= SlabAllocatorMaxSize);
+  // Zero-sized allocations share the smallest size class.
+  return size ? (size - 1) / SlabAllocatorAlignment : 0;
+}
+
+static size_t getSizeClassBlockSize(size_t sizeClass) {
+  return (sizeClass + 1) * SlabAllocatorAlignment;
+}
+
+/// Record that the slab at \p slab serves the given size class.
+static void registerSlab(char *slab, size_t sizeClass) {
+  uintptr_t index = uintptr_t(slab) >> SlabShift;
+  uintptr_t rootIndex = index >> SlabMapLeafBits;
+  if (rootIndex >= SlabMapRootSize)
+    swift::crash("Slab allocated outside of the supported address range.");
+
+  auto &root = SlabMap[rootIndex];
+  std::atomic<uint8_t> *leaf = root.load(std::memory_order_acquire);
+  if (!leaf) {
+    auto newLeaf =
+        static_cast<std::atomic<uint8_t> *>(calloc(SlabMapLeafSize, 1));
+    if (!newLeaf)
+      swift::crash("Could not allocate memory.");
+    if (root.compare_exchange_strong(leaf, newLeaf, std::memory_order_acq_rel,
+                                     std::memory_order_acquire))
+      leaf = newLeaf;
+    else
+      free(newLeaf);
+  }
+  leaf[index & (SlabMapLeafSize - 1)].store(sizeClass + 1,
+                                            std::memory_order_relaxed);
+}
+
+size_t swift::_swift_slabAllocSize(const void *ptr) {
+  uintptr_t index = uintptr_t(ptr) >> SlabShift;
+  uintptr_t rootIndex = index >> SlabMapLeafBits;
+  if (rootIndex >= SlabMapRootSize)
+    return 0;
+
+  // Blocks reach other threads only through some synchronization, which
+  // also orders the registration of their slab before this lookup.
+  std::atomic<uint8_t> *leaf =
+      SlabMap[rootIndex].load(std::memory_order_acquire);
+  if (!leaf)
+    return 0;
+  uint8_t entry =
+      leaf[index & (SlabMapLeafSize - 1)].load(std::memory_order_relaxed);
+  return entry ? getSizeClassBlockSize(entry - 1) : 0;
+}
+
+/// Move up to \p count blocks from the front of \p list to the central
+/// free list of the given size class.
+static void releaseBlocks(size_t sizeClass, FreeBlock *&list,
+                          unsigned &listCount, unsigned count) {
+  if (!list || !count)
+    return;
+
+  // Find the end of the batch.
+  FreeBlock *first = list, *last = list;
+  unsigned moved = 1;
+  while (moved < count && last->Next) {
+    last = last->Next;
+    ++moved;
+  }
+  list = last->Next;
+  listCount -= moved;
+
+  auto &central = CentralFreeLists[sizeClass];
+  StaticScopedLock guard(central.Lock);
+  last->Next = central.Head;
+  central.Head = first;
+}
+
+/// Return every block in a thread's cache to the central free lists.
+static void flushThreadCache(void *cache) {
+  auto threadCache = static_cast<ThreadCache *>(cache);
+  for (size_t i = 0; i != NumSizeClasses; ++i) {
+    releaseBlocks(i, threadCache->FreeLists[i], threadCache->Counts[i],
+                  threadCache->Counts[i]);
+  }
+
+  // Other thread-exit destructors may still allocate; if they do, the
+  // cache will be registered, and flushed, again.
+  threadCache->Registered = false;
+}
+
+static pthread_key_t ThreadCacheKey;
+
+static void createThreadCacheKey(void *) {
+  if (pthread_key_create(&ThreadCacheKey, flushThreadCache) != 0)
+    swift::crash("Could not create the slab allocator's thread cache key.");
+}
+
+static OnceToken_t ThreadCacheKeyOnce;
+
+/// Make sure the calling thread's cache is flushed when the thread exits.
+LLVM_ATTRIBUTE_NOINLINE
+static void registerThreadCache(ThreadCache &cache) {
+  SWIFT_ONCE_F(ThreadCacheKeyOnce, createThreadCacheKey, nullptr);
+  pthread_setspecific(ThreadCacheKey, &cache);
+  cache.Registered = true;
+}
+
+/// Refill the calling thread's free list for the given size class with a
+/// batch of blocks from the central free list.
+LLVM_ATTRIBUTE_NOINLINE
+static void refillThreadCache(ThreadCache &cache, size_t sizeClass) {
+  if (!cache.Registered)
+    registerThreadCache(cache);
+
+  size_t blockSize = getSizeClassBlockSize(sizeClass);
+  auto &central = CentralFreeLists[sizeClass];
+  FreeBlock *list = cache.FreeLists[sizeClass];
+  unsigned count = 0;
+
+  StaticScopedLock guard(central.Lock);
+  while (count < TransferBatchSize) {
+    FreeBlock *block = central.Head;
+    if (block) {
+      central.Head = block->Next;
+    } else {
+      // Carve a new block out of the current slab, starting a new slab if
+      // it is used up.
+      if (size_t(central.SlabEnd - central.SlabNext) < blockSize) {
+        void *slab;
+        if (posix_memalign(&slab, SlabSize, SlabSize) != 0)
+          swift::crash("Could not allocate memory.");
+        registerSlab(static_cast<char *>(slab), sizeClass);
+        central.SlabNext = static_cast<char *>(slab);
+        central.SlabEnd = central.SlabNext + SlabSize;
+      }
+      block = reinterpret_cast<FreeBlock *>(central.SlabNext);
+      central.SlabNext += blockSize;
+    }
+    block->Next = list;
+    list = block;
+    ++count;
+  }
+
+  cache.FreeLists[sizeClass] = list;
+  cache.Counts[sizeClass] += count;
+}
+
+void *swift::_swift_slabAlloc(size_t size) {
+  size_t sizeClass = getSizeClass(size);
+  ThreadCache &cache = CurrentThreadCache;
+  if (LLVM_UNLIKELY(!cache.FreeLists[sizeClass]))
+    refillThreadCache(cache, sizeClass);
+
+  FreeBlock *block = cache.FreeLists[sizeClass];
+  cache.FreeLists[sizeClass] = block->Next;
+  --cache.Counts[sizeClass];
+  return block;
+}
+
+void swift::_swift_slabDealloc(void *ptr, size_t size) {
+  size_t sizeClass = getSizeClass(size);
+  ThreadCache &cache = CurrentThreadCache;
+  if (LLVM_UNLIKELY(!cache.Registered))
+    registerThreadCache(cache);
+
+  auto block = static_cast<FreeBlock *>(ptr);
+  block->Next = cache.FreeLists[sizeClass];
+  cache.FreeLists[sizeClass] = block;
+
+  if (LLVM_UNLIKELY(++cache.Counts[sizeClass] > MaxThreadCachedBlocks)) {
+    releaseBlocks(sizeClass, cache.FreeLists[sizeClass],
+                  cache.Counts[sizeClass], TransferBatchSize);
+  }
+}
+
+static bool readSlabAllocatorSetting() {
+  const char *setting = getenv("SWIFT_RUNTIME_SLAB_ALLOCATOR");
+  return setting && strcmp(setting, "1") == 0;
+}
+
+bool swift::_swift_isSlabAllocatorEnabled() {
+  return SWIFT_LAZY_CONSTANT(readSlabAllocatorSetting());
+}
+
+/// Should an allocation with this size and alignment go to the slab
+/// allocator?
+static bool shouldUseSlabAllocator(size_t size, size_t alignMask) {
+  return size <= SlabAllocatorMaxSize &&
+         alignMask < SlabAllocatorAlignment &&
+         _swift_isSlabAllocatorEnabled();
+}
+
+#endif
+
 SWIFT_RT_ENTRY_VISIBILITY
 void *swift::swift_slowAlloc(size_t size, size_t alignMask)
     SWIFT_CC(RegisterPreservingCC_IMPL) {
-  // FIXME: use posix_memalign if alignMask is larger than the system guarantee.
-  void *p = malloc(size);
+#if SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR
+  if (shouldUseSlabAllocator(size, alignMask))
+    return _swift_slabAlloc(size);
+#endif
+
+  void *p;
+  if (LLVM_LIKELY(alignMask <= MallocAlignMask)) {
+    p = malloc(size);
+  } else {
+#if defined(_MSC_VER)
+    p = _aligned_malloc(size, alignMask + 1);
+#else
+    if (posix_memalign(&p, alignMask + 1, size) != 0)
+      p = nullptr;
+#endif
+  }
   if (!p) swift::crash("Could not allocate memory.");
   return p;
 }
@@ -34,5 +319,19 @@ void *swift::swift_slowAlloc(size_t size, size_t alignMask)
 SWIFT_RT_ENTRY_VISIBILITY
 void swift::swift_slowDealloc(void *ptr, size_t bytes, size_t alignMask)
     SWIFT_CC(RegisterPreservingCC_IMPL) {
+#if SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR
+  // Don't trust the size to tell which allocator the memory came from:
+  // objects with tail-allocated storage, like array buffers, are freed with
+  // the size of their header alone. Slab blocks are found by their address.
+  if (_swift_isSlabAllocatorEnabled()) {
+    if (size_t slabSize = _swift_slabAllocSize(ptr))
+      return _swift_slabDealloc(ptr, slabSize);
+  }
+#endif
+
+#if defined(_MSC_VER)
+  if (alignMask > MallocAlignMask)
+    return _aligned_free(ptr);
+#endif
   free(ptr);
 }
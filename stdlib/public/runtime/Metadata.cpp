@@ -34,6 +34,7 @@
 #define NOMINMAX
 #include <windows.h>
 #else
+#include <pthread.h>
 #include <sys/mman.h>
 #include <unistd.h>
 #endif
@@ -91,65 +92,169 @@ static void *swift_allocateMetadataRoundingToPage(size_t size) {
   return mem;
 }
 
-// free memory allocated by swift_allocateMetadataRoundingToPage()
-static void swift_freeMetadata(void *addr, size_t size) {
-#if defined(_MSC_VER)
-  // On success, VirtualFree() returns nonzero, on failure 0 
-  int result = VirtualFree(addr, 0, MEM_RELEASE);
-  if (result == 0)
-    fatalError(/* flags = */ 0, "swift_freePage: VirtualFree() failed");
+namespace {
+  /// A region of metadata memory that is bump-allocated from the front.
+  struct MetadataChunk {
+    char *Next;
+    char *End;
+
+    /// The allocator that last allocated from the chunk, which is charged
+    /// for its unused tail when the chunk's thread exits.
+    MetadataAllocator *LastAllocator;
+
+    size_t remaining() const { return End - Next; }
+  };
+} // end anonymous namespace
+
+/// The size of the mappings the metadata arena reserves from the OS.
+static const size_t MetadataArenaMappingSize = 1024 * 1024;
+
+/// The size of the chunks handed out to individual threads. The mapping
+/// size is a multiple of this, so mappings are used up without waste.
+static const size_t MetadataChunkSize = 16 * 1024;
+
+/// Allocations larger than this get their own mapping rather than being
+/// carved out of a chunk.
+static const size_t MaxMetadataChunkAllocationSize = MetadataChunkSize / 4;
+
+/// Guards MetadataArenaMapping, and SharedMetadataChunk if there is no
+/// thread-local storage.
+static StaticMutex MetadataArenaLock;
+
+/// The unused part of the most recent mapping.
+static MetadataChunk MetadataArenaMapping;
+
+#if SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL
+/// The chunk the current thread is allocating metadata from.
+static SWIFT_RUNTIME_ATTRIBUTE_THREAD_LOCAL MetadataChunk CurrentMetadataChunk;
 #else
-  // On success, munmap() returns 0, on failure -1
-  int result = munmap(addr, size);
-  if (result != 0)
-    fatalError(/* flags = */ 0, "swift_freePage: munmap() failed");
+/// Without thread-local storage, all threads share one chunk.
+static MetadataChunk SharedMetadataChunk;
 #endif
+
+/// Carve a new chunk out of the arena, reserving another mapping if the
+/// current one is used up. Must be called with MetadataArenaLock held.
+static MetadataChunk allocateMetadataChunk() {
+  if (MetadataArenaMapping.remaining() < MetadataChunkSize) {
+    auto memory = reinterpret_cast<char*>(
+        swift_allocateMetadataRoundingToPage(MetadataArenaMappingSize));
+    if (!memory)
+      crash("unable to allocate memory for metadata cache");
+    MetadataArenaMapping = { memory, memory + MetadataArenaMappingSize,
+                             nullptr };
+  }
+
+  MetadataChunk chunk = { MetadataArenaMapping.Next,
+                          MetadataArenaMapping.Next + MetadataChunkSize,
+                          nullptr };
+  MetadataArenaMapping.Next = chunk.End;
+  return chunk;
+}
+
+#if SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL && !defined(_MSC_VER)
+static pthread_key_t MetadataChunkKey;
+
+/// Charge the unused tail of an exiting thread's chunk as wasted.
+static void abandonThreadMetadataChunk(void *value) {
+  auto &chunk = *static_cast<MetadataChunk *>(value);
+  if (chunk.LastAllocator)
+    chunk.LastAllocator->addAbandonedBytes(chunk.remaining());
+
+  // Other thread-exit destructors may still instantiate metadata; if they
+  // do, the thread starts a new chunk, which is registered again.
+  chunk = MetadataChunk();
+}
+
+static void createMetadataChunkKey(void *) {
+  if (pthread_key_create(&MetadataChunkKey, abandonThreadMetadataChunk) != 0)
+    swift::crash("Could not create the metadata allocator's chunk key.");
+}
+
+static OnceToken_t MetadataChunkKeyOnce;
+
+/// Make sure the calling thread's chunk is accounted for when the thread
+/// exits.
+LLVM_ATTRIBUTE_NOINLINE
+static void registerThreadMetadataChunk(MetadataChunk &chunk) {
+  SWIFT_ONCE_F(MetadataChunkKeyOnce, createMetadataChunkKey, nullptr);
+  pthread_setspecific(MetadataChunkKey, &chunk);
 }
+#endif
 
 void *MetadataAllocator::alloc(size_t size) {
-  const uintptr_t PageSize = SWIFT_LAZY_CONSTANT(swift_pageSize());
-  // If the requested size is a page or larger, map page(s) for it
-  // specifically.
-  if (LLVM_UNLIKELY(size >= PageSize)) {
+  // Keep every allocation pointer-aligned.
+  size = (size + alignof(void*) - 1) & ~(alignof(void*) - 1);
+
+  // Large allocations get mapping(s) of their own.
+  if (LLVM_UNLIKELY(size > MaxMetadataChunkAllocationSize)) {
+    const uintptr_t PageSizeMask = SWIFT_LAZY_CONSTANT(swift_pageSize()) - 1;
+    size_t roundedSize = (size + PageSizeMask) & ~PageSizeMask;
     void *mem = swift_allocateMetadataRoundingToPage(size);
     if (!mem)
       crash("unable to allocate memory for metadata cache");
+    BytesReserved.fetch_add(roundedSize, std::memory_order_relaxed);
+    BytesWasted.fetch_add(roundedSize - size, std::memory_order_relaxed);
     return mem;
   }
 
-  uintptr_t curValue = NextValue.load(std::memory_order_relaxed);
-  while (true) {
-    char *next = reinterpret_cast<char*>(curValue);
-    char *end = next + size;
-  
-    // If we wrap over the end of the page, allocate a new page.
-    void *allocation = nullptr;
-    const uintptr_t PageSizeMask = PageSize - 1;
-    if (LLVM_UNLIKELY(((uintptr_t)next & ~PageSizeMask)
-                        != (((uintptr_t)end & ~PageSizeMask)))) {
-      // Allocate a new page if we haven't already.
-      allocation = swift_allocateMetadataRoundingToPage(PageSize);
-
-      if (!allocation)
-        crash("unable to allocate memory for metadata cache");
-
-      next = (char*) allocation;
-      end = next + size;
-    }
+#if SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL
+  MetadataChunk &chunk = CurrentMetadataChunk;
+#else
+  StaticScopedLock guard(MetadataArenaLock);
+  MetadataChunk &chunk = SharedMetadataChunk;
+#endif
 
-    // Swap it into place.
-    if (LLVM_LIKELY(std::atomic_compare_exchange_weak_explicit(
-            &NextValue, &curValue, reinterpret_cast<uintptr_t>(end),
-            std::memory_order_relaxed, std::memory_order_relaxed))) {
-      return next;
-    }
+  // If the allocation doesn't fit, abandon the rest of the chunk and
+  // start a new one.
+  size_t wasted = 0;
+  if (LLVM_UNLIKELY(chunk.remaining() < size)) {
+    wasted = chunk.remaining();
+#if SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL && !defined(_MSC_VER)
+    // The thread's first chunk.
+    if (!chunk.End)
+      registerThreadMetadataChunk(chunk);
+#endif
+#if SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL
+    StaticScopedLock guard(MetadataArenaLock);
+#endif
+    chunk = allocateMetadataChunk();
+  }
 
-    // If that didn't succeed, and we allocated, free the allocation.
-    // This potentially causes us to perform multiple mmaps under contention,
-    // but it keeps the fast path pristine.
-    if (allocation) {
-      swift_freeMetadata(allocation, PageSize);
-    }
+  char *result = chunk.Next;
+  chunk.Next += size;
+  chunk.LastAllocator = this;
+
+  BytesReserved.fetch_add(size + wasted, std::memory_order_relaxed);
+  if (wasted)
+    BytesWasted.fetch_add(wasted, std::memory_order_relaxed);
+  return result;
+}
+
+namespace {
+  struct MetadataAllocatorRecord {
+    const char *Name;
+    const MetadataAllocator *Allocator;
+  };
+} // end anonymous namespace
+
+/// Every registered metadata allocator, for statistics reporting.
+static Lazy<ConcurrentList<MetadataAllocatorRecord>> MetadataAllocators;
+
+void swift::_swift_registerMetadataAllocator(
+                                          const char *name,
+                                          const MetadataAllocator *allocator) {
+  MetadataAllocators->push_front(MetadataAllocatorRecord{name, allocator});
+}
+
+SWIFT_RUNTIME_EXPORT
+extern "C"
+void swift::swift_enumerateMetadataAllocatorStatistics(
+    void (*callback)(const char *cacheName, size_t bytesReserved,
+                     size_t bytesWasted, void *context),
+    void *context) {
+  for (auto &record : *MetadataAllocators) {
+    callback(record.Name, record.Allocator->getBytesReserved(),
+             record.Allocator->getBytesWasted(), context);
   }
 }
 
@@ -1621,6 +1726,11 @@ static ClassMetadata *_swift_initializeSuperclass(ClassMetadata *theClass,
 static MetadataAllocator &getResilientMetadataAllocator() {
   // This should be constant-initialized, but this is safe.
   static MetadataAllocator allocator;
+  static bool registered = [] {
+    _swift_registerMetadataAllocator("ResilientMetadata", &allocator);
+    return true;
+  }();
+  (void) registered;
   return allocator;
 }
 #endif
@@ -26,21 +26,26 @@
 
 namespace swift {
 
-/// A bump pointer for metadata allocations. Since metadata is (currently)
-/// never released, it does not support deallocation. This allocator by itself
-/// is not thread-safe; in concurrent uses, allocations must be guarded by
-/// a lock, such as the per-metadata-cache lock used to guard metadata
-/// instantiations. All allocations are pointer-aligned.
+/// An allocator for metadata. Since metadata is (currently) never released,
+/// it does not support deallocation. All allocations are pointer-aligned.
+///
+/// Allocations are bump-allocated out of a chunk owned by the current
+/// thread; chunks are carved out of large mappings shared by the whole
+/// process. The allocator is therefore thread-safe, and metadata can be
+/// instantiated in parallel on different threads without contending on
+/// allocation. The allocator itself only keeps statistics.
 class MetadataAllocator {
-  /// Address of the next available space. The allocator grabs a page at a time,
-  /// so the need for a new page can be determined by page alignment.
-  ///
-  /// Initializing to -1 instead of nullptr ensures that the first allocation
-  /// triggers a page allocation since it will always span a "page" boundary.
-  std::atomic<uintptr_t> NextValue;
-  
+  /// The number of bytes this allocator has taken out of the metadata
+  /// arena, including wasted bytes.
+  std::atomic<size_t> BytesReserved;
+
+  /// The number of reserved bytes that are not usable: the tail of a chunk
+  /// that was abandoned because an allocation didn't fit into it or because
+  /// its thread exited, and rounding of large allocations to whole pages.
+  std::atomic<size_t> BytesWasted;
+
 public:
-  constexpr MetadataAllocator() : NextValue(~(uintptr_t)0) {}
+  constexpr MetadataAllocator() : BytesReserved(0), BytesWasted(0) {}
 
   // Don't copy or move, please.
   MetadataAllocator(const MetadataAllocator &) = delete;
@@ -49,8 +54,28 @@ public:
   MetadataAllocator &operator=(MetadataAllocator &&) = delete;
   
   void *alloc(size_t size);
+
+  /// Record that the unused tail of a chunk this allocator last allocated
+  /// from was abandoned.
+  void addAbandonedBytes(size_t size) {
+    BytesReserved.fetch_add(size, std::memory_order_relaxed);
+    BytesWasted.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  size_t getBytesReserved() const {
+    return BytesReserved.load(std::memory_order_relaxed);
+  }
+
+  size_t getBytesWasted() const {
+    return BytesWasted.load(std::memory_order_relaxed);
+  }
 };
 
+/// Register an allocator so that its statistics are reported by
+/// swift_enumerateMetadataAllocatorStatistics.
+void _swift_registerMetadataAllocator(const char *name,
+                                      const MetadataAllocator *allocator);
+
 // A wrapper around a pointer to a metadata cache entry that provides
 // DenseMap semantics that compare values in the key vector for the metadata
 // instance.
@@ -197,6 +222,19 @@ template <class ValueTy> class MetadataCache {
     Key(KeyDataRef data) : Hash(data.hash()), KeyData(data) {}
   };
 
+  /// The initialization state of a map entry.
+  enum class EntryState : uint8_t {
+    /// The entry is being initialized and nobody is waiting for it.
+    Initializing,
+
+    /// The entry is being initialized and at least one thread is blocked
+    /// on the cache's condition variable waiting for it.
+    InitializingWithWaiters,
+
+    /// The entry has a value.
+    Complete
+  };
+
   /// The layout of an entry in the concurrent map.
   class Entry {
     size_t Hash;
@@ -205,14 +243,18 @@ template <class ValueTy> class MetadataCache {
     /// Does this entry have a value, or is it currently undergoing
     /// initialization?
     ///
-    /// This (and the following field) is ever modified under the lock,
-    /// but it can be read from any thread, including while the lock
-    /// is held.
-    std::atomic<bool> HasValue;
-    union {
-      ValueTy *Value;
-      std::thread::id InitializingThread;
-    };
+    /// This can be read from any thread without holding the lock. It only
+    /// moves to InitializingWithWaiters under the lock, which is what
+    /// allows the initializing thread to skip the lock entirely when
+    /// nobody is waiting.
+    std::atomic<EntryState> State;
+
+    /// The value, valid once State is Complete.
+    ValueTy *Value;
+
+    /// The thread responsible for initializing the value. Never modified
+    /// after construction.
+    std::thread::id InitializingThread;
 
     const void **getKeyDataBuffer() {
       return reinterpret_cast<const void **>(this + 1);
@@ -222,8 +264,9 @@ template <class ValueTy> class MetadataCache {
     }
   public:
     Entry(const Key &key)
-      : Hash(key.Hash), KeyLength(key.KeyData.size()), HasValue(false) {
-      InitializingThread = std::this_thread::get_id();
+      : Hash(key.Hash), KeyLength(key.KeyData.size()),
+        State(EntryState::Initializing), Value(nullptr),
+        InitializingThread(std::this_thread::get_id()) {
       memcpy(getKeyDataBuffer(), key.KeyData.begin(),
              KeyLength * sizeof(void*));
     }
@@ -253,16 +296,39 @@ template <class ValueTy> class MetadataCache {
       }
     }
 
+    static size_t getKeyHash(const Key &key) {
+      return key.Hash;
+    }
+
     ValueTy *getValue() const {
-      if (HasValue.load(std::memory_order_acquire)) {
+      if (State.load(std::memory_order_acquire) == EntryState::Complete) {
         return Value;
       }
       return nullptr;
     }
 
-    void setValue(ValueTy *value) {
+    /// Record that a thread is about to wait for this entry. Must be called
+    /// with the cache lock held.
+    ///
+    /// \returns false if the entry was completed in the meantime.
+    bool markWaiting() {
+      auto expected = EntryState::Initializing;
+      if (State.compare_exchange_strong(expected,
+                                        EntryState::InitializingWithWaiters,
+                                        std::memory_order_relaxed,
+                                        std::memory_order_acquire))
+        return true;
+      return expected == EntryState::InitializingWithWaiters;
+    }
+
+    /// Publish the value.
+    ///
+    /// \returns true if there may be threads waiting for it, in which case
+    /// the caller must notify them under the cache lock.
+    bool setValue(ValueTy *value) {
       Value = value;
-      HasValue.store(true, std::memory_order_release);
+      return State.exchange(EntryState::Complete, std::memory_order_acq_rel)
+               == EntryState::InitializingWithWaiters;
     }
   };
 
@@ -273,9 +339,11 @@ template <class ValueTy> class MetadataCache {
                 "offset of Head is not at proper offset");
 
   /// The head of a linked list connecting all the metadata cache entries.
+  /// Entries are pushed by whichever thread built them, so this is atomic;
+  /// it has the same layout as a plain pointer.
   /// TODO: Remove this when LLDB is able to understand the final data
   /// structure for the metadata cache.
-  const ValueTy *Head;
+  std::atomic<const ValueTy *> Head;
 
   struct ConcurrencyControl {
     Mutex Lock;
@@ -287,7 +355,9 @@ template <class ValueTy> class MetadataCache {
   MetadataAllocator Allocator;
   
 public:
-  MetadataCache() : Concurrency(new ConcurrencyControl()) {}
+  MetadataCache() : Head(nullptr), Concurrency(new ConcurrencyControl()) {
+    _swift_registerMetadataAllocator(ValueTy::getName(), &Allocator);
+  }
   ~MetadataCache() {}
 
   /// Caches are not copyable.
@@ -295,8 +365,6 @@ public:
   MetadataCache &operator=(const MetadataCache &other) = delete;
 
   /// Get the allocator for metadata in this cache.
-  /// The allocator can only be safely used while the cache is locked during
-  /// an addMetadataEntry call.
   MetadataAllocator &getAllocator() { return Allocator; }
 
   /// Look up a cached metadata entry. If a cache match exists, return it.
@@ -319,6 +387,14 @@ public:
            ValueTy::getName(), this, key.Hash);
 #endif
 
+    // Fast path: an entry that has already been completed is found without
+    // taking any lock or writing to any shared memory.
+    if (Entry *entry = Map.find(key)) {
+      if (auto value = entry->getValue()) {
+        return value;
+      }
+    }
+
     // Ensure the existence of a map entry.
     auto insertResult = Map.getOrInsert(key);
     Entry *entry = insertResult.first;
@@ -333,9 +409,10 @@ public:
         return value;
       }
 
-      // Otherwise, we have to grab the lock and wait for the value to
-      // appear there.  Note that we have to check again immediately
-      // after acquiring the lock to prevent a race.
+      // Otherwise, the entry is still being initialized. We have to grab
+      // the lock and wait for the value to appear there.  Note that we have
+      // to check again immediately after acquiring the lock to prevent a
+      // race.
       auto concurrency = Concurrency.get();
       concurrency->Lock.withLockOrWait(concurrency->Queue, [&, this] {
         if ((value = entry->getValue())) {
@@ -352,6 +429,12 @@ public:
           abort();
         }
 
+        // Tell the initializing thread that it needs to wake us up.
+        if (!entry->markWaiting()) {
+          value = entry->getValue();
+          return true; // the value appeared in the meantime
+        }
+
         return false; // don't have a value, continue waiting
       });
 
@@ -363,18 +446,24 @@ public:
     auto value = builder();
 
     // Update the linked list.
-    value->Next = Head;
-    Head = value;
+    auto head = Head.load(std::memory_order_relaxed);
+    do {
+      value->Next = head;
+    } while (!Head.compare_exchange_weak(head, value,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed));
 
 #if SWIFT_DEBUG_RUNTIME
         printf("%s(%p): created %p\n",
                ValueTy::getName(), (void*) this, value);
 #endif
 
-    // Acquire the lock, set the value, and notify any waiters.
-    auto concurrency = Concurrency.get();
-    concurrency->Lock.withLockThenNotifyAll(
-        concurrency->Queue, [&entry, &value] { entry->setValue(value); });
+    // Set the value. Only if some thread is blocked waiting for it do we
+    // need to acquire the lock and notify the waiters.
+    if (entry->setValue(value)) {
+      auto concurrency = Concurrency.get();
+      concurrency->Lock.withLockThenNotifyAll(concurrency->Queue, [] {});
+    }
 
     return value;
   }
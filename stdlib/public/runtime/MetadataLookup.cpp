@@ -21,6 +21,7 @@
 #include "swift/Runtime/Metadata.h"
 #include "swift/Runtime/Mutex.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/StringExtras.h"
@@ -82,6 +83,12 @@ namespace {
       return aName.compare(Name);
     }
 
+    static size_t getKeyHash(llvm::StringRef aName) {
+      // llvm::hash_value(StringRef) is defined out of line in a library we
+      // can't link against from the runtime.
+      return llvm::hash_combine_range(aName.begin(), aName.end());
+    }
+
     template <class... T>
     static size_t getExtraAllocationSize(T &&... ignored) {
       return 0;
@@ -19,8 +19,11 @@
 #include "swift/Runtime/Concurrent.h"
 #include "swift/Runtime/Metadata.h"
 #include "swift/Runtime/Mutex.h"
+#include "llvm/ADT/Hashing.h"
 #include "Private.h"
 
+#include <algorithm>
+
 #if defined(__APPLE__) && defined(__MACH__)
 #include <mach-o/dyld.h>
 #include <mach-o/getsect.h>
@@ -155,14 +158,94 @@ const {
 #endif
 
 namespace {
+  /// An entry in the lookup index of a conformance section.
+  struct ConformanceIndexEntry {
+    const ProtocolDescriptor *Proto;
+    /// The type the record applies to, as referenced by the record without
+    /// instantiating any metadata: a Metadata*, a ClassMetadata* or a
+    /// NominalTypeDescriptor*. Null if the type can only be found by
+    /// resolving the record's canonical type metadata.
+    const void *Type;
+    const ProtocolConformanceRecord *Record;
+
+    bool operator<(const ConformanceIndexEntry &other) const {
+      if (Proto != other.Proto)
+        return uintptr_t(Proto) < uintptr_t(other.Proto);
+      return uintptr_t(Type) < uintptr_t(other.Type);
+    }
+  };
+
   struct ConformanceSection {
     const ProtocolConformanceRecord *Begin, *End;
+
+    /// The records of this section that may be cached by
+    /// swift_conformsToProtocol, sorted by protocol and type. Built the
+    /// first time the section is searched.
+    ConformanceIndexEntry *IndexBegin = nullptr, *IndexEnd = nullptr;
+
+    ConformanceSection(const ProtocolConformanceRecord *begin,
+                       const ProtocolConformanceRecord *end)
+      : Begin(begin), End(end) {}
+
     const ProtocolConformanceRecord *begin() const {
       return Begin;
     }
     const ProtocolConformanceRecord *end() const {
       return End;
     }
+
+    /// Return the index entries for the given protocol and type key.
+    /// Must be called with the SectionsToScanLock held.
+    std::pair<const ConformanceIndexEntry *, const ConformanceIndexEntry *>
+    lookup(const ProtocolDescriptor *proto, const void *type) {
+      if (!IndexBegin)
+        buildIndex();
+      return std::equal_range(IndexBegin, IndexEnd,
+                              ConformanceIndexEntry{proto, type, nullptr});
+    }
+
+  private:
+    void buildIndex() {
+      size_t numRecords = End - Begin;
+      // Allocate at least one entry so that an empty index is still
+      // distinguishable from an index that has not been built yet.
+      IndexBegin = reinterpret_cast<ConformanceIndexEntry *>(
+          malloc(std::max(numRecords, size_t(1)) *
+                 sizeof(ConformanceIndexEntry)));
+      IndexEnd = IndexBegin;
+
+      for (const auto &record : *this) {
+        const void *type;
+        switch (record.getTypeKind()) {
+        case TypeMetadataRecordKind::UniqueDirectType:
+          type = record.getDirectType();
+          break;
+        case TypeMetadataRecordKind::UniqueDirectClass:
+          type = record.getDirectClass();
+          break;
+        case TypeMetadataRecordKind::NonuniqueDirectType:
+        case TypeMetadataRecordKind::UniqueIndirectClass:
+          // The canonical metadata is only known once the record is
+          // resolved; keep it under the null type key.
+          type = nullptr;
+          break;
+        case TypeMetadataRecordKind::UniqueNominalTypeDescriptor:
+          // Only nondependent witness tables are cached for generic
+          // patterns.
+          if (record.getConformanceKind()
+                != ProtocolConformanceReferenceKind::WitnessTable)
+            continue;
+          type = record.getNominalTypeDescriptor();
+          break;
+        case TypeMetadataRecordKind::Universal:
+          continue;
+        }
+        *IndexEnd++ = ConformanceIndexEntry{record.getProtocol(), type,
+                                            &record};
+      }
+
+      std::sort(IndexBegin, IndexEnd);
+    }
   };
 
   struct ConformanceCacheKey {
@@ -199,6 +282,10 @@ namespace {
       }
     }
 
+    static size_t getKeyHash(const ConformanceCacheKey &key) {
+      return llvm::hash_combine(key.Type, key.Proto);
+    }
+
     template <class... Args>
     static size_t getExtraAllocationSize(Args &&... ignored) {
       return 0;
@@ -297,7 +384,7 @@ _registerProtocolConformances(ConformanceState &C,
                               const ProtocolConformanceRecord *begin,
                               const ProtocolConformanceRecord *end) {
   ScopedLock guard(C.SectionsToScanLock);
-  C.SectionsToScan.push_back(ConformanceSection{begin, end});
+  C.SectionsToScan.push_back(ConformanceSection(begin, end));
 }
 
 static void _addImageProtocolConformancesBlock(const uint8_t *conformances,
@@ -561,6 +648,46 @@ bool isRelatedType(const Metadata *type, const void *candidate,
   return false;
 }
 
+/// Cache the conformance described by the given record if it applies to
+/// the type, one of its superclasses or a related generic type.
+/// Must be called with the SectionsToScanLock held.
+static void _cacheConformanceRecord(ConformanceState &C, const Metadata *type,
+                                    const ProtocolDescriptor *protocol,
+                                    const ProtocolConformanceRecord &record) {
+  assert(record.getProtocol() == protocol);
+
+  // If the record applies to a specific type, cache it.
+  if (auto metadata = record.getCanonicalTypeMetadata()) {
+    if (!isRelatedType(type, metadata, /*isMetadata=*/true))
+      return;
+
+    // Store the type-protocol pair in the cache.
+    auto witness = record.getWitnessTable(metadata);
+    if (witness) {
+      C.cacheSuccess(metadata, protocol, witness);
+    } else {
+      C.cacheFailure(metadata, protocol);
+    }
+
+  // If the record provides a nondependent witness table for all instances
+  // of a generic type, cache it for the generic pattern.
+  // TODO: "Nondependent witness table" probably deserves its own flag.
+  // An accessor function might still be necessary even if the witness table
+  // can be shared.
+  } else if (record.getTypeKind()
+               == TypeMetadataRecordKind::UniqueNominalTypeDescriptor
+             && record.getConformanceKind()
+               == ProtocolConformanceReferenceKind::WitnessTable) {
+
+    auto R = record.getNominalTypeDescriptor();
+    if (!isRelatedType(type, R, /*isMetadata=*/false))
+      return;
+
+    // Store the type-protocol pair in the cache.
+    C.cacheSuccess(R, protocol, record.getStaticWitnessTable());
+  }
+}
+
 const WitnessTable *
 swift::swift_conformsToProtocol(const Metadata *type,
                                 const ProtocolDescriptor *protocol) {
@@ -616,50 +743,34 @@ recur:
 
   for (; sectionIdx < endSectionIdx; ++sectionIdx) {
     auto &section = C.SectionsToScan[sectionIdx];
-    // Eagerly pull records for nondependent witnesses into our cache.
-    for (const auto &record : section) {
-      // If the record applies to a specific type, cache it.
-      if (auto metadata = record.getCanonicalTypeMetadata()) {
-        auto P = record.getProtocol();
-
-        // Look for an exact match.
-        if (protocol != P)
-          continue;
-
-        if (!isRelatedType(type, metadata, /*isMetadata=*/true))
-          continue;
-
-        // Store the type-protocol pair in the cache.
-        auto witness = record.getWitnessTable(metadata);
-        if (witness) {
-          C.cacheSuccess(metadata, P, witness);
-        } else {
-          C.cacheFailure(metadata, P);
-        }
 
-      // If the record provides a nondependent witness table for all instances
-      // of a generic type, cache it for the generic pattern.
-      // TODO: "Nondependent witness table" probably deserves its own flag.
-      // An accessor function might still be necessary even if the witness table
-      // can be shared.
-      } else if (record.getTypeKind()
-                   == TypeMetadataRecordKind::UniqueNominalTypeDescriptor
-                 && record.getConformanceKind()
-                   == ProtocolConformanceReferenceKind::WitnessTable) {
-
-        auto R = record.getNominalTypeDescriptor();
-        auto P = record.getProtocol();
-
-        // Look for an exact match.
-        if (protocol != P)
+    // Records whose type is only known after resolving them are checked
+    // against the whole class hierarchy of the type.
+    auto unkeyed = section.lookup(protocol, nullptr);
+    for (auto entry = unkeyed.first; entry != unkeyed.second; ++entry)
+      _cacheConformanceRecord(C, type, protocol, *entry->Record);
+
+    // Other records are found by the keys the type, its superclasses and
+    // their nominal type descriptors are referenced by.
+    for (const Metadata *related = type; related;) {
+      const void *keys[] = {
+        related,
+        related->getClassObject(),
+        related->getNominalTypeDescriptor().get(),
+      };
+      for (const void *key : keys) {
+        // Native Swift class metadata is also the class object.
+        if (!key || (key != keys[0] && key == related))
           continue;
-
-        if (!isRelatedType(type, R, /*isMetadata=*/false))
-          continue;
-
-        // Store the type-protocol pair in the cache.
-        C.cacheSuccess(R, P, record.getStaticWitnessTable());
+        auto keyed = section.lookup(protocol, key);
+        for (auto entry = keyed.first; entry != keyed.second; ++entry)
+          _cacheConformanceRecord(C, type, protocol, *entry->Record);
       }
+
+      const ClassMetadata *classType = related->getClassObject();
+      related = nullptr;
+      if (classType && classHasSuperclass(classType))
+        related = swift_getObjCClassMetadata(classType->SuperClass);
     }
   }
   ++ConformanceCacheGeneration;
@@ -16,6 +16,7 @@
 #include "swift/Runtime/Debug.h"
 #include "swift/Runtime/Metadata.h"
 #include "../runtime/Private.h"
+#include "llvm/ADT/Hashing.h"
 
 using namespace swift;
 
@@ -51,6 +52,10 @@ struct HashableConformanceEntry {
     }
   }
 
+  static size_t getKeyHash(const HashableConformanceKey &key) {
+    return llvm::hash_value(key.derivedType);
+  }
+
   static size_t
   getExtraAllocationSize(HashableConformanceKey key,
                          const Metadata *baseTypeThatConformsToHashable) {
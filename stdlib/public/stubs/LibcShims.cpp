@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "swift/Basic/Lazy.h"
+#include "swift/Runtime/Heap.h"
 #include "../SwiftShims/LibcShims.h"
 #include "llvm/Support/DataTypes.h"
 
@@ -91,6 +92,11 @@ size_t swift::_swift_stdlib_malloc_size(const void *ptr) {
 #elif defined(__GNU_LIBRARY__) || defined(__CYGWIN__) || defined(__ANDROID__)
 #include <malloc.h>
 size_t swift::_swift_stdlib_malloc_size(const void *ptr) {
+#if SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR
+  // Blocks in the middle of a slab are unknown to malloc.
+  if (size_t slabSize = _swift_slabAllocSize(ptr))
+    return slabSize;
+#endif
   return malloc_usable_size(const_cast<void *>(ptr));
 }
 #elif defined(_MSC_VER)
@@ -101,6 +107,10 @@ size_t swift::_swift_stdlib_malloc_size(const void *ptr) {
 #elif defined(__FreeBSD__)
 #include <malloc_np.h>
 size_t swift::_swift_stdlib_malloc_size(const void *ptr) {
+#if SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR
+  if (size_t slabSize = _swift_slabAllocSize(ptr))
+    return slabSize;
+#endif
   return malloc_usable_size(const_cast<void *>(ptr));
 }
 #else
@@ -0,0 +1,23 @@
+// RUN: %target-parse-verify-swift
+// RUN: %target-swift-frontend -parse -print-stats %s 2>&1 | FileCheck %s
+// REQUIRES: asserts
+
+// Each argument of an overloaded call is a connected component which is
+// solved again for every overload. When it is in the same state, the partial
+// solutions found for the first overload are reused. They must lead to the
+// same overloads as solving the argument from scratch.
+
+// CHECK: {{[1-9][0-9]*}} Constraint solver overall - # of connected components reused
+
+func scale(_ x: Int) -> Int { return x }
+@available(*, deprecated, message: "ranked below scale(Int)")
+func scale(_ x: Double) -> Int { return Int(x) }
+
+func combine(_ x: Int, _ y: Int) -> Int { return x + y }
+func combine(_ x: Int, _ y: Double) -> Double { return Double(x) + y }
+
+let fromScratch: Int = scale(2) + 1
+let reused = combine(scale(2) + 1, 3 - 4)
+let _: Int = reused
+let reusedDouble = combine(scale(2) + 1, 3.5)
+let _: Double = reusedDouble
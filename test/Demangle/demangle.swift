@@ -9,6 +9,20 @@ RUN: sed -ne '/--->/s/^.*---> *//p' < %S/Inputs/manglings.txt > %t.check
 RUN: swift-demangle < %t.input > %t.output
 RUN: diff %t.check %t.output
 
+Stream mode must produce the same output, even with chunks that are smaller
+than the symbols.
+RUN: swift-demangle -stream -j 4 -stream-chunk-size 16 < %t.input > %t.stream-output
+RUN: diff %t.check %t.stream-output
+RUN: swift-demangle < %S/Inputs/manglings.txt > %t.text-output
+RUN: swift-demangle -stream -j 3 -stream-chunk-size 7 < %S/Inputs/manglings.txt > %t.stream-text-output
+RUN: diff %t.text-output %t.stream-text-output
+
+Stream mode only prints the demangled names.
+RUN: not swift-demangle -stream -expand < %t.input 2>&1 | FileCheck %s -check-prefix=STREAM-ERROR
+RUN: not swift-demangle -stream -tree-only < %t.input 2>&1 | FileCheck %s -check-prefix=STREAM-ERROR
+RUN: not swift-demangle -stream -test-remangle < %t.input 2>&1 | FileCheck %s -check-prefix=STREAM-ERROR
+STREAM-ERROR: error: -stream can't be combined with -expand, -tree-only or -test-remangle
+
 ; RUN: swift-demangle __TtSi | FileCheck %s -check-prefix=DOUBLE
 ; DOUBLE: _TtSi ---> Swift.Int
 
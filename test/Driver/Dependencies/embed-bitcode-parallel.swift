@@ -56,16 +56,17 @@
 // RUN: touch -t 201401240006 %t/other.swift
 // RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/fake-build-for-bitcode.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -embed-bitcode -module-name main -j2 -parseable-output 2>&1 | FileCheck -check-prefix=CHECK-SECOND %s
 
+// Both compile jobs start right away; the longer one is started first.
 // CHECK-SECOND: "kind": "began"
 // CHECK-SECOND: "name": "compile"
-// CHECK-SECOND: ".\/main.swift"
+// CHECK-SECOND: ".\/{{main|other}}.swift"
 // CHECK-SECOND: {{^}$}}
 
 // CHECK-SECOND-NOT: finished
 
 // CHECK-SECOND: "kind": "began"
 // CHECK-SECOND: "name": "compile"
-// CHECK-SECOND: ".\/other.swift"
+// CHECK-SECOND: ".\/{{other|main}}.swift"
 // CHECK-SECOND: {{^}$}}
 
 // CHECK-SECOND-NOT: began
@@ -0,0 +1,38 @@
+// RUN: rm -rf %t && cp -r %S/Inputs/independent/ %t
+// RUN: %S/Inputs/touch.py 443865900 %t/*
+
+// When jobs run in parallel, the one which took longest in the previous
+// build is started first.
+
+// RUN: echo '{version: "'$(%swiftc_driver_plain -version | head -n1)'", inputs: {"./main.swift": !dirty [443865900, 0], "./other.swift": !dirty [443865900, 0]}, durations: {"./main.swift": [1, 0], "./other.swift": [10, 0]}, build_time: [443865901, 0]}' > %t/main~buildrecord.swiftdeps
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j2 -parseable-output 2>&1 | FileCheck -check-prefix=CHECK-OTHER-FIRST %s
+
+// CHECK-OTHER-FIRST: "kind": "began"
+// CHECK-OTHER-FIRST: "name": "compile"
+// CHECK-OTHER-FIRST: ".\/other.swift"
+// CHECK-OTHER-FIRST: {{^}$}}
+
+// CHECK-OTHER-FIRST: "kind": "began"
+// CHECK-OTHER-FIRST: "name": "compile"
+// CHECK-OTHER-FIRST: ".\/main.swift"
+// CHECK-OTHER-FIRST: {{^}$}}
+
+// The new build record remembers how long each job took.
+// RUN: FileCheck -check-prefix=CHECK-RECORD %s < %t/main~buildrecord.swiftdeps
+
+// CHECK-RECORD: durations:
+// CHECK-RECORD-DAG: "./main.swift": [{{[0-9]+}}, {{[0-9]+}}]
+// CHECK-RECORD-DAG: "./other.swift": [{{[0-9]+}}, {{[0-9]+}}]
+
+// RUN: echo '{version: "'$(%swiftc_driver_plain -version | head -n1)'", inputs: {"./main.swift": !dirty [443865900, 0], "./other.swift": !dirty [443865900, 0]}, durations: {"./main.swift": [10, 0], "./other.swift": [1, 0]}, build_time: [443865901, 0]}' > %t/main~buildrecord.swiftdeps
+// RUN: cd %t && %swiftc_driver -c -driver-use-frontend-path %S/Inputs/update-dependencies.py -output-file-map %t/output.json -incremental ./main.swift ./other.swift -module-name main -j2 -parseable-output 2>&1 | FileCheck -check-prefix=CHECK-MAIN-FIRST %s
+
+// CHECK-MAIN-FIRST: "kind": "began"
+// CHECK-MAIN-FIRST: "name": "compile"
+// CHECK-MAIN-FIRST: ".\/main.swift"
+// CHECK-MAIN-FIRST: {{^}$}}
+
+// CHECK-MAIN-FIRST: "kind": "began"
+// CHECK-MAIN-FIRST: "name": "compile"
+// CHECK-MAIN-FIRST: ".\/other.swift"
+// CHECK-MAIN-FIRST: {{^}$}}
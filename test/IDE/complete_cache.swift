@@ -22,6 +22,9 @@
 // RUN: %target-swift-ide-test -dump-completion-cache %t.ccp/Darwin-* | FileCheck %s -check-prefix=CLANG_DARWIN
 // RUN: %target-swift-ide-test -dump-completion-cache %t.ccp/Darwin-* | FileCheck %s -check-prefix=CLANG_DARWIN_NEG
 
+// Look up cached items by name prefix.
+// RUN: %target-swift-ide-test -dump-completion-cache -completion-cache-name-prefix=foostructtypedef %t.ccp/ctypes-* | FileCheck %s -check-prefix=CLANG_CTYPES_PREFIX
+
 
 // Qualified.
 // RUN: %target-swift-ide-test(mock-sdk: %clang-importer-sdk) -code-completion -source-filename %s -code-completion-token=CLANG_QUAL_MACROS_1 -completion-cache-path=%t.ccp > %t.macros.ccp1.compl.txt
@@ -57,6 +60,12 @@ import ctypes
 // CLANG_CTYPES-DAG: Decl[TypeAlias]/OtherModule[ctypes]: FooStructTypedef1[#FooStruct2#]{{; name=.+$}}
 // CLANG_CTYPES: End completions
 
+// CLANG_CTYPES_PREFIX: Begin completions
+// CLANG_CTYPES_PREFIX-NOT: FooStruct1
+// CLANG_CTYPES_PREFIX-DAG: Decl[TypeAlias]/OtherModule[ctypes]: FooStructTypedef1[#FooStruct2#]{{; name=.+$}}
+// CLANG_CTYPES_PREFIX-NOT: FooStruct1
+// CLANG_CTYPES_PREFIX: End completions
+
 // CLANG_MACROS: Begin completions
 // CLANG_MACROS-DAG: Decl[GlobalVar]/OtherModule[macros]: USES_MACRO_FROM_OTHER_MODULE_1[#Int32#]{{; name=.+$}}
 // CLANG_MACROS: End completions
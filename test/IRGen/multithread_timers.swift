@@ -0,0 +1,11 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %target-swift-frontend -c -num-threads 2 -debug-time-compilation %s -module-name main -o %t/main.o 2>&1 | FileCheck %s
+
+// CHECK-DAG: IRGen (source files)
+// CHECK-DAG: IRGen (lazy definitions)
+// CHECK-DAG: IRGen (cross-module linkage and finalization)
+// CHECK-DAG: LLVM (all threads)
+
+public func timedFunction() -> Int {
+  return 42
+}
@@ -0,0 +1,52 @@
+// RUN: %target-run-simple-swift | FileCheck %s
+// REQUIRES: executable_test
+
+// Dynamic casts to a protocol look conformances up through the per-section
+// conformance index. The first cast of each type misses the cache and scans
+// the index for the type and each of its superclasses.
+
+protocol Describable {
+  func describe() -> String
+}
+
+class Base : Describable {
+  func describe() -> String { return "Base" }
+}
+class Derived : Base {}
+class MoreDerived : Derived {}
+
+class Unrelated {}
+class UnrelatedChild : Unrelated {}
+
+struct Value : Describable {
+  func describe() -> String { return "Value" }
+}
+
+struct Box<T> : Describable {
+  func describe() -> String { return "Box<\(T.self)>" }
+}
+
+func describe(_ x: Any) {
+  if let d = x as? Describable {
+    print(d.describe())
+  } else {
+    print("not describable")
+  }
+}
+
+// Uncached: the conformance is found on the superclass of the superclass.
+describe(MoreDerived()) // CHECK: Base
+// Cached now.
+describe(MoreDerived()) // CHECK-NEXT: Base
+describe(Derived()) // CHECK-NEXT: Base
+describe(Base()) // CHECK-NEXT: Base
+
+// Uncached failures walk the whole hierarchy and find nothing.
+describe(UnrelatedChild()) // CHECK-NEXT: not describable
+describe(UnrelatedChild()) // CHECK-NEXT: not describable
+describe(Unrelated()) // CHECK-NEXT: not describable
+
+describe(Value()) // CHECK-NEXT: Value
+describe(Box<Int>()) // CHECK-NEXT: Box<Int>
+describe(Box<String>()) // CHECK-NEXT: Box<String>
+describe(1) // CHECK-NEXT: not describable
@@ -0,0 +1,48 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %target-build-swift %s -o %t/a.out
+// RUN: env SWIFT_RUNTIME_SLAB_ALLOCATOR=1 %target-run %t/a.out | FileCheck %s
+// REQUIRES: executable_test
+// REQUIRES: OS=linux-gnu
+
+// Objects with tail-allocated storage, like array buffers, are deallocated
+// with the size of their header alone. Buffers too large for the slab
+// allocator must still go back to malloc rather than onto a slab free list,
+// or every one of them leaks.
+
+import Glibc
+
+/// Returns the resident set size of the process, in bytes.
+func residentBytes() -> Int {
+  let file = fopen("/proc/self/statm", "r")!
+  defer { fclose(file) }
+  var line = [CChar](repeating: 0, count: 256)
+  _ = fgets(&line, Int32(line.count), file)
+  let fields = String(cString: line).characters.split(separator: " ")
+  return Int(String(fields[1]))! * sysconf(Int32(_SC_PAGESIZE))
+}
+
+final class Buffer : ManagedBuffer<Int, Int> {}
+
+func churn(_ rounds: Int) -> Int {
+  var total = 0
+  for round in 0..<rounds {
+    // 8 KB of elements, far more than the largest slab size class.
+    let a = [Int](repeating: round, count: 1000)
+    total += a[a.count - 1]
+
+    let b = Buffer.create(minimumCapacity: 1000) { _ in round }
+    total += b.header
+  }
+  return total
+}
+
+// Warm up, so that the allocators have whatever memory they keep around.
+_ = churn(1_000)
+
+let before = residentBytes()
+print(churn(20_000)) // CHECK: 399980000
+let growth = residentBytes() - before
+
+// Leaking would take over 300 MB.
+print(growth < 32 * 1024 * 1024 ? "bounded" : "grew by \(growth) bytes")
+// CHECK-NEXT: bounded
@@ -0,0 +1,36 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %target-build-swift %s -o %t/a.out
+// RUN: env SWIFT_RUNTIME_SLAB_ALLOCATOR=1 %target-run %t/a.out | FileCheck %s
+// REQUIRES: executable_test
+
+// Array and ManagedBuffer ask malloc_size for the size of their storage to
+// find their capacity. With the slab allocator on, small buffers live in the
+// middle of slabs, which malloc knows nothing about, so the size has to come
+// from the slab allocator.
+
+final class Buffer : ManagedBuffer<Int, Int> {}
+
+var total = 0
+for round in 0..<100 {
+  // Grow through every small size class and then past the largest.
+  var a: [Int] = []
+  for i in 0..<64 {
+    a.append(i + round)
+  }
+  total += a.reduce(0, +)
+
+  for count in [1, 2, 5, 13, 30] {
+    let b = Buffer.create(minimumCapacity: count) { _ in count }
+    precondition(b.capacity >= count)
+    b.withUnsafeMutablePointerToElements { elements in
+      for i in 0..<count {
+        (elements + i).initialize(to: i)
+      }
+    }
+    total += b.header
+    b.withUnsafeMutablePointerToElements { elements in
+      _ = elements.deinitialize(count: count)
+    }
+  }
+}
+print(total) // CHECK: 523500
@@ -0,0 +1,6 @@
+// RUN: %target-parse-verify-swift -solver-expression-time-threshold 0
+
+// With a threshold of 0, the solver gives up on any expression that needs a
+// search, the same way as when it runs out of memory, no matter how fast the
+// machine is.
+var x = [1, 2, 3, 4.5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18 ,19] // expected-error{{expression was too complex to be solved in reasonable time; consider breaking up the expression into distinct sub-expressions}}
@@ -0,0 +1,28 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %target-swift-frontend -parse -expression-type-check-report %t/report.json %s
+// RUN: FileCheck %s < %t/report.json
+
+// RUN: not %target-swift-frontend -parse -solver-memory-threshold 4000 -expression-type-check-report %t/too-complex.json %s -D TOO_COMPLEX 2>/dev/null
+// RUN: FileCheck -check-prefix=TOO-COMPLEX %s < %t/too-complex.json
+
+// CHECK: "total-expressions":
+// CHECK: "total-wall-time-ms":
+// CHECK: "expressions": [
+// CHECK: "file": "{{.*}}expression_type_check_report.swift",
+// CHECK-NEXT: "line": {{[0-9]+}},
+// CHECK-NEXT: "column": {{[0-9]+}},
+// CHECK-NEXT: "wall-time-ms": {{[0-9.e+-]+}},
+// CHECK-NEXT: "states-explored": {{[0-9]+}},
+// CHECK-NEXT: "solver-memory": {{[0-9]+}},
+// CHECK-NEXT: "too-complex": false
+
+// TOO-COMPLEX: "line": 27,
+// TOO-COMPLEX: "too-complex": true
+
+var a = 1 + 2 * 3
+var b = [1, 2, 3].map { $0 * 2 }
+let c = "\(a) \(b)"
+
+#if TOO_COMPLEX
+var x = [1, 2, 3, 4.5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18 ,19]
+#endif
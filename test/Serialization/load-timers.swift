@@ -0,0 +1,11 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %target-swift-frontend -emit-module -o %t %S/Inputs/def_func.swift
+// RUN: %target-swift-frontend -parse -I %t -debug-time-compilation %s 2>&1 | FileCheck %s
+
+// Every module loaded gets a timer of its own. The time spent loading the
+// standard library is not counted again in the timer of def_func.
+
+import def_func
+
+// CHECK-DAG: Load module Swift
+// CHECK-DAG: Load module def_func
@@ -16,6 +16,19 @@ import Foo
 // RUN: FileCheck %s < %t.completions2
 // CHECK: key.name: "FooStruct
 
+// Without fuzzy matching, the session only reads the cached results whose name
+// starts with the filter text, and reads the others once the filter text no
+// longer starts with it.
+// RUN: %sourcekitd-test -req=complete.cache.ondisk -cache-path=%t.ccp == \
+// RUN:     -req=complete.open -pos=2:1 -req-opts=hidelowpriority=0,fuzzymatching=0,filtertext=fooHelper %s -- %s -F %S/../Inputs/libIDE-mock-sdk == \
+// RUN:     -req=complete.update -pos=2:1 -req-opts=hidelowpriority=0,fuzzymatching=0,filtertext=foo %s -- %s -F %S/../Inputs/libIDE-mock-sdk > %t.completions3
+// RUN: FileCheck %s -check-prefix=UNREFINE < %t.completions3
+// UNREFINE-NOT: key.name: "fooFunc
+// UNREFINE: key.name: "fooHelperSubFunc1(:)"
+// UNREFINE-NOT: key.name: "fooFunc
+// UNREFINE: {{^}}}{{$}}
+// UNREFINE: key.name: "fooFunc
+
 // RUN: %complete-test -raw -tok=VOID_1 %s -- -F %S/../Inputs/libIDE-mock-sdk | FileCheck %s -check-prefix=VOID_1
 // RUN: %complete-test -raw -tok=VOID_2 %s -- -F %S/../Inputs/libIDE-mock-sdk | FileCheck %s -check-prefix=VOID_1
 // RUN: %complete-test -raw -tok=VOID_3 %s -- -F %S/../Inputs/libIDE-mock-sdk | FileCheck %s -check-prefix=VOID_3
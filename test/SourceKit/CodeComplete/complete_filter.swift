@@ -124,3 +124,64 @@ struct UnnamedArgs {
 // UNNAMED_ARGS_0-NEXT: ]
 // UNNAMED_ARGS_0-NEXT: Results for filterText: unnamed [
 // UNNAMED_ARGS_0-NEXT: ]
+
+func refineAaa() {}
+func refineAab() {}
+func refineAbc() {}
+func refineB() {}
+
+func testRefine() {
+  #^REFINE,refine,refineA,refineAb,refineAbc,refinea,refine,refineB^#
+}
+
+// Typing more of the filter text only filters the results that matched the
+// previous one. Deleting some of it, or typing something else, must bring
+// back the results that were filtered out.
+// RUN: %complete-test -no-fuzz -tok=REFINE %s | FileCheck %s -check-prefix=REFINE
+// REFINE-LABEL: Results for filterText: refine [
+// REFINE-NEXT:   refineAaa()
+// REFINE-NEXT:   refineAab()
+// REFINE-NEXT:   refineAbc()
+// REFINE-NEXT:   refineB()
+// REFINE-NEXT: ]
+// REFINE-LABEL: Results for filterText: refineA [
+// REFINE-NEXT:   refineAaa()
+// REFINE-NEXT:   refineAab()
+// REFINE-NEXT:   refineAbc()
+// REFINE-NEXT: ]
+// REFINE-LABEL: Results for filterText: refineAb [
+// REFINE-NEXT:   refineAbc()
+// REFINE-NEXT: ]
+// REFINE-LABEL: Results for filterText: refineAbc [
+// REFINE-NEXT:   refineAbc()
+// REFINE-NEXT: ]
+// REFINE-LABEL: Results for filterText: refinea [
+// REFINE-NEXT:   refineAaa()
+// REFINE-NEXT:   refineAab()
+// REFINE-NEXT:   refineAbc()
+// REFINE-NEXT: ]
+// REFINE-LABEL: Results for filterText: refine [
+// REFINE-NEXT:   refineAaa()
+// REFINE-NEXT:   refineAab()
+// REFINE-NEXT:   refineAbc()
+// REFINE-NEXT:   refineB()
+// REFINE-NEXT: ]
+// REFINE-LABEL: Results for filterText: refineB [
+// REFINE-NEXT:   refineB()
+// REFINE-NEXT: ]
+
+// RUN: %complete-test -fuzz -tok=REFINE_FUZZY %s | FileCheck %s -check-prefix=REFINE_FUZZY
+func testRefineFuzzy() {
+  #^REFINE_FUZZY,refineAb,refineAbc,refineAb^#
+}
+// REFINE_FUZZY-LABEL: Results for filterText: refineAb [
+// REFINE_FUZZY-DAG:   refineAab()
+// REFINE_FUZZY-DAG:   refineAbc()
+// REFINE_FUZZY: ]
+// REFINE_FUZZY-LABEL: Results for filterText: refineAbc [
+// REFINE_FUZZY-NEXT:   refineAbc()
+// REFINE_FUZZY-NEXT: ]
+// REFINE_FUZZY-LABEL: Results for filterText: refineAb [
+// REFINE_FUZZY-DAG:   refineAab()
+// REFINE_FUZZY-DAG:   refineAbc()
+// REFINE_FUZZY: ]
@@ -151,6 +151,17 @@ func test4(x: Int) {
 // EXPR_TOP_3: nil
 // EXPR_TOP_3: zzz
 
+// Ordering only the requested page of results must give the same page as
+// ordering all of them, including the top results moved in front of the
+// literals.
+// RUN: %complete-test -top=3 -tok=EXPR_2 %s > %t.all
+// RUN: %complete-test -top=3 -limit=2 -tok=EXPR_2 %s > %t.limit2
+// RUN: head -n 2 %t.all | diff - %t.limit2
+// RUN: %complete-test -top=3 -limit=5 -tok=EXPR_2 %s > %t.limit5
+// RUN: head -n 5 %t.all | diff - %t.limit5
+// RUN: %complete-test -top=3 -limit=12 -tok=EXPR_2 %s > %t.limit12
+// RUN: head -n 12 %t.all | diff - %t.limit12
+
 // Top 3 with type matching
 // RUN: %complete-test -top=3 -tok=EXPR_3 %s | FileCheck %s -check-prefix=EXPR_TOP_3_TYPE_MATCH
 func test4(x: Int) {
@@ -0,0 +1,26 @@
+func foo() {}
+
+// Each cursor info request needs the AST of this file or of other.swift.
+
+// RUN: %sourcekitd-test \
+// RUN:     -req=cursor -pos=1:6 %s -- %s == \
+// RUN:     -req=cursor -pos=1:6 %S/Inputs/ast-cache/other.swift -- %S/Inputs/ast-cache/other.swift == \
+// RUN:     -req=cursor -pos=1:6 %s -- %s == \
+// RUN:     -json-request-path %S/Inputs/ast-cache/statistics.json | FileCheck %s -check-prefix=UNLIMITED
+
+// UNLIMITED: key.hits: 1
+// UNLIMITED-NEXT: key.misses: 2
+// UNLIMITED-NEXT: key.evictions: 0
+
+// With a limit below the size of any AST, only the AST built last is kept, so
+// the AST of this file is dropped and built again.
+
+// RUN: %sourcekitd-test -json-request-path %S/Inputs/ast-cache/limit.json == \
+// RUN:     -req=cursor -pos=1:6 %s -- %s == \
+// RUN:     -req=cursor -pos=1:6 %S/Inputs/ast-cache/other.swift -- %S/Inputs/ast-cache/other.swift == \
+// RUN:     -req=cursor -pos=1:6 %s -- %s == \
+// RUN:     -json-request-path %S/Inputs/ast-cache/statistics.json | FileCheck %s -check-prefix=LIMITED
+
+// LIMITED: key.hits: 0
+// LIMITED-NEXT: key.misses: 3
+// LIMITED-NEXT: key.evictions: 2
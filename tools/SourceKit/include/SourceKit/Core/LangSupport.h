@@ -288,6 +288,20 @@ struct RelatedIdentsInfo {
   ArrayRef<std::pair<unsigned, unsigned>> Ranges;
 };
 
+/// Filled out by LangSupport::getASTCacheStatistics().
+struct ASTCacheStatistics {
+  /// The number of requests that were served by an up-to-date AST.
+  unsigned Hits = 0;
+  /// The number of requests that needed an AST to be built or rebuilt.
+  unsigned Misses = 0;
+  /// The number of ASTs that were dropped to stay within the memory limit.
+  unsigned Evictions = 0;
+  /// The total time spent building ASTs, in seconds.
+  double BuildTime = 0;
+  /// The memory currently used by the cached ASTs, in bytes.
+  size_t MemoryUsage = 0;
+};
+
 /// Filled out by LangSupport::findInterfaceDocument().
 struct InterfaceDocInfo {
   /// Non-empty if an error occurred.
@@ -477,6 +491,12 @@ public:
                           StringRef ModuleName,
                           ArrayRef<const char *> Args,
                           DocInfoConsumer &Consumer) = 0;
+
+  virtual ASTCacheStatistics getASTCacheStatistics() = 0;
+
+  /// Sets the memory that the cached ASTs may use, in bytes, dropping ASTs
+  /// right away if they use more than that.
+  virtual void setASTCacheMemoryLimit(size_t Bytes) = 0;
 };
 
 } // namespace SourceKit
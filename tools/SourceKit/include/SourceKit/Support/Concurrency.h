@@ -14,6 +14,8 @@
 #define LLVM_SOURCEKIT_SUPPORT_CONCURRENCY_H
 
 #include "llvm/ADT/StringRef.h"
+#include <algorithm>
+#include <thread>
 
 namespace SourceKit {
 
@@ -154,6 +156,36 @@ public:
                                                 isStackDeep));
   }
 
+  /// Calls \p Fn(Begin, End) on consecutive ranges that cover [0, Count),
+  /// from several threads at once if each of them gets at least
+  /// \p MinPerThread indices. Returns once all of the calls are done.
+  template <typename Callable>
+  static void concurrentApplyRanges(size_t Count, size_t MinPerThread,
+                                    Callable &&Fn) {
+    size_t NumThreads = std::min<size_t>(
+        std::thread::hardware_concurrency(),
+        Count / std::max<size_t>(MinPerThread, 1));
+    if (NumThreads <= 1) {
+      Fn(size_t(0), Count);
+      return;
+    }
+
+    size_t PerThread = (Count + NumThreads - 1) / NumThreads;
+    Semaphore Done(0);
+    size_t NumDispatched = 0;
+    for (size_t Begin = PerThread; Begin < Count; Begin += PerThread) {
+      size_t End = std::min(Count, Begin + PerThread);
+      dispatchConcurrent([&Fn, &Done, Begin, End] {
+        Fn(Begin, End);
+        Done.signal();
+      });
+      ++NumDispatched;
+    }
+    Fn(size_t(0), PerThread);
+    while (NumDispatched--)
+      Done.wait();
+  }
+
   void suspend() {
     Impl::suspend(ImplObj);
   }
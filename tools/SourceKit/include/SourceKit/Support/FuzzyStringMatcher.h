@@ -32,6 +32,8 @@ class FuzzyStringMatcher {
   double maxScore; ///< The maximum possible raw score for this pattern.
   /// If (and only if) c is in pattern, charactersInPattern[c] == 1
   llvm::BitVector charactersInPattern;
+  /// The character mask of the pattern, see \c getCharacterMask().
+  uint64_t patternCharacterMask;
 
 public:
   bool normalize = false; ///< Whether to normalize scores to [0, 1].
@@ -47,6 +49,19 @@ public:
 
   /// Calculates the numerical score for \p candidate.
   double scoreCandidate(StringRef candidate) const;
+
+  /// Returns a mask with one bit set for each character of \p text, ignoring
+  /// case. Different characters may share a bit.
+  static uint64_t getCharacterMask(StringRef text);
+
+  /// Whether a candidate with the character mask \p candidateMask may match
+  /// the pattern; if this is false, \c matchesCandidate() is false too.
+  ///
+  /// This only tests the bits of the masks, so it is much faster than
+  /// \c matchesCandidate() to rule out most candidates.
+  bool mayMatchCandidate(uint64_t candidateMask) const {
+    return (candidateMask & patternCharacterMask) == patternCharacterMask;
+  }
 };
 
 } // end namespace SourceKit
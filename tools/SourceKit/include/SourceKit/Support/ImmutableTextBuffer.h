@@ -14,6 +14,7 @@
 #define LLVM_SOURCEKIT_SUPPORT_IMMUTABLETEXTBUFFER_H
 
 #include "SourceKit/Core/LLVM.h"
+#include "SourceKit/Support/TextRope.h"
 #include "SourceKit/Support/ThreadSafeRefCntPtr.h"
 #include "swift/Basic/ThreadSafeRefCounted.h"
 #include "llvm/ADT/StringMap.h"
@@ -57,12 +58,17 @@ public:
   Kind getKind() const { return K; }
   uint64_t getStamp() const { return Stamp; }
 
+  /// Returns the text after this update.
+  const TextRope &getRope() const { return Rope; }
+
 protected:
-  ImmutableTextUpdate(Kind K, uint64_t Stamp) : K(K), Stamp(Stamp) {}
+  ImmutableTextUpdate(Kind K, uint64_t Stamp, TextRope Rope)
+    : K(K), Stamp(Stamp), Rope(std::move(Rope)) {}
 
 private:
   Kind K;
   uint64_t Stamp;
+  TextRope Rope;
   ThreadSafeRefCntPtr<ImmutableTextUpdate> Next;
 
   friend class EditableTextBuffer;
@@ -77,6 +83,9 @@ public:
   explicit ImmutableTextBuffer(std::unique_ptr<llvm::MemoryBuffer> MemBuf,
                                uint64_t Stamp);
   ImmutableTextBuffer(StringRef Filename, StringRef Text, uint64_t Stamp);
+  /// Creates a buffer with the text of \p Rope, which is copied to \p MemBuf.
+  ImmutableTextBuffer(std::unique_ptr<llvm::MemoryBuffer> MemBuf,
+                      uint64_t Stamp, TextRope Rope);
 
   StringRef getText() const;
   StringRef getFilename() const;
@@ -100,7 +109,8 @@ class ReplaceImmutableTextUpdate : public ImmutableTextUpdate {
 
 public:
   ReplaceImmutableTextUpdate(unsigned ByteOffset, unsigned Length,
-                             StringRef Text, uint64_t Stamp);
+                             StringRef Text, uint64_t Stamp,
+                             TextRope NewRope);
 
   unsigned getByteOffset() const { return ByteOffset; }
   unsigned getLength() const { return Length; }
@@ -115,19 +125,11 @@ class ImmutableTextSnapshot :
     public ThreadSafeRefCountedBase<ImmutableTextSnapshot> {
 
   EditableTextBufferRef EditableBuf;
-  ImmutableTextBufferRef BufferStart;
   ImmutableTextUpdateRef DiffEnd;
 
   ImmutableTextSnapshot(EditableTextBufferRef EditableBuf,
-                        ImmutableTextBufferRef Buffer)
-    : EditableBuf(std::move(EditableBuf)),
-      BufferStart(std::move(Buffer)), DiffEnd(BufferStart) {}
-
-  ImmutableTextSnapshot(EditableTextBufferRef EditableBuf,
-                        ImmutableTextBufferRef BufferStart,
                         ImmutableTextUpdateRef DiffEnd)
-    : EditableBuf(std::move(EditableBuf)),
-      BufferStart(std::move(BufferStart)), DiffEnd(std::move(DiffEnd)) {}
+    : EditableBuf(std::move(EditableBuf)), DiffEnd(std::move(DiffEnd)) {}
 
 friend class EditableTextBuffer;
 
@@ -138,6 +140,16 @@ public:
 
   ImmutableTextBufferRef getBuffer() const;
 
+  /// Returns the text of the snapshot, without making a contiguous copy of it
+  /// like \c getBuffer() does.
+  const TextRope &getRope() const { return DiffEnd->getRope(); }
+
+  size_t getSize() const { return getRope().size(); }
+
+  std::pair<unsigned, unsigned> getLineAndColumn(unsigned ByteOffset) const {
+    return getRope().getLineAndColumn(ByteOffset);
+  }
+
   bool isFromSameBuffer(ImmutableTextSnapshotRef Other) const {
     return Other->EditableBuf.get() == EditableBuf.get();
   }
@@ -154,7 +166,6 @@ public:
 
 class EditableTextBuffer : public ThreadSafeRefCountedBase<EditableTextBuffer> {
   llvm::sys::Mutex EditMtx;
-  ImmutableTextBufferRef Root;
   ImmutableTextUpdateRef CurrUpd;
   std::string Filename;
 
@@ -175,7 +186,8 @@ public:
                                    StringRef Text);
 
 private:
-  ImmutableTextSnapshotRef addAtomicUpdate(ImmutableTextUpdateRef NewUpd);
+  ImmutableTextSnapshotRef addAtomicUpdate(unsigned ByteOffset,
+                                           unsigned Length, StringRef Text);
   ImmutableTextBufferRef getBufferForSnapshot(
       const ImmutableTextSnapshot &Snap);
   void refresh();
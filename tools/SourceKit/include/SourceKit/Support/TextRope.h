@@ -0,0 +1,106 @@
+//===--- TextRope.h - Persistent text rope ----------------------*- C++ -*-===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SOURCEKIT_SUPPORT_TEXTROPE_H
+#define LLVM_SOURCEKIT_SUPPORT_TEXTROPE_H
+
+#include "SourceKit/Core/LLVM.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+
+namespace SourceKit {
+
+/// Immutable storage for text that pieces of one or more ropes refer to.
+class TextRopeChunk : public ThreadSafeRefCountedBase<TextRopeChunk> {
+public:
+  const std::string Text;
+
+  explicit TextRopeChunk(StringRef Text) : Text(Text.str()) {}
+};
+
+/// A node of a \c TextRope. Each node holds a piece of a chunk and the totals
+/// of its subtree, and is never modified once created.
+class TextRopeNode : public ThreadSafeRefCountedBase<TextRopeNode> {
+public:
+  RefPtr<const TextRopeChunk> Chunk;
+  unsigned Start;
+  unsigned Length;
+  unsigned Newlines;
+
+  RefPtr<const TextRopeNode> Left;
+  RefPtr<const TextRopeNode> Right;
+  uint32_t Priority;
+
+  size_t TotalLength;
+  size_t TotalNewlines;
+
+  TextRopeNode(RefPtr<const TextRopeChunk> Chunk, unsigned Start,
+               unsigned Length, unsigned Newlines,
+               RefPtr<const TextRopeNode> Left,
+               RefPtr<const TextRopeNode> Right, uint32_t Priority);
+
+  StringRef getPiece() const {
+    return StringRef(Chunk->Text).substr(Start, Length);
+  }
+};
+
+/// An immutable text, stored as a balanced tree of pieces of text chunks.
+///
+/// Editing a rope returns a new rope that shares all but O(log n) of its nodes
+/// with the original, so every version of an edited text can be kept around
+/// cheaply. Each node also counts the newlines of its subtree, which makes
+/// mapping between offsets and lines O(log n) as well.
+class TextRope {
+  RefPtr<const TextRopeNode> Root;
+
+  explicit TextRope(RefPtr<const TextRopeNode> Root) : Root(std::move(Root)) {}
+
+public:
+  TextRope() = default;
+  explicit TextRope(StringRef Text);
+
+  size_t size() const { return Root ? Root->TotalLength : 0; }
+  bool empty() const { return size() == 0; }
+
+  /// Returns the number of lines, which is one more than the number of
+  /// newlines.
+  unsigned getNumLines() const {
+    return (Root ? Root->TotalNewlines : 0) + 1;
+  }
+
+  TextRope insert(size_t Offset, StringRef Text) const;
+  TextRope erase(size_t Offset, size_t Length) const;
+  TextRope replace(size_t Offset, size_t Length, StringRef Text) const;
+
+  /// Returns the 1-based line and column of \p Offset, or (0, 0) if it is past
+  /// the end of the text.
+  std::pair<unsigned, unsigned> getLineAndColumn(size_t Offset) const;
+
+  /// Returns the offset of the start of the 1-based line \p Line, or None if
+  /// the text does not have that many lines.
+  Optional<size_t> getLineStartOffset(unsigned Line) const;
+
+  /// Calls \p Fn with each piece of the text, in order.
+  void forEachPiece(llvm::function_ref<void(StringRef)> Fn) const;
+
+  /// Copies the text to \p Out, which must have room for \c size() bytes.
+  void copyTo(char *Out) const;
+
+  std::string str() const;
+};
+
+} // namespace SourceKit
+
+#endif
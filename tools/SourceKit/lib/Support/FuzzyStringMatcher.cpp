@@ -22,7 +22,8 @@ using clang::isUppercase;
 using clang::isLowercase;
 
 FuzzyStringMatcher::FuzzyStringMatcher(StringRef pattern_)
-    : pattern(pattern_), charactersInPattern(1 << (sizeof(char) * 8)) {
+    : pattern(pattern_), charactersInPattern(1 << (sizeof(char) * 8)),
+      patternCharacterMask(getCharacterMask(pattern_)) {
   lowercasePattern.reserve(pattern.size());
   unsigned upperCharCount = 0;
   for (char c : pattern) {
@@ -50,6 +51,13 @@ FuzzyStringMatcher::FuzzyStringMatcher(StringRef pattern_)
   }
 }
 
+uint64_t FuzzyStringMatcher::getCharacterMask(StringRef text) {
+  uint64_t mask = 0;
+  for (char c : text)
+    mask |= uint64_t(1) << (static_cast<unsigned char>(toLowercase(c)) % 64);
+  return mask;
+}
+
 bool FuzzyStringMatcher::matchesCandidate(StringRef candidate) const {
   unsigned patternLength = pattern.size();
   unsigned candidateLength = candidate.size();
@@ -11,19 +11,24 @@
 //===----------------------------------------------------------------------===//
 
 #include "SourceKit/Support/ImmutableTextBuffer.h"
-#include "clang/Rewrite/Core/RewriteRope.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 
 using namespace SourceKit;
 using namespace llvm;
-using clang::RewriteRope;
 
 void ImmutableTextUpdate::anchor() {}
 
 ImmutableTextBuffer::ImmutableTextBuffer(
     std::unique_ptr<llvm::MemoryBuffer> MemBuf, uint64_t Stamp)
-  : ImmutableTextUpdate(Kind::Buffer, Stamp) {
+  : ImmutableTextUpdate(Kind::Buffer, Stamp, TextRope(MemBuf->getBuffer())) {
+    SrcMgr.reset(new SourceMgr);
+    BufId = SrcMgr->AddNewSourceBuffer(std::move(MemBuf), SMLoc());
+  }
+
+ImmutableTextBuffer::ImmutableTextBuffer(
+    std::unique_ptr<llvm::MemoryBuffer> MemBuf, uint64_t Stamp, TextRope Rope)
+  : ImmutableTextUpdate(Kind::Buffer, Stamp, std::move(Rope)) {
     SrcMgr.reset(new SourceMgr);
     BufId = SrcMgr->AddNewSourceBuffer(std::move(MemBuf), SMLoc());
   }
@@ -51,18 +56,13 @@ const llvm::MemoryBuffer *ImmutableTextBuffer::getInternalBuffer() const {
 
 std::pair<unsigned, unsigned>
 ImmutableTextBuffer::getLineAndColumn(unsigned ByteOffset) const {
-  auto Buf = SrcMgr->getMemoryBuffer(BufId);
-  if (ByteOffset > Buf->getBufferSize())
-    return std::make_pair(0, 0);
-
-  SMLoc Loc = SMLoc::getFromPointer(Buf->getBufferStart() + ByteOffset);
-  return SrcMgr->getLineAndColumn(Loc, 0);
+  return getRope().getLineAndColumn(ByteOffset);
 }
 
 ReplaceImmutableTextUpdate::ReplaceImmutableTextUpdate(
     unsigned ByteOffset, unsigned Length,
-    StringRef Text, uint64_t Stamp)
-  : ImmutableTextUpdate(Kind::Replace, Stamp),
+    StringRef Text, uint64_t Stamp, TextRope NewRope)
+  : ImmutableTextUpdate(Kind::Replace, Stamp, std::move(NewRope)),
     Buf(llvm::MemoryBuffer::getMemBufferCopy(Text)),
     ByteOffset(ByteOffset), Length(Length) {
 }
@@ -121,71 +121,48 @@ static std::atomic<uint64_t> Generation{ 0 };
 
 EditableTextBuffer::EditableTextBuffer(StringRef Filename, StringRef Text) {
   this->Filename = Filename;
-  Root = new ImmutableTextBuffer(Filename, Text, ++Generation);
-  CurrUpd = Root;
+  CurrUpd = new ImmutableTextBuffer(Filename, Text, ++Generation);
 }
 
 ImmutableTextSnapshotRef EditableTextBuffer::getSnapshot() const {
-  return new ImmutableTextSnapshot(const_cast<EditableTextBuffer*>(this), Root,
+  return new ImmutableTextSnapshot(const_cast<EditableTextBuffer*>(this),
                                    CurrUpd);
 }
 
 ImmutableTextSnapshotRef EditableTextBuffer::insert(unsigned ByteOffset,
     StringRef Text) {
-  ImmutableTextUpdateRef NewUpd =
-      new ReplaceImmutableTextUpdate(ByteOffset, /*Length=*/0, Text,
-                                     ++Generation);
-  return addAtomicUpdate(std::move(NewUpd));
+  return addAtomicUpdate(ByteOffset, /*Length=*/0, Text);
 }
 
 ImmutableTextSnapshotRef EditableTextBuffer::erase(unsigned ByteOffset,
                                                    unsigned Length) {
-  ImmutableTextUpdateRef NewUpd =
-      new ReplaceImmutableTextUpdate(ByteOffset, Length, StringRef(),
-                                     ++Generation);
-  return addAtomicUpdate(std::move(NewUpd));
+  return addAtomicUpdate(ByteOffset, Length, StringRef());
 }
 
 ImmutableTextSnapshotRef EditableTextBuffer::replace(unsigned ByteOffset,
                                                      unsigned Length,
                                                      StringRef Text) {
-  ImmutableTextUpdateRef NewUpd =
-      new ReplaceImmutableTextUpdate(ByteOffset, Length, Text, ++Generation);
-  return addAtomicUpdate(std::move(NewUpd));
+  return addAtomicUpdate(ByteOffset, Length, Text);
 }
 
 ImmutableTextSnapshotRef EditableTextBuffer::addAtomicUpdate(
-    ImmutableTextUpdateRef NewUpd) {
+    unsigned ByteOffset, unsigned Length, StringRef Text) {
 
   llvm::sys::ScopedLock L(EditMtx);
 
   refresh();
 
+  // The new rope shares all but O(log n) nodes with the current one.
+  TextRope NewRope = CurrUpd->getRope().replace(ByteOffset, Length, Text);
+  ImmutableTextUpdateRef NewUpd =
+      new ReplaceImmutableTextUpdate(ByteOffset, Length, Text, ++Generation,
+                                     std::move(NewRope));
+
   assert(CurrUpd->Next == nullptr);
   CurrUpd->Next = NewUpd;
   CurrUpd = NewUpd;
 
-  return new ImmutableTextSnapshot(this, Root, CurrUpd);
-}
-
-static std::unique_ptr<llvm::MemoryBuffer>
-getMemBufferFromRope(StringRef Filename, const RewriteRope &Rope) {
-  size_t Length = 0;
-  for (RewriteRope::iterator I = Rope.begin(), E = Rope.end(); I != E;
-       I.MoveToNextPiece()) {
-    Length += I.piece().size();
-  }
-
-  auto MemBuf = llvm::MemoryBuffer::getNewUninitMemBuffer(Length, Filename);
-  char *Ptr = (char*)MemBuf->getBufferStart();
-  for (RewriteRope::iterator I = Rope.begin(), E = Rope.end(); I != E;
-       I.MoveToNextPiece()) {
-    StringRef Text = I.piece();
-    memcpy(Ptr, Text.data(), Text.size());
-    Ptr += Text.size();
-  }
-
-  return MemBuf;
+  return new ImmutableTextSnapshot(this, CurrUpd);
 }
 
 ImmutableTextBufferRef EditableTextBuffer::getBufferForSnapshot(
@@ -198,35 +175,13 @@ ImmutableTextBufferRef EditableTextBuffer::getBufferForSnapshot(
     if (auto Buf = dyn_cast<ImmutableTextBuffer>(Next))
       return Buf;
 
-  // Check if a buffer was created in the middle of the snapshot updates.
-  ImmutableTextBufferRef StartBuf = Snap.BufferStart;
-  ImmutableTextUpdateRef Upd = StartBuf;  
-  while (Upd != Snap.DiffEnd) {
-    Upd = Upd->Next;
-    if (auto Buf = dyn_cast<ImmutableTextBuffer>(Upd))
-      StartBuf = Buf;
-  }
-  StringRef StartText = StartBuf->getText();
-
-  RewriteRope Rope;
-  auto applyUpdate = [&](const ImmutableTextUpdateRef &Upd) {
-    if (auto ReplaceUpd = dyn_cast<ReplaceImmutableTextUpdate>(Upd)) {
-      Rope.erase(ReplaceUpd->getByteOffset(), ReplaceUpd->getLength());
-      StringRef Text = ReplaceUpd->getText();
-      Rope.insert(ReplaceUpd->getByteOffset(), Text.begin(), Text.end());
-    }
-  };
-
-  Rope.assign(StartText.begin(), StartText.end());
-  Upd = StartBuf;
-  while (Upd != Snap.DiffEnd) {
-    Upd = Upd->Next;
-    applyUpdate(Upd);
-  }
-
-  auto MemBuf = getMemBufferFromRope(getFilename(), Rope);
+  const TextRope &Rope = Snap.getRope();
+  auto MemBuf = llvm::MemoryBuffer::getNewUninitMemBuffer(Rope.size(),
+                                                          getFilename());
+  Rope.copyTo(const_cast<char *>(MemBuf->getBufferStart()));
   ImmutableTextBufferRef ImmBuf = new ImmutableTextBuffer(std::move(MemBuf),
-                                                          Snap.getStamp());
+                                                          Snap.getStamp(),
+                                                          Rope);
 
   {
     llvm::sys::ScopedLock L(EditMtx);
@@ -239,11 +194,8 @@ ImmutableTextBufferRef EditableTextBuffer::getBufferForSnapshot(
 
 // This should always be called under the mutex lock.
 void EditableTextBuffer::refresh() {
-  while (CurrUpd->Next) {
+  while (CurrUpd->Next)
     CurrUpd = CurrUpd->Next;
-    if (auto Buf = dyn_cast<ImmutableTextBuffer>(CurrUpd))
-      Root = Buf;
-  }
 }
 
 EditableTextBufferRef EditableTextBufferManager::getOrCreateBuffer(
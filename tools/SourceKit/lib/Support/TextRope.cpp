@@ -0,0 +1,242 @@
+//===--- TextRope.cpp -----------------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// The rope is a treap: the nodes are ordered by text offset and each node has
+// a priority no lower than those of its children. Random priorities keep the
+// tree balanced in expectation, and splitting and merging only copy the nodes
+// on the paths they walk.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SourceKit/Support/TextRope.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+using namespace SourceKit;
+
+typedef RefPtr<const TextRopeNode> NodeRef;
+
+/// The maximum length of the pieces a new text is cut into. This bounds the
+/// work of counting newlines when a piece is split.
+static const size_t MaxPieceLength = 1024;
+
+static uint32_t getNextPriority() {
+  static std::atomic<uint32_t> Counter{ 0 };
+  // Scramble the counter so that priorities look random (murmur3 finalizer).
+  uint32_t H = ++Counter;
+  H ^= H >> 16;
+  H *= 0x85ebca6b;
+  H ^= H >> 13;
+  H *= 0xc2b2ae35;
+  H ^= H >> 16;
+  return H;
+}
+
+static unsigned countNewlines(StringRef Text) {
+  return std::count(Text.begin(), Text.end(), '\n');
+}
+
+static size_t getLength(const NodeRef &N) {
+  return N ? N->TotalLength : 0;
+}
+
+static size_t getNewlines(const NodeRef &N) {
+  return N ? N->TotalNewlines : 0;
+}
+
+TextRopeNode::TextRopeNode(RefPtr<const TextRopeChunk> Chunk, unsigned Start,
+                           unsigned Length, unsigned Newlines,
+                           NodeRef Left, NodeRef Right, uint32_t Priority)
+  : Chunk(std::move(Chunk)), Start(Start), Length(Length),
+    Newlines(Newlines), Left(std::move(Left)), Right(std::move(Right)),
+    Priority(Priority) {
+  TotalLength = getLength(this->Left) + Length + getLength(this->Right);
+  TotalNewlines = getNewlines(this->Left) + Newlines +
+                  getNewlines(this->Right);
+}
+
+/// Returns a copy of \p N with different children.
+static NodeRef withChildren(const NodeRef &N, NodeRef Left, NodeRef Right) {
+  return new TextRopeNode(N->Chunk, N->Start, N->Length, N->Newlines,
+                          std::move(Left), std::move(Right), N->Priority);
+}
+
+/// Concatenates the texts of \p L and \p R.
+static NodeRef merge(const NodeRef &L, const NodeRef &R) {
+  if (!L)
+    return R;
+  if (!R)
+    return L;
+  if (L->Priority >= R->Priority)
+    return withChildren(L, L->Left, merge(L->Right, R));
+  return withChildren(R, merge(L, R->Left), R->Right);
+}
+
+/// Splits the text of \p N into the parts before and after \p Offset.
+static std::pair<NodeRef, NodeRef> split(const NodeRef &N, size_t Offset) {
+  if (!N)
+    return { nullptr, nullptr };
+  if (Offset == 0)
+    return { nullptr, N };
+  if (Offset >= N->TotalLength)
+    return { N, nullptr };
+
+  size_t LeftLength = getLength(N->Left);
+  if (Offset <= LeftLength) {
+    auto Parts = split(N->Left, Offset);
+    return { Parts.first, withChildren(N, Parts.second, N->Right) };
+  }
+
+  size_t PieceEnd = LeftLength + N->Length;
+  if (Offset >= PieceEnd) {
+    auto Parts = split(N->Right, Offset - PieceEnd);
+    return { withChildren(N, N->Left, Parts.first), Parts.second };
+  }
+
+  // The offset is inside this node's piece; cut it in two. Both halves keep
+  // the priority of the node, which is no lower than that of its children.
+  unsigned Head = Offset - LeftLength;
+  unsigned HeadNewlines = countNewlines(N->getPiece().substr(0, Head));
+  NodeRef L = new TextRopeNode(N->Chunk, N->Start, Head, HeadNewlines,
+                               N->Left, nullptr, N->Priority);
+  NodeRef R = new TextRopeNode(N->Chunk, N->Start + Head, N->Length - Head,
+                               N->Newlines - HeadNewlines,
+                               nullptr, N->Right, N->Priority);
+  return { L, R };
+}
+
+static NodeRef build(StringRef Text) {
+  if (Text.empty())
+    return nullptr;
+
+  RefPtr<const TextRopeChunk> Chunk = new TextRopeChunk(Text);
+  NodeRef Result;
+  for (size_t Start = 0; Start < Text.size(); Start += MaxPieceLength) {
+    size_t Length = std::min(MaxPieceLength, Text.size() - Start);
+    NodeRef Piece = new TextRopeNode(Chunk, Start, Length,
+                                     countNewlines(Text.substr(Start, Length)),
+                                     nullptr, nullptr, getNextPriority());
+    Result = merge(Result, Piece);
+  }
+  return Result;
+}
+
+TextRope::TextRope(StringRef Text) : Root(build(Text)) {}
+
+TextRope TextRope::insert(size_t Offset, StringRef Text) const {
+  return replace(Offset, 0, Text);
+}
+
+TextRope TextRope::erase(size_t Offset, size_t Length) const {
+  return replace(Offset, Length, StringRef());
+}
+
+TextRope TextRope::replace(size_t Offset, size_t Length,
+                           StringRef Text) const {
+  assert(Offset + Length <= size() && "replaced range out of bounds");
+  auto Before = split(Root, Offset);
+  auto After = split(Before.second, Length);
+  return TextRope(merge(merge(Before.first, build(Text)), After.second));
+}
+
+std::pair<unsigned, unsigned>
+TextRope::getLineAndColumn(size_t Offset) const {
+  if (Offset > size())
+    return std::make_pair(0, 0);
+
+  // Count the newlines before the offset.
+  size_t Newlines = 0;
+  size_t Remaining = Offset;
+  const TextRopeNode *N = Root.get();
+  while (N && Remaining) {
+    size_t LeftLength = getLength(N->Left);
+    if (Remaining <= LeftLength) {
+      N = N->Left.get();
+      continue;
+    }
+
+    Newlines += getNewlines(N->Left);
+    Remaining -= LeftLength;
+    if (Remaining <= N->Length) {
+      Newlines += countNewlines(N->getPiece().substr(0, Remaining));
+      break;
+    }
+
+    Newlines += N->Newlines;
+    Remaining -= N->Length;
+    N = N->Right.get();
+  }
+
+  unsigned Line = Newlines + 1;
+  return std::make_pair(Line, Offset - *getLineStartOffset(Line) + 1);
+}
+
+Optional<size_t> TextRope::getLineStartOffset(unsigned Line) const {
+  if (Line == 0 || Line > getNumLines())
+    return None;
+
+  // Find the end of the (Line - 1)th newline.
+  size_t Remaining = Line - 1;
+  size_t Offset = 0;
+  const TextRopeNode *N = Root.get();
+  while (N && Remaining) {
+    size_t LeftNewlines = getNewlines(N->Left);
+    if (Remaining <= LeftNewlines) {
+      N = N->Left.get();
+      continue;
+    }
+
+    Remaining -= LeftNewlines;
+    Offset += getLength(N->Left);
+    if (Remaining <= N->Newlines) {
+      StringRef Piece = N->getPiece();
+      size_t Pos = 0;
+      for (; Remaining; --Remaining)
+        Pos = Piece.find('\n', Pos) + 1;
+      return Offset + Pos;
+    }
+
+    Remaining -= N->Newlines;
+    Offset += N->Length;
+    N = N->Right.get();
+  }
+
+  return Offset;
+}
+
+static void forEachPiece(const TextRopeNode *N,
+                         llvm::function_ref<void(StringRef)> Fn) {
+  while (N) {
+    forEachPiece(N->Left.get(), Fn);
+    Fn(N->getPiece());
+    N = N->Right.get();
+  }
+}
+
+void TextRope::forEachPiece(llvm::function_ref<void(StringRef)> Fn) const {
+  ::forEachPiece(Root.get(), Fn);
+}
+
+void TextRope::copyTo(char *Out) const {
+  forEachPiece([&](StringRef Piece) {
+    memcpy(Out, Piece.data(), Piece.size());
+    Out += Piece.size();
+  });
+}
+
+std::string TextRope::str() const {
+  std::string Result;
+  Result.resize(size());
+  copyTo(&Result[0]);
+  return Result;
+}
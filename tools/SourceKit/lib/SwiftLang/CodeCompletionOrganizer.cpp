@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "CodeCompletionOrganizer.h"
+#include "SourceKit/Support/Concurrency.h"
 #include "SourceKit/Support/FuzzyStringMatcher.h"
 #include "swift/AST/ASTContext.h"
 #include "swift/AST/Module.h"
@@ -216,9 +217,10 @@ public:
   void addCompletionsWithFilter(ArrayRef<Completion *> completions,
                                 StringRef filterText, Options options,
                                 const FilterRules &rules,
-                                Completion *&exactMatch);
+                                Completion *&exactMatch,
+                                std::vector<Completion *> *matches);
 
-  void sort(Options options);
+  void sort(Options options, unsigned limit);
 
   void groupOverloads() {
     groupStemsRecursive(
@@ -291,18 +293,36 @@ void CodeCompletionOrganizer::preSortCompletions(
 
 void CodeCompletionOrganizer::addCompletionsWithFilter(
     ArrayRef<Completion *> completions, StringRef filterText,
-    const FilterRules &rules, Completion *&exactMatch) {
+    const FilterRules &rules, Completion *&exactMatch,
+    std::vector<Completion *> *matches) {
   impl.addCompletionsWithFilter(completions, filterText, options, rules,
-                                exactMatch);
+                                exactMatch, matches);
 }
 
-void CodeCompletionOrganizer::groupAndSort(const Options &options) {
+bool CodeCompletionOrganizer::usesFuzzyMatching(StringRef filterText,
+                                                const Options &options) {
+  return options.fuzzyMatching && filterText.size() >= options.minFuzzyLength;
+}
+
+bool CodeCompletionOrganizer::isFilterRefinement(StringRef oldFilterText,
+                                                 bool oldFuzzyMatching,
+                                                 StringRef newFilterText,
+                                                 const Options &options) {
+  // Both prefix and fuzzy matching ignore case, and a candidate that matches a
+  // pattern matches any prefix of the pattern too.
+  return !oldFilterText.empty() &&
+         newFilterText.startswith_lower(oldFilterText) &&
+         oldFuzzyMatching == usesFuzzyMatching(newFilterText, options);
+}
+
+void CodeCompletionOrganizer::groupAndSort(const Options &options,
+                                           unsigned limit) {
   if (options.groupStems)
     impl.groupStems();
   else if (options.groupOverloads)
     impl.groupOverloads();
 
-  impl.sort(options);
+  impl.sort(options, limit);
 }
 
 CodeCompletionViewRef CodeCompletionOrganizer::takeResultsView() {
@@ -506,9 +526,25 @@ bool FilterRules::hideCompletion(SwiftResult *completion, StringRef name, void *
   return hideAll;
 }
 
+/// Scores the names of \p results against \p pattern, spreading the work
+/// over several threads if there are many results.
+static void scoreResults(const FuzzyStringMatcher &pattern,
+                         MutableArrayRef<std::unique_ptr<Item>> results) {
+  const size_t minResultsPerThread = 2048;
+  WorkQueue::concurrentApplyRanges(results.size(), minResultsPerThread,
+                                   [&pattern, results](size_t begin,
+                                                       size_t end) {
+    for (size_t i = begin; i != end; ++i) {
+      Result *result = cast<Result>(results[i].get());
+      result->matchScore = pattern.scoreCandidate(result->value->getName());
+    }
+  });
+}
+
 void CodeCompletionOrganizer::Impl::addCompletionsWithFilter(
     ArrayRef<Completion *> completions, StringRef filterText, Options options,
-    const FilterRules &rules, Completion *&exactMatch) {
+    const FilterRules &rules, Completion *&exactMatch,
+    std::vector<Completion *> *matches) {
   assert(rootGroup);
 
   auto &contents = rootGroup->contents;
@@ -575,7 +611,27 @@ void CodeCompletionOrganizer::Impl::addCompletionsWithFilter(
 
   FuzzyStringMatcher pattern(filterText);
   pattern.normalize = true;
+  bool fuzzyMatching =
+      CodeCompletionOrganizer::usesFuzzyMatching(filterText, options);
+  size_t firstNewResult = contents.size();
   for (Completion *completion : completions) {
+    // Both prefix and fuzzy matches contain all of the characters of the
+    // filter text, so this quickly rules out most of the completions.
+    if (!pattern.mayMatchCandidate(completion->getNameCharacterMask()))
+      continue;
+
+    bool match = false;
+    if (fuzzyMatching) {
+      match = pattern.matchesCandidate(completion->getName());
+    } else {
+      match = completion->getName().startswith_lower(filterText);
+    }
+
+    // Record the matches before hiding any of them, so that they only depend
+    // on the filter text when they are filtered again.
+    if (match && matches)
+      matches->push_back(completion);
+
     if (rules.hideCompletion(completion))
       continue;
 
@@ -589,13 +645,6 @@ void CodeCompletionOrganizer::Impl::addCompletionsWithFilter(
         completion->getLiteralKind() != CodeCompletionLiteralKind::NilLiteral)
       continue;
 
-    bool match = false;
-    if (options.fuzzyMatching && filterText.size() >= options.minFuzzyLength) {
-      match = pattern.matchesCandidate(completion->getName());
-    } else {
-      match = completion->getName().startswith_lower(filterText);
-    }
-
     bool isExactMatch = match && completion->getName().equals_lower(filterText);
 
     if (isExactMatch) {
@@ -618,14 +667,16 @@ void CodeCompletionOrganizer::Impl::addCompletionsWithFilter(
     // Build wrapper and add to results.
     if (match) {
       auto wrapper = make_result(completion);
-      if (options.fuzzyMatching) {
-        wrapper->matchScore = pattern.scoreCandidate(completion->getName());
-      }
       wrapper->isExactMatch = isExactMatch;
 
       contents.push_back(std::move(wrapper));
     }
   }
+
+  if (options.fuzzyMatching) {
+    scoreResults(pattern, MutableArrayRef<std::unique_ptr<Item>>(contents)
+                              .slice(firstNewResult));
+  }
 }
 
 static double getSemanticContextScore(bool useImportDepth,
@@ -947,7 +998,7 @@ static void sortTopN(const Options &options, Group *group,
 }
 
 static void sortRecursive(const Options &options, Group *group,
-                          bool hasExpectedTypes) {
+                          bool hasExpectedTypes, unsigned limit = 0) {
   // Sort all of the subgroups first, and fill in the bucket for each result.
   auto &contents = group->contents;
   double best = -1.0;
@@ -975,7 +1026,8 @@ static void sortRecursive(const Options &options, Group *group,
     return;
   }
 
-  std::sort(contents.begin(), contents.end(), [=](const std::unique_ptr<Item> &a_, const std::unique_ptr<Item> &b_) {
+  auto compare = [=](const std::unique_ptr<Item> &a_,
+                     const std::unique_ptr<Item> &b_) {
     Item &a = *a_;
     Item &b = *b_;
 
@@ -1023,11 +1075,32 @@ static void sortRecursive(const Options &options, Group *group,
       return true;
 
     return compareResultName(a, b) < 0;
-  });
+  };
+
+  if (limit == 0 || limit >= contents.size()) {
+    std::sort(contents.begin(), contents.end(), compare);
+    return;
+  }
+
+  // Only the first results will be shown, so don't bother ordering the rest.
+  std::partial_sort(contents.begin(), contents.begin() + limit, contents.end(),
+                    compare);
+
+  // sortTopN() moves the first few results past the leading literals to the
+  // front, so they must be among the ordered ones too.
+  if (unsigned topN = options.showTopNonLiteralResults) {
+    auto bucket = getResultBucket(*contents[limit - topN], hasExpectedTypes);
+    if (bucket == ResultBucket::Literal ||
+        bucket == ResultBucket::LiteralTypeMatch)
+      std::sort(contents.begin() + limit, contents.end(), compare);
+  }
 }
 
-void CodeCompletionOrganizer::Impl::sort(Options options) {
-  sortRecursive(options, rootGroup.get(), completionHasExpectedTypes);
+void CodeCompletionOrganizer::Impl::sort(Options options, unsigned limit) {
+  // Leave room for the results that sortTopN() moves to the front.
+  if (limit != 0)
+    limit += options.showTopNonLiteralResults;
+  sortRecursive(options, rootGroup.get(), completionHasExpectedTypes, limit);
   if (options.showTopNonLiteralResults != 0)
     sortTopN(options, rootGroup.get(), completionHasExpectedTypes);
 }
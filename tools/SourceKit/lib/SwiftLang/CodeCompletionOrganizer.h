@@ -83,12 +83,31 @@ public:
   /// Add \p completions to the organizer, removing any results that don't match
   /// \p filterText and returning \p exactMatch if there is an exact match.
   ///
+  /// If \p matches is non-null, the completions that matched \p filterText are
+  /// added to it, including the ones hidden by \p rules. Since the completions
+  /// that match a longer filter text are a subset of them, they can be passed
+  /// as \p completions when the user types more of it (see
+  /// \c isFilterRefinement()).
+  ///
   /// Precondition: \p completions should be sorted with preSortCompletions().
   void addCompletionsWithFilter(ArrayRef<Completion *> completions,
                                 StringRef filterText, const FilterRules &rules,
-                                Completion *&exactMatch);
-
-  void groupAndSort(const Options &options);
+                                Completion *&exactMatch,
+                                std::vector<Completion *> *matches = nullptr);
+
+  /// Whether \p filterText is matched fuzzily rather than as a prefix.
+  static bool usesFuzzyMatching(StringRef filterText, const Options &options);
+
+  /// Whether the completions that match \p newFilterText are a subset of the
+  /// ones that matched \p oldFilterText, which was matched fuzzily if
+  /// \p oldFuzzyMatching is true.
+  static bool isFilterRefinement(StringRef oldFilterText, bool oldFuzzyMatching,
+                                 StringRef newFilterText,
+                                 const Options &options);
+
+  /// Groups and sorts the results. If \p limit is non-zero, only the first
+  /// \p limit results are guaranteed to be in order.
+  void groupAndSort(const Options &options, unsigned limit = 0);
 
   /// Finishes the results and returns them.
   /// For convenience, this returns a shared_ptr, but it is uniquely referenced.
@@ -33,6 +33,9 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Timer.h"
+
+#include <atomic>
 
 using namespace SourceKit;
 using namespace swift;
@@ -233,6 +236,7 @@ struct FileContent {
 };
 
 class ASTProducer : public ThreadSafeRefCountedBase<ASTProducer> {
+  SwiftASTManager::Implementation &Owner;
   SwiftInvocationRef InvokRef;
   SmallVector<BufferStamp, 8> Stamps;
   ThreadSafeRefCntPtr<ASTUnit> AST;
@@ -241,8 +245,22 @@ class ASTProducer : public ThreadSafeRefCountedBase<ASTProducer> {
   llvm::sys::Mutex Mtx;
 
 public:
-  explicit ASTProducer(SwiftInvocationRef InvokRef)
-    : InvokRef(std::move(InvokRef)) {}
+  /// The number of references to this producer held by the ASTCache.
+  std::atomic<unsigned> CacheEntries{0};
+
+  // These are guarded by the CacheMtx of the manager.
+  /// The time it took to build the current AST, in seconds.
+  double BuildTime = 0;
+  size_t ASTMemoryCost = 0;
+  double EvictionPriority = 0;
+
+  ASTProducer(SwiftASTManager::Implementation &Owner,
+              SwiftInvocationRef InvokRef)
+    : Owner(Owner), InvokRef(std::move(InvokRef)) {}
+
+  SwiftASTManager::Implementation &getOwner() const { return Owner; }
+
+  const ASTKey &getKey() const { return InvokRef->Impl.Key; }
 
   ASTUnitRef getExistingAST() {
     // FIXME: ThreadSafeRefCntPtr is racy.
@@ -250,6 +268,12 @@ public:
     return AST;
   }
 
+  /// Drops the AST, so that the next request builds it again.
+  void dropAST() {
+    llvm::sys::ScopedLock L(Mtx);
+    AST = nullptr;
+  }
+
   void getASTUnitAsync(SwiftASTManager::Implementation &MgrImpl,
                        ArrayRef<ImmutableTextSnapshotRef> Snapshots,
                 std::function<void(ASTUnitRef Unit, StringRef Error)> Receiver);
@@ -278,6 +302,24 @@ private:
 
 typedef IntrusiveRefCntPtr<ASTProducer> ASTProducerRef;
 
+/// Keeps track of whether the ASTCache still refers to a producer, so that the
+/// manager stops accounting for (and keeping alive) the AST of a producer that
+/// the cache evicted.
+struct ASTProducerCacheInfo {
+  static void *enterCache(const ASTProducerRef &Producer) {
+    Producer->Retain();
+    ++Producer->CacheEntries;
+    return Producer.get();
+  }
+  static void exitCache(void *Ptr);
+  static ASTProducerRef getFromCache(void *Ptr) {
+    return static_cast<ASTProducer*>(Ptr);
+  }
+  static size_t getCost(const ASTProducerRef &Producer) {
+    return Producer->getMemoryCost();
+  }
+};
+
 } // anonymous namespace.
 
 namespace swift {
@@ -311,13 +353,30 @@ struct SwiftASTManager::Implementation {
   SwiftEditorDocumentFileMap &EditorDocs;
   std::string RuntimeResourcePath;
   SourceManager SourceMgr;
-  Cache<ASTKey, ASTProducerRef> ASTCache{ "sourcekit.swift.ASTCache" };
   llvm::sys::Mutex CacheMtx;
 
+  // These are guarded by CacheMtx.
+  /// The producers that currently hold an AST.
+  std::vector<ASTProducerRef> ProducersWithAST;
+  /// The priority of the last AST that was dropped. Used ASTs get a priority
+  /// above it, so that ASTs which are not used age relative to the others.
+  double EvictionClock = 0;
+  size_t MemoryLimit = 1024 * 1024 * 1024;
+  SwiftASTManager::Statistics Stats;
+
+  // Declared after the state above, so that the producers it releases while it
+  // is destroyed can still update that state.
+  Cache<ASTKey, ASTProducerRef, CacheKeyInfo<ASTKey>, ASTProducerCacheInfo>
+    ASTCache{ "sourcekit.swift.ASTCache" };
+
   WorkQueue ASTBuildQueue{ WorkQueue::Dequeuing::Serial,
                            "sourcekit.swift.ASTBuilding" };
 
   ASTProducerRef getASTProducer(SwiftInvocationRef InvokRef);
+  void recordHit(ASTProducer &Producer);
+  void recordBuild(ASTProducerRef Producer);
+  void enforceMemoryLimit(ASTProducer *Keep);
+  void releasedFromCache(ASTProducer &Producer);
   FileContent getFileContent(StringRef FilePath, std::string &Error);
   BufferStamp getBufferStamp(StringRef FilePath);
   std::unique_ptr<llvm::MemoryBuffer> getMemoryBuffer(StringRef Filename,
@@ -477,6 +536,7 @@ void SwiftASTManager::processASTAsync(SwiftInvocationRef InvokRef,
 
   if (ASTUnitRef Unit = Producer->getExistingAST()) {
     if (ASTConsumer->canUseASTWithSnapshots(Unit->getSnapshots())) {
+      Impl.recordHit(*Producer);
       Unit->Impl.consumeAsync(std::move(ASTConsumer), Unit);
       return;
     }
@@ -498,16 +558,136 @@ void SwiftASTManager::processASTAsync(SwiftInvocationRef InvokRef,
 }
 
 void SwiftASTManager::removeCachedAST(SwiftInvocationRef Invok) {
+  llvm::sys::ScopedLock L(Impl.CacheMtx);
+  auto &Producers = Impl.ProducersWithAST;
+  auto I = std::find_if(Producers.begin(), Producers.end(),
+                        [&](const ASTProducerRef &Producer) {
+    return Producer->getKey().FSID == Invok->Impl.Key.FSID;
+  });
+  if (I != Producers.end()) {
+    Impl.Stats.MemoryUsage -= (*I)->ASTMemoryCost;
+    Producers.erase(I);
+  }
   Impl.ASTCache.remove(Invok->Impl.Key);
 }
 
+SwiftASTManager::Statistics SwiftASTManager::getStatistics() const {
+  llvm::sys::ScopedLock L(Impl.CacheMtx);
+  return Impl.Stats;
+}
+
+void SwiftASTManager::setMemoryLimit(size_t Bytes) {
+  llvm::sys::ScopedLock L(Impl.CacheMtx);
+  Impl.MemoryLimit = Bytes;
+  Impl.enforceMemoryLimit(nullptr);
+}
+
+/// Returns the priority of keeping the AST of \p Producer, which is higher
+/// the longer it took to build per byte it uses ("GreedyDual-Size").
+static double getEvictionPriority(const ASTProducer &Producer, double Clock) {
+  double MegaBytes = std::max<size_t>(Producer.ASTMemoryCost, 1) / 1048576.0;
+  return Clock + Producer.BuildTime / MegaBytes;
+}
+
+void SwiftASTManager::Implementation::recordHit(ASTProducer &Producer) {
+  llvm::sys::ScopedLock L(CacheMtx);
+  ++Stats.Hits;
+  Producer.EvictionPriority = getEvictionPriority(Producer, EvictionClock);
+}
+
+void SwiftASTManager::Implementation::recordBuild(ASTProducerRef Producer) {
+  llvm::sys::ScopedLock L(CacheMtx);
+  ++Stats.Misses;
+  Stats.BuildTime += Producer->BuildTime;
+
+  auto I = std::find(ProducersWithAST.begin(), ProducersWithAST.end(),
+                     Producer);
+  if (I != ProducersWithAST.end()) {
+    Stats.MemoryUsage -= Producer->ASTMemoryCost;
+    ProducersWithAST.erase(I);
+  }
+  Producer->ASTMemoryCost = 0;
+  if (!Producer->getExistingAST())
+    return;
+
+  ProducersWithAST.push_back(Producer);
+  Producer->ASTMemoryCost = Producer->getMemoryCost();
+  Producer->EvictionPriority = getEvictionPriority(*Producer, EvictionClock);
+  Stats.MemoryUsage += Producer->ASTMemoryCost;
+
+  // Re-register the object with the cache to update its memory cost.
+  ASTCache.set(Producer->getKey(), Producer);
+
+  enforceMemoryLimit(Producer.get());
+}
+
+void SwiftASTManager::Implementation::enforceMemoryLimit(ASTProducer *Keep) {
+  while (Stats.MemoryUsage > MemoryLimit) {
+    auto Victim = ProducersWithAST.end();
+    for (auto I = ProducersWithAST.begin(), E = ProducersWithAST.end();
+         I != E; ++I) {
+      if (I->get() == Keep)
+        continue;
+      if (Victim == E || (*I)->EvictionPriority < (*Victim)->EvictionPriority)
+        Victim = I;
+    }
+    if (Victim == ProducersWithAST.end())
+      break;
+
+    ASTProducerRef Producer = *Victim;
+    ProducersWithAST.erase(Victim);
+    LOG_INFO_FUNC(High, "dropping AST of size " << Producer->ASTMemoryCost
+                  << " to stay within " << MemoryLimit << " bytes");
+    EvictionClock = Producer->EvictionPriority;
+    Stats.MemoryUsage -= Producer->ASTMemoryCost;
+    ++Stats.Evictions;
+
+    // Consumers that already received the AST keep it alive until they are
+    // done with it.
+    Producer->dropAST();
+    Producer->ASTMemoryCost = 0;
+    ASTCache.set(Producer->getKey(), Producer);
+  }
+}
+
+void SwiftASTManager::Implementation::releasedFromCache(ASTProducer &Producer) {
+  llvm::sys::ScopedLock L(CacheMtx);
+  // The producer may have been registered again before we got the lock.
+  if (Producer.CacheEntries != 0)
+    return;
+
+  auto I = std::find_if(ProducersWithAST.begin(), ProducersWithAST.end(),
+                        [&](const ASTProducerRef &Other) {
+    return Other.get() == &Producer;
+  });
+  if (I == ProducersWithAST.end())
+    return;
+
+  // A later request builds a new producer for the same key, so don't keep the
+  // AST of this one alive and accounted for next to it.
+  LOG_INFO_FUNC(High, "dropping AST of size " << Producer.ASTMemoryCost
+                << " evicted from the cache");
+  Stats.MemoryUsage -= Producer.ASTMemoryCost;
+  ++Stats.Evictions;
+  Producer.dropAST();
+  Producer.ASTMemoryCost = 0;
+  ProducersWithAST.erase(I);
+}
+
+void ASTProducerCacheInfo::exitCache(void *Ptr) {
+  auto *Producer = static_cast<ASTProducer*>(Ptr);
+  if (--Producer->CacheEntries == 0)
+    Producer->getOwner().releasedFromCache(*Producer);
+  Producer->Release();
+}
+
 ASTProducerRef
 SwiftASTManager::Implementation::getASTProducer(SwiftInvocationRef InvokRef) {
   llvm::sys::ScopedLock L(CacheMtx);
   llvm::Optional<ASTProducerRef> OptProducer = ASTCache.get(InvokRef->Impl.Key);
   if (OptProducer.hasValue())
     return OptProducer.getValue();
-  ASTProducerRef Producer = new ASTProducer(InvokRef);
+  ASTProducerRef Producer = new ASTProducer(*this, InvokRef);
   ASTCache.set(InvokRef->Impl.Key, Producer);
   return Producer;
 }
@@ -592,19 +772,36 @@ ASTUnitRef ASTProducer::getASTUnitImpl(SwiftASTManager::Implementation &MgrImpl,
       Log->getOS() << Opts.Invok.getModuleName() << '/' << Opts.PrimaryFile;
     }
 
+    llvm::TimeRecord StartTime = llvm::TimeRecord::getCurrentTime();
     auto NewAST = createASTUnit(MgrImpl, Snapshots, Error);
+    double ElapsedTime = llvm::TimeRecord::getCurrentTime().getWallTime() -
+                         StartTime.getWallTime();
+    {
+      llvm::sys::ScopedLock L(MgrImpl.CacheMtx);
+      BuildTime = ElapsedTime;
+    }
     {
       // FIXME: ThreadSafeRefCntPtr is racy.
       llvm::sys::ScopedLock L(Mtx);
       AST = NewAST;
     }
 
-    {
-      llvm::sys::ScopedLock L(MgrImpl.CacheMtx);
-      // Re-register the object with the cache to update its memory cost.
-      ASTProducerRef ThisProducer = this;
-      MgrImpl.ASTCache.set(InvokRef->Impl.Key, ThisProducer);
+    MgrImpl.recordBuild(this);
+
+    LOG_FUNC_SECTION(InfoHighPrio) {
+      auto Stats = SwiftASTManager::Statistics();
+      {
+        llvm::sys::ScopedLock L(MgrImpl.CacheMtx);
+        Stats = MgrImpl.Stats;
+      }
+      Log->getOS() << "AST build took " << unsigned(ElapsedTime * 1000)
+                   << "ms: " << Opts.PrimaryFile << "; cache: "
+                   << Stats.Hits << " hits, " << Stats.Misses << " misses, "
+                   << Stats.Evictions << " evictions, "
+                   << Stats.MemoryUsage << " bytes";
     }
+  } else {
+    MgrImpl.recordHit(*this);
   }
 
   return AST;
@@ -656,12 +853,24 @@ bool ASTProducer::shouldRebuild(SwiftASTManager::Implementation &MgrImpl,
       InputStamps.push_back(MgrImpl.getBufferStamp(File));
   }
   assert(InputStamps.size() == Invok.Opts.Invok.getInputFilenames().size());
-  if (Stamps != InputStamps)
+  if (Stamps != InputStamps) {
+    LOG_FUNC_SECTION(InfoHighPrio) {
+      for (unsigned i = 0, e = InputStamps.size(); i != e; ++i) {
+        if (i >= Stamps.size() || Stamps[i] != InputStamps[i]) {
+          Log->getOS() << "input changed: "
+                       << Invok.Opts.Invok.getInputFilenames()[i];
+          break;
+        }
+      }
+    }
     return true;
+  }
 
   for (auto &Dependency : DependencyStamps) {
-    if (Dependency.second != MgrImpl.getBufferStamp(Dependency.first))
+    if (Dependency.second != MgrImpl.getBufferStamp(Dependency.first)) {
+      LOG_INFO_FUNC(High, "dependency changed: " << Dependency.first);
       return true;
+    }
   }
 
   return false;
@@ -14,6 +14,7 @@
 #define LLVM_SOURCEKIT_LIB_SWIFTLANG_SWIFTASTMANAGER_H
 
 #include "SwiftInvocation.h"
+#include "SourceKit/Core/LangSupport.h"
 #include "SourceKit/Core/LLVM.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
@@ -119,6 +120,17 @@ public:
 
   void removeCachedAST(SwiftInvocationRef Invok);
 
+  /// Statistics about the ASTs that were requested, for diagnosing slow
+  /// requests.
+  typedef ASTCacheStatistics Statistics;
+
+  Statistics getStatistics() const;
+
+  /// Sets the memory that the cached ASTs may use, in bytes. Once it is
+  /// exceeded, the ASTs that are the cheapest to rebuild for their size and
+  /// were used least recently are dropped.
+  void setMemoryLimit(size_t Bytes);
+
   struct Implementation;
 
 private:
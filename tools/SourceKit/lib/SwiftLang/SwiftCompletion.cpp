@@ -21,6 +21,7 @@
 #include "swift/Frontend/PrintingDiagnosticConsumer.h"
 #include "swift/IDE/CodeCompletionCache.h"
 
+#include "clang/Basic/CharInfo.h"
 #include "llvm/Support/MemoryBuffer.h"
 
 using namespace SourceKit;
@@ -108,7 +109,8 @@ static bool swiftCodeCompleteImpl(SwiftLangSupport &Lang,
                                   unsigned Offset,
                                   SwiftCodeCompletionConsumer &SwiftConsumer,
                                   ArrayRef<const char *> Args,
-                                  std::string &Error) {
+                                  std::string &Error,
+                                  StringRef ResultNamePrefix = StringRef()) {
 
   trace::TracedOperation TracedOp;
   if (trace::enabled()) {
@@ -167,6 +169,7 @@ static bool swiftCodeCompleteImpl(SwiftLangSupport &Lang,
 
   auto swiftCache = Lang.getCodeCompletionCache(); // Pin the cache.
   ide::CodeCompletionContext CompletionContext(swiftCache->getCache());
+  CompletionContext.ResultNamePrefix = ResultNamePrefix;
 
   // Create a factory for code completion callbacks that will feed the
   // Consumer.
@@ -713,6 +716,30 @@ ArrayRef<Completion *> CodeCompletion::SessionCache::getSortedCompletions() {
   llvm::sys::ScopedLock L(mtx);
   return sortedCompletions;
 }
+std::vector<Completion *> CodeCompletion::SessionCache::getCompletionsToFilter(
+    StringRef filterText, const Options &options) {
+  llvm::sys::ScopedLock L(mtx);
+  if (CodeCompletionOrganizer::isFilterRefinement(
+          lastFilterText, lastFilterWasFuzzy, filterText, options))
+    return lastFilterMatches;
+  return sortedCompletions;
+}
+void CodeCompletion::SessionCache::setFilterMatches(
+    StringRef filterText, const Options &options,
+    std::vector<Completion *> &&matches) {
+  llvm::sys::ScopedLock L(mtx);
+  lastFilterText = filterText;
+  lastFilterWasFuzzy =
+      CodeCompletionOrganizer::usesFuzzyMatching(filterText, options);
+  lastFilterMatches = std::move(matches);
+}
+bool CodeCompletion::SessionCache::hasCompletionsFor(StringRef filterText,
+                                                     const Options &options) {
+  llvm::sys::ScopedLock L(mtx);
+  return resultNamePrefix.empty() ||
+         (filterText.startswith_lower(resultNamePrefix) &&
+          !CodeCompletionOrganizer::usesFuzzyMatching(filterText, options));
+}
 llvm::MemoryBuffer *CodeCompletion::SessionCache::getBuffer() {
   llvm::sys::ScopedLock L(mtx);
   return buffer.get();
@@ -1025,8 +1052,18 @@ static void transformAndForwardResults(
       session->getCompletionKind() == CompletionKind::PostfixExpr;
 
   if (!hasEarlyInnerResults) {
-    organizer.addCompletionsWithFilter(session->getSortedCompletions(),
-                                       filterText, rules, exactMatch);
+    if (filterText.empty()) {
+      organizer.addCompletionsWithFilter(session->getSortedCompletions(),
+                                         filterText, rules, exactMatch);
+    } else {
+      // Typing more of the filter text only needs to look at what matched
+      // the previous one.
+      std::vector<Completion *> matches;
+      organizer.addCompletionsWithFilter(
+          session->getCompletionsToFilter(filterText, options), filterText,
+          rules, exactMatch, &matches);
+      session->setFilterMatches(filterText, options, std::move(matches));
+    }
   }
 
   if (hasEarlyInnerResults &&
@@ -1052,7 +1089,9 @@ static void transformAndForwardResults(
                                        CodeCompletion::FilterRules(), exactMatch);
   }
 
-  organizer.groupAndSort(options);
+  // Only the requested page of results needs to be ordered.
+  unsigned sortLimit = maxResults ? resultOffset + maxResults : 0;
+  organizer.groupAndSort(options, sortLimit);
 
   if ((options.addInnerResults || options.addInnerOperators) &&
       exactMatch && exactMatch->getKind() == Completion::Declaration) {
@@ -1111,7 +1150,7 @@ static void transformAndForwardResults(
     CodeCompletion::Options noGroupOpts = options;
     noGroupOpts.groupStems = false;
     noGroupOpts.groupOverloads = false;
-    organizer.groupAndSort(noGroupOpts);
+    organizer.groupAndSort(noGroupOpts, sortLimit);
   }
 
   // Build the final results view.
@@ -1125,32 +1164,30 @@ static void transformAndForwardResults(
   consumer.setNextRequestStart(limitedResults.getNextOffset());
 }
 
-void SwiftLangSupport::codeCompleteOpen(
-    StringRef name, llvm::MemoryBuffer *inputBuf, unsigned offset,
-    OptionsDictionary *options, ArrayRef<FilterRule> rawFilterRules,
-    GroupedCodeCompletionConsumer &consumer, ArrayRef<const char *> args) {
-  StringRef filterText;
-  unsigned resultOffset = 0;
-  unsigned maxResults = 0;
-  CodeCompletion::Options CCOpts;
-  if (options)
-    translateCodeCompletionOptions(*options, CCOpts, filterText, resultOffset,
-                                   maxResults);
-
-  CodeCompletion::FilterRules filterRules;
-  translateFilterRules(rawFilterRules, filterRules);
+/// Returns the leading identifier characters of \p filterText. Only the
+/// completions whose name starts with them can match \p filterText without
+/// fuzzy matching.
+static StringRef getResultNamePrefix(StringRef filterText,
+                                     const CodeCompletion::Options &options) {
+  if (options.fuzzyMatching)
+    return StringRef();
+  size_t length = 0;
+  while (length < filterText.size() &&
+         (clang::isIdentifierBody(filterText[length]) ||
+          static_cast<unsigned char>(filterText[length]) >= 0x80))
+    ++length;
+  return filterText.slice(0, length);
+}
 
+CodeCompletion::SessionCacheRef SwiftLangSupport::createCompletionSession(
+    llvm::MemoryBuffer *inputBuf, unsigned offset, ArrayRef<const char *> args,
+    CodeCompletion::FilterRules filterRules,
+    const CodeCompletion::Options &CCOpts, StringRef resultNamePrefix,
+    const NameToPopularityMap *nameToPopularity, std::string &error) {
   // Set up the code completion consumer to pass results to organizer.
   CodeCompletion::CompletionSink sink;
   std::vector<Completion *> completions;
 
-  NameToPopularityMap *nameToPopularity = nullptr;
-  // This reference must outlive the uses of nameToPopularity.
-  auto popularAPIRef = PopularAPI;
-  if (popularAPIRef) {
-    nameToPopularity = &popularAPIRef->nameToFactor;
-  }
-
   CompletionKind completionKind = CompletionKind::None;
   bool hasExpectedTypes = false;
 
@@ -1163,18 +1200,10 @@ void SwiftLangSupport::codeCompleteOpen(
             extendCompletions(results, sink, info, nameToPopularity, CCOpts);
       });
 
-  // Add any codecomplete.open specific flags.
-  std::vector<const char *> extendedArgs(args.begin(), args.end());
-  if (CCOpts.addInitsToTopLevel)
-    extendedArgs.push_back("-code-complete-inits-in-postfix-expr");
-
   // Invoke completion.
-  std::string error;
-  if (!swiftCodeCompleteImpl(*this, inputBuf, offset, swiftConsumer,
-                             extendedArgs, error)) {
-    consumer.failed(error);
-    return;
-  }
+  if (!swiftCodeCompleteImpl(*this, inputBuf, offset, swiftConsumer, args,
+                             error, resultNamePrefix))
+    return nullptr;
 
   // Add any relevant custom completions.
   if (auto custom = CustomCompletions)
@@ -1189,11 +1218,50 @@ void SwiftLangSupport::codeCompleteOpen(
   using CodeCompletion::SessionCacheRef;
   auto bufferCopy = llvm::MemoryBuffer::getMemBufferCopy(
       inputBuf->getBuffer(), inputBuf->getBufferIdentifier());
-  std::vector<std::string> argsCopy(extendedArgs.begin(), extendedArgs.end());
+  std::vector<std::string> argsCopy(args.begin(), args.end());
   SessionCacheRef session{new SessionCache(
       std::move(sink), std::move(bufferCopy), std::move(argsCopy),
-      completionKind, hasExpectedTypes, std::move(filterRules))};
+      completionKind, hasExpectedTypes, std::move(filterRules),
+      resultNamePrefix)};
   session->setSortedCompletions(std::move(completions));
+  return session;
+}
+
+void SwiftLangSupport::codeCompleteOpen(
+    StringRef name, llvm::MemoryBuffer *inputBuf, unsigned offset,
+    OptionsDictionary *options, ArrayRef<FilterRule> rawFilterRules,
+    GroupedCodeCompletionConsumer &consumer, ArrayRef<const char *> args) {
+  StringRef filterText;
+  unsigned resultOffset = 0;
+  unsigned maxResults = 0;
+  CodeCompletion::Options CCOpts;
+  if (options)
+    translateCodeCompletionOptions(*options, CCOpts, filterText, resultOffset,
+                                   maxResults);
+
+  CodeCompletion::FilterRules filterRules;
+  translateFilterRules(rawFilterRules, filterRules);
+
+  NameToPopularityMap *nameToPopularity = nullptr;
+  // This reference must outlive the uses of nameToPopularity.
+  auto popularAPIRef = PopularAPI;
+  if (popularAPIRef) {
+    nameToPopularity = &popularAPIRef->nameToFactor;
+  }
+
+  // Add any codecomplete.open specific flags.
+  std::vector<const char *> extendedArgs(args.begin(), args.end());
+  if (CCOpts.addInitsToTopLevel)
+    extendedArgs.push_back("-code-complete-inits-in-postfix-expr");
+
+  std::string error;
+  auto session = createCompletionSession(
+      inputBuf, offset, extendedArgs, std::move(filterRules), CCOpts,
+      getResultNamePrefix(filterText, CCOpts), nameToPopularity, error);
+  if (!session) {
+    consumer.failed(error);
+    return;
+  }
 
   if (!CCSessions.set(name, offset, session)) {
     std::string err;
@@ -1248,6 +1316,25 @@ void SwiftLangSupport::codeCompleteUpdate(
     nameToPopularity = &popularAPIRef->nameToFactor;
   }
 
+  // If the session was opened with only the cached module results matching
+  // its filter text, start over when the new filter text may match others.
+  if (!session->hasCompletionsFor(filterText, CCOpts)) {
+    std::vector<const char *> args;
+    for (auto &arg : session->getCompilerArgs())
+      args.push_back(arg.c_str());
+    std::string error;
+    auto newSession = createCompletionSession(
+        session->getBuffer(), offset, args, session->getFilterRules(), CCOpts,
+        getResultNamePrefix(filterText, CCOpts), nameToPopularity, error);
+    if (!newSession) {
+      consumer.failed(error);
+      return;
+    }
+    CCSessions.remove(name, offset);
+    CCSessions.set(name, offset, newSession);
+    session = newSession;
+  }
+
   transformAndForwardResults(consumer, *this, session, nameToPopularity, CCOpts,
                              offset, filterText, resultOffset, maxResults);
 }
@@ -365,6 +365,33 @@ struct EditorConsumerSyntaxMapEntry {
 
 typedef std::pair<unsigned, unsigned> SwiftEditorCharRange;
 
+/// A sequence of edits of a text, merged into a single replaced range of the
+/// original text.
+struct SwiftEditorTextEdit {
+  unsigned Offset = 0;
+  unsigned OldLength = 0;
+  unsigned NewLength = 0;
+
+  /// Merges an edit of the text resulting from this one.
+  void merge(unsigned NextOffset, unsigned NextOldLength,
+             unsigned NextNewLength) {
+    if (OldLength == 0 && NewLength == 0) {
+      Offset = NextOffset;
+      OldLength = NextOldLength;
+      NewLength = NextNewLength;
+      return;
+    }
+
+    unsigned Start = std::min(Offset, NextOffset);
+    unsigned End = std::max(Offset + NewLength, NextOffset + NextOldLength);
+    unsigned OldEnd = End - NewLength + OldLength;
+    unsigned NewEnd = End - NextOldLength + NextNewLength;
+    Offset = Start;
+    OldLength = OldEnd - Start;
+    NewLength = NewEnd - Start;
+  }
+};
+
 struct SwiftSemanticToken {
   unsigned ByteOffset;
   unsigned Length : 24;
@@ -452,13 +479,15 @@ class SwiftDocumentSyntaxInfo {
   unsigned BufferID;
   std::vector<std::string> Args;
   std::string PrimaryFile;
+  ImmutableTextSnapshotRef Snapshot;
+  std::vector<Token> Tokens;
 
 public:
   SwiftDocumentSyntaxInfo(const CompilerInvocation &CompInv,
                           ImmutableTextSnapshotRef Snapshot,
                           std::vector<std::string> &Args,
                           StringRef FilePath)
-        : Args(Args), PrimaryFile(FilePath) {
+        : Args(Args), PrimaryFile(FilePath), Snapshot(Snapshot) {
 
     std::unique_ptr<llvm::MemoryBuffer> BufCopy =
       llvm::MemoryBuffer::getMemBufferCopy(
@@ -501,6 +530,58 @@ public:
     }
   }
 
+  /// Lexes the buffer for the syntax model.
+  ///
+  /// If the snapshot follows the one of \p Prev, only the lines around the
+  /// edits made between the two are lexed again.
+  void tokenize(const SwiftDocumentSyntaxInfo *Prev) {
+    Optional<SwiftEditorTextEdit> Edit;
+    if (Prev && Prev->Args == Args)
+      Edit = getEditSince(*Prev);
+    if (Edit) {
+      Tokens = swift::retokenize(getLangOptions(), SM, BufferID, Prev->Tokens,
+                                 Prev->getText(), Edit->Offset,
+                                 Edit->OldLength, Edit->NewLength);
+    } else {
+      Tokens = swift::tokenize(getLangOptions(), SM, BufferID,
+                               /*Offset=*/0, /*EndOffset=*/0,
+                               /*KeepComments=*/true,
+                               /*TokenizeInterpolatedString=*/true);
+    }
+  }
+
+  ArrayRef<Token> getTokens() const {
+    return Tokens;
+  }
+
+  /// Returns the edits that turned the text of \p Prev into this one, or
+  /// None if this snapshot does not follow the one of \p Prev.
+  Optional<SwiftEditorTextEdit>
+  getEditSince(const SwiftDocumentSyntaxInfo &Prev) const {
+    if (!Prev.Snapshot->isFromSameBuffer(Snapshot) ||
+        !Prev.Snapshot->precedesOrSame(Snapshot))
+      return None;
+
+    SwiftEditorTextEdit Edit;
+    Prev.Snapshot->foreachReplaceUntil(Snapshot,
+      [&](ReplaceImmutableTextUpdateRef Upd) -> bool {
+        Edit.merge(Upd->getByteOffset(), Upd->getLength(),
+                   Upd->getText().size());
+        return true;
+      });
+
+    // The buffers were copied from the snapshots, so this holds unless the
+    // update chain is broken; don't trust the edit then.
+    if (Prev.getText().size() - Edit.OldLength + Edit.NewLength !=
+        getText().size())
+      return None;
+    return Edit;
+  }
+
+  StringRef getText() const {
+    return SM.getLLVMSourceMgr().getMemoryBuffer(BufferID)->getBuffer();
+  }
+
   SourceFile &getSourceFile() {
     return Parser->getSourceFile();
   }
@@ -718,9 +799,9 @@ SwiftDocumentSemanticInfo::getSemanticDiagnostics(
     });
 
   if (!SemaDiags.empty()) {
-    auto ImmBuf = NewSnapshot->getBuffer();
     for (auto &Diag : SemaDiags) {
-      std::tie(Diag.Line, Diag.Column) = ImmBuf->getLineAndColumn(Diag.Offset);
+      std::tie(Diag.Line, Diag.Column) =
+          NewSnapshot->getLineAndColumn(Diag.Offset);
     }
 
     // If there is a parser diagnostic in a line, ignore diagnostics in the same
@@ -1721,10 +1802,12 @@ void SwiftEditorDocument::parse(ImmutableTextSnapshotRef Snapshot,
   }
 
   // Access to Impl.SyntaxInfo is guarded by Impl.AccessMtx
+  auto PrevSyntaxInfo = std::move(Impl.SyntaxInfo);
   Impl.SyntaxInfo.reset(
     new SwiftDocumentSyntaxInfo(CompInv, Snapshot, Args, Impl.FilePath));
 
   Impl.SyntaxInfo->parse();
+  Impl.SyntaxInfo->tokenize(PrevSyntaxInfo.get());
 }
 
 void SwiftEditorDocument::readSyntaxInfo(EditorConsumer &Consumer) {
@@ -1739,7 +1822,8 @@ void SwiftEditorDocument::readSyntaxInfo(EditorConsumer &Consumer) {
 
   Impl.ParserDiagnostics = Impl.SyntaxInfo->getDiagnostics();
 
-  ide::SyntaxModelContext ModelContext(Impl.SyntaxInfo->getSourceFile());
+  ide::SyntaxModelContext ModelContext(Impl.SyntaxInfo->getSourceFile(),
+                                       Impl.SyntaxInfo->getTokens());
 
   SwiftEditorSyntaxWalker SyntaxWalker(Impl.SyntaxMap,
                                        Impl.EditedLineRange,
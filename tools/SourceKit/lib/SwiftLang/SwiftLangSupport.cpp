@@ -281,6 +281,14 @@ SwiftLangSupport::SwiftLangSupport(SourceKit::Context &SKCtx)
 SwiftLangSupport::~SwiftLangSupport() {
 }
 
+ASTCacheStatistics SwiftLangSupport::getASTCacheStatistics() {
+  return ASTMgr->getStatistics();
+}
+
+void SwiftLangSupport::setASTCacheMemoryLimit(size_t Bytes) {
+  ASTMgr->setMemoryLimit(Bytes);
+}
+
 UIdent SwiftLangSupport::getUIDForDecl(const Decl *D, bool IsRef) {
   return UIdentVisitor(IsRef).visit(const_cast<Decl*>(D));
 }
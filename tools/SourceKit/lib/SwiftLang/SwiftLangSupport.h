@@ -121,6 +121,8 @@ public:
 
 namespace CodeCompletion {
 
+struct Options;
+
 /// Provides a thread-safe cache for code completion results that remain valid
 /// for the duration of a 'session' - for example, from the point that a user
 /// invokes code completion until they accept a completion, or otherwise close
@@ -136,19 +138,39 @@ class SessionCache : public ThreadSafeRefCountedBase<SessionCache> {
   CompletionKind completionKind;
   bool completionHasExpectedTypes;
   FilterRules filterRules;
+  /// The filter text of the last request, and the completions it matched.
+  std::string lastFilterText;
+  bool lastFilterWasFuzzy = false;
+  std::vector<Completion *> lastFilterMatches;
+  /// If not empty, only the cached module results whose name starts with this
+  /// prefix were added to the session.
+  std::string resultNamePrefix;
   llvm::sys::Mutex mtx;
 
 public:
   SessionCache(CompletionSink &&sink,
                std::unique_ptr<llvm::MemoryBuffer> &&buffer,
                std::vector<std::string> &&args, CompletionKind completionKind,
-               bool hasExpectedTypes, FilterRules filterRules)
+               bool hasExpectedTypes, FilterRules filterRules,
+               StringRef resultNamePrefix)
       : buffer(std::move(buffer)), args(std::move(args)), sink(std::move(sink)),
         completionKind(completionKind),
         completionHasExpectedTypes(hasExpectedTypes),
-        filterRules(std::move(filterRules)) {}
+        filterRules(std::move(filterRules)),
+        resultNamePrefix(resultNamePrefix) {}
   void setSortedCompletions(std::vector<Completion *> &&completions);
   ArrayRef<Completion *> getSortedCompletions();
+  /// Returns the completions to filter with \p filterText: the ones that
+  /// matched the last filter text if \p filterText refines it, or else all of
+  /// the sorted completions.
+  std::vector<Completion *> getCompletionsToFilter(StringRef filterText,
+                                                   const Options &options);
+  void setFilterMatches(StringRef filterText, const Options &options,
+                        std::vector<Completion *> &&matches);
+  /// Whether the session has every completion that may match \p filterText,
+  /// which it doesn't if it only has the cached module results matching a
+  /// prefix that \p filterText doesn't start with.
+  bool hasCompletionsFor(StringRef filterText, const Options &options);
   llvm::MemoryBuffer *getBuffer();
   ArrayRef<std::string> getCompilerArgs();
   const FilterRules &getFilterRules();
@@ -216,6 +238,16 @@ class SwiftLangSupport : public LangSupport {
   CodeCompletion::SessionCacheMap CCSessions;
   ThreadSafeRefCntPtr<SwiftCustomCompletions> CustomCompletions;
 
+  /// Runs code completion for a new session. If \p resultNamePrefix is not
+  /// empty, the cached module results whose name doesn't start with it may be
+  /// left out. Returns null and sets \p error on failure.
+  CodeCompletion::SessionCacheRef createCompletionSession(
+      llvm::MemoryBuffer *inputBuf, unsigned offset,
+      ArrayRef<const char *> args, CodeCompletion::FilterRules filterRules,
+      const CodeCompletion::Options &options, StringRef resultNamePrefix,
+      const llvm::StringMap<CodeCompletion::PopularityFactor> *nameToPopularity,
+      std::string &error);
+
 public:
   explicit SwiftLangSupport(SourceKit::Context &SKCtx);
   ~SwiftLangSupport();
@@ -398,6 +430,10 @@ public:
 
   void findModuleGroups(StringRef ModuleName, ArrayRef<const char *> Args,
                std::function<void(ArrayRef<StringRef>, StringRef Error)> Receiver) override;
+
+  ASTCacheStatistics getASTCacheStatistics() override;
+
+  void setASTCacheMemoryLimit(size_t Bytes) override;
 };
 
 namespace trace {
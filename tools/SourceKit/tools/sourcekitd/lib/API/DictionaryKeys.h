@@ -120,6 +120,12 @@ extern SourceKit::UIdent KeyTypeInterface;
 extern SourceKit::UIdent KeyTypeUsr;
 extern SourceKit::UIdent KeyContainerTypeUsr;
 extern SourceKit::UIdent KeyModuleGroups;
+extern SourceKit::UIdent KeyHits;
+extern SourceKit::UIdent KeyMisses;
+extern SourceKit::UIdent KeyEvictions;
+extern SourceKit::UIdent KeyBuildTime;
+extern SourceKit::UIdent KeyMemoryUsage;
+extern SourceKit::UIdent KeyMemoryLimit;
 
 /// \brief Used for determining the printing order of dictionary keys.
 bool compareDictKeys(SourceKit::UIdent LHS, SourceKit::UIdent RHS);
@@ -104,6 +104,10 @@ static LazySKDUID RequestBuildSettingsRegister(
     "source.request.buildsettings.register");
 static LazySKDUID RequestModuleGroups(
     "source.request.module.groups");
+static LazySKDUID RequestASTCacheStatistics(
+    "source.request.astcache.statistics");
+static LazySKDUID RequestASTCacheSetMemoryLimit(
+    "source.request.astcache.setmemorylimit");
 
 static LazySKDUID KindExpr("source.lang.swift.expr");
 static LazySKDUID KindStmt("source.lang.swift.stmt");
@@ -365,6 +369,31 @@ void handleRequestImpl(sourcekitd_object_t ReqObj, ResponseReceiver Rec) {
     return Rec(mangleSimpleClassNames(ModuleClassPairs));
   }
 
+  if (ReqUID == RequestASTCacheStatistics) {
+    LangSupport &Lang = getGlobalContext().getSwiftLangSupport();
+    ASTCacheStatistics Stats = Lang.getASTCacheStatistics();
+    ResponseBuilder RB;
+    auto Dict = RB.getDictionary();
+    Dict.set(KeyHits, int64_t(Stats.Hits));
+    Dict.set(KeyMisses, int64_t(Stats.Misses));
+    Dict.set(KeyEvictions, int64_t(Stats.Evictions));
+    // In milliseconds.
+    Dict.set(KeyBuildTime, int64_t(Stats.BuildTime * 1000));
+    Dict.set(KeyMemoryUsage, int64_t(Stats.MemoryUsage));
+    return Rec(RB.createResponse());
+  }
+
+  if (ReqUID == RequestASTCacheSetMemoryLimit) {
+    int64_t Limit;
+    if (Req.getInt64(KeyMemoryLimit, Limit, /*isOptional=*/false))
+      return Rec(createErrorRequestInvalid("missing 'key.memorylimit'"));
+    if (Limit < 0)
+      return Rec(createErrorRequestInvalid("invalid 'key.memorylimit'"));
+    LangSupport &Lang = getGlobalContext().getSwiftLangSupport();
+    Lang.setASTCacheMemoryLimit(Limit);
+    return Rec(ResponseBuilder().createResponse());
+  }
+
   // Just accept 'source.request.buildsettings.register' for now, don't do
   // anything else.
   // FIXME: Heavy WIP here.
@@ -134,6 +134,12 @@ UIdent sourcekitd::KeyTypeInterface("key.typeinterface");
 UIdent sourcekitd::KeyTypeUsr("key.typeusr");
 UIdent sourcekitd::KeyContainerTypeUsr("key.containertypeusr");
 UIdent sourcekitd::KeyModuleGroups("key.modulegroups");
+UIdent sourcekitd::KeyHits("key.hits");
+UIdent sourcekitd::KeyMisses("key.misses");
+UIdent sourcekitd::KeyEvictions("key.evictions");
+UIdent sourcekitd::KeyBuildTime("key.buildtime");
+UIdent sourcekitd::KeyMemoryUsage("key.memoryusage");
+UIdent sourcekitd::KeyMemoryLimit("key.memorylimit");
 
 /// \brief Order for the keys to use when emitting the debug description of
 /// dictionaries.
@@ -222,7 +228,14 @@ static UIdent *OrderedKeys[] = {
   &KeyIntroduced,
   &KeyDeprecated,
   &KeyObsoleted,
-  &KeyRemoveCache
+  &KeyRemoveCache,
+
+  &KeyHits,
+  &KeyMisses,
+  &KeyEvictions,
+  &KeyBuildTime,
+  &KeyMemoryUsage,
+  &KeyMemoryLimit
 };
 
 static unsigned findPrintOrderForDictKey(UIdent Key) {
@@ -15,15 +15,29 @@
 //===----------------------------------------------------------------------===//
 
 #include "swift/Basic/DemangleWrappers.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 static llvm::cl::opt<bool>
 ExpandMode("expand",
@@ -49,11 +63,30 @@ static llvm::cl::opt<bool>
 Simplified("simplified",
            llvm::cl::desc("Don't display module names or implicit self types"));
 
+static llvm::cl::opt<bool>
+StreamMode("stream",
+           llvm::cl::desc("Stream mode (demangle the standard input in chunks on several threads)"));
+
+static llvm::cl::opt<unsigned>
+NumThreads("j",
+           llvm::cl::desc("Number of threads to demangle on in stream mode (default: one per hardware thread)"),
+           llvm::cl::init(0));
+
+static llvm::cl::opt<unsigned>
+StreamChunkSize("stream-chunk-size",
+                llvm::cl::desc("Size of the chunks read in stream mode"),
+                llvm::cl::init(1 << 20), llvm::cl::Hidden);
+
+static llvm::cl::opt<bool>
+PrintThroughput("print-throughput",
+                llvm::cl::desc("Print the throughput of demangling the standard input to stderr"));
+
 static llvm::cl::list<std::string>
 InputNames(llvm::cl::Positional, llvm::cl::desc("[mangled name...]"),
                llvm::cl::ZeroOrMore);
 
 static void demangle(llvm::raw_ostream &os, llvm::StringRef name,
+                     swift::Demangle::NodeArena &arena,
                      const swift::Demangle::DemangleOptions &options) {
   bool hadLeadingUnderscore = false;
   if (name.startswith("__")) {
@@ -61,7 +94,7 @@ static void demangle(llvm::raw_ostream &os, llvm::StringRef name,
     name = name.substr(1);
   }
   swift::Demangle::NodePointer pointer =
-      swift::demangle_wrappers::demangleSymbolAsNode(name);
+      swift::demangle_wrappers::demangleSymbolAsNode(name, arena);
   if (ExpandMode || TreeOnly) {
     llvm::outs() << "Demangling for " << name << '\n';
     swift::demangle_wrappers::NodeDumper(pointer).print(llvm::outs());
@@ -86,6 +119,15 @@ static void demangle(llvm::raw_ostream &os, llvm::StringRef name,
   }
 }
 
+/// Demangles \p name into \p arena, and then frees the nodes for the next
+/// name.
+static void demangleAndReset(llvm::raw_ostream &os, llvm::StringRef name,
+                             swift::Demangle::NodeArena &arena,
+                             const swift::Demangle::DemangleOptions &options) {
+  demangle(os, name, arena, options);
+  arena.reset();
+}
+
 static llvm::StringRef substrBefore(llvm::StringRef whole,
                                     llvm::StringRef part) {
   return whole.slice(0, part.data() - whole.data());
@@ -96,6 +138,168 @@ static llvm::StringRef substrAfter(llvm::StringRef whole,
   return whole.substr((part.data() - whole.data()) + part.size());
 }
 
+/// Returns true if \p c can be part of a mangled name found in the input.
+static bool isSymbolChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '$';
+}
+
+/// Finds the first match of _T[_a-zA-Z0-9$]+ in \p text, or returns an empty
+/// string if there is none.
+///
+/// This matches the same names as the regular expression of the default mode,
+/// but looks for the underscores with memchr, which is vectorized.
+static llvm::StringRef findMaybeSymbol(llvm::StringRef text) {
+  const char *p = text.begin(), *end = text.end();
+  while ((p = static_cast<const char *>(memchr(p, '_', end - p)))) {
+    if (end - p >= 3 && p[1] == 'T' && isSymbolChar(p[2])) {
+      const char *symbolEnd = p + 3;
+      while (symbolEnd != end && isSymbolChar(*symbolEnd))
+        ++symbolEnd;
+      return llvm::StringRef(p, symbolEnd - p);
+    }
+    ++p;
+  }
+  return llvm::StringRef();
+}
+
+namespace {
+/// Remembers the demangled names of the symbols seen in stream mode, which
+/// repeat a lot in profiles and traces.
+class DemangleCache {
+  static const unsigned NumShards = 16;
+  static const unsigned MaxNamesPerShard = 1 << 16;
+
+  struct Shard {
+    std::mutex Lock;
+    llvm::StringMap<std::string> Names;
+  };
+  Shard Shards[NumShards];
+
+public:
+  /// Appends the demangled name of \p symbol to \p out, using \p arena to
+  /// demangle it if needed.
+  void demangle(llvm::StringRef symbol, swift::Demangle::NodeArena &arena,
+                const swift::Demangle::DemangleOptions &options,
+                std::string &out) {
+    Shard &shard = Shards[llvm::hash_value(symbol) % NumShards];
+    {
+      std::lock_guard<std::mutex> guard(shard.Lock);
+      auto known = shard.Names.find(symbol);
+      if (known != shard.Names.end()) {
+        out += known->getValue();
+        return;
+      }
+    }
+
+    std::string name;
+    {
+      swift::Demangle::NodePointer pointer =
+          swift::demangle_wrappers::demangleSymbolAsNode(symbol, arena);
+      name = swift::Demangle::nodeToString(pointer, options);
+    }
+    arena.reset();
+    if (name.empty())
+      name = symbol.str();
+    out += name;
+
+    std::lock_guard<std::mutex> guard(shard.Lock);
+    if (shard.Names.size() >= MaxNamesPerShard)
+      shard.Names.clear();
+    shard.Names.insert(std::make_pair(symbol, std::move(name)));
+  }
+};
+} // end anonymous namespace
+
+/// Returns \p text with the symbols in it replaced by their demangled names.
+static std::string
+demangleChunk(llvm::StringRef text, DemangleCache &cache,
+              const swift::Demangle::DemangleOptions &options) {
+  std::string out;
+  out.reserve(text.size() * 2);
+  swift::Demangle::NodeArena arena;
+  for (llvm::StringRef symbol = findMaybeSymbol(text); !symbol.empty();
+       symbol = findMaybeSymbol(text)) {
+    out += substrBefore(text, symbol);
+    cache.demangle(symbol, arena, options, out);
+    text = substrAfter(text, symbol);
+  }
+  out += text;
+  return out;
+}
+
+static void printThroughput(uint64_t bytes,
+                            std::chrono::duration<double> elapsed) {
+  double megabytes = bytes / (1024.0 * 1024.0);
+  llvm::errs() << llvm::format("%.1f MB in %.3f s: %.1f MB/s\n", megabytes,
+                               elapsed.count(),
+                               megabytes / elapsed.count());
+}
+
+/// Demangles the standard input in chunks on a pool of threads, writing the
+/// chunks out in order. Returns the number of bytes read.
+static uint64_t
+streamDemangle(const swift::Demangle::DemangleOptions &options) {
+  unsigned numThreads = NumThreads;
+  if (numThreads == 0)
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  llvm::ThreadPool pool(numThreads);
+  DemangleCache cache;
+
+  struct Chunk {
+    std::string input;
+    std::string output;
+    std::shared_future<void> done;
+  };
+  std::deque<std::unique_ptr<Chunk>> chunks;
+  auto writeFirstChunk = [&] {
+    chunks.front()->done.wait();
+    llvm::outs() << chunks.front()->output;
+    chunks.pop_front();
+  };
+
+  std::vector<char> buffer(std::max(1u, unsigned(StreamChunkSize)));
+  std::string pending;
+  uint64_t bytesRead = 0;
+  bool atEnd = false;
+  while (!atEnd) {
+    size_t size = fread(buffer.data(), 1, buffer.size(), stdin);
+    atEnd = size < buffer.size();
+    bytesRead += size;
+    pending.append(buffer.data(), size);
+
+    // Cut the chunk after the last character that can't be part of a symbol,
+    // so that no symbol is split between two chunks.
+    size_t cut = pending.size();
+    if (!atEnd) {
+      while (cut != 0 && isSymbolChar(pending[cut - 1]))
+        --cut;
+      if (cut == 0)
+        continue;
+    }
+
+    std::unique_ptr<Chunk> chunk(new Chunk());
+    chunk->input = pending.substr(0, cut);
+    pending.erase(0, cut);
+    Chunk *c = chunk.get();
+    c->done = pool.async([c, &cache, &options] {
+      c->output = demangleChunk(c->input, cache, options);
+    });
+    chunks.push_back(std::move(chunk));
+
+    // Bound the memory used by keeping at most two chunks per thread in
+    // flight.
+    while (chunks.size() > 2 * numThreads)
+      writeFirstChunk();
+  }
+  while (!chunks.empty())
+    writeFirstChunk();
+
+  if (ferror(stdin))
+    llvm::errs() << "error reading standard input\n";
+  return bytesRead;
+}
+
 int main(int argc, char **argv) {
 #if defined(__CYGWIN__)
   // Cygwin clang 3.5.2 with '-O3' generates CRASHING BINARY,
@@ -104,33 +308,55 @@ int main(int argc, char **argv) {
 #endif  
   llvm::cl::ParseCommandLineOptions(argc, argv);
 
+  // Stream mode only prints the demangled names.
+  if (StreamMode && (ExpandMode || TreeOnly || RemangleMode)) {
+    llvm::errs() << "error: -stream can't be combined with -expand, "
+                    "-tree-only or -test-remangle\n";
+    return EXIT_FAILURE;
+  }
+
   swift::Demangle::DemangleOptions options;
   options.SynthesizeSugarOnTypes = !DisableSugar;
   if (Simplified)
     options = swift::Demangle::DemangleOptions::SimplifiedUIDemangleOptions();
 
-  if (InputNames.empty()) {
+  swift::Demangle::NodeArena arena;
+  if (InputNames.empty() && StreamMode) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t bytesRead = streamDemangle(options);
+    llvm::outs().flush();
+    if (PrintThroughput)
+      printThroughput(bytesRead, std::chrono::steady_clock::now() - start);
+    if (ferror(stdin))
+      return EXIT_FAILURE;
+
+  } else if (InputNames.empty()) {
     CompactMode = true;
+    auto start = std::chrono::steady_clock::now();
     auto input = llvm::MemoryBuffer::getSTDIN();
     if (!input) {
       llvm::errs() << input.getError().message() << '\n';
       return EXIT_FAILURE;
     }
     llvm::StringRef inputContents = input.get()->getBuffer();
+    uint64_t bytesRead = inputContents.size();
 
     // This doesn't handle Unicode symbols, but maybe that's okay.
     llvm::Regex maybeSymbol("_T[_a-zA-Z0-9$]+");
     llvm::SmallVector<llvm::StringRef, 1> matches;
     while (maybeSymbol.match(inputContents, &matches)) {
       llvm::outs() << substrBefore(inputContents, matches.front());
-      demangle(llvm::outs(), matches.front(), options);
+      demangleAndReset(llvm::outs(), matches.front(), arena, options);
       inputContents = substrAfter(inputContents, matches.front());
     }
     llvm::outs() << inputContents;
+    llvm::outs().flush();
+    if (PrintThroughput)
+      printThroughput(bytesRead, std::chrono::steady_clock::now() - start);
 
   } else {
     for (llvm::StringRef name : InputNames) {
-      demangle(llvm::outs(), name, options);
+      demangleAndReset(llvm::outs(), name, arena, options);
       llvm::outs() << '\n';
     }
   }
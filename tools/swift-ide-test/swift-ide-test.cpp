@@ -237,6 +237,11 @@ static llvm::cl::opt<std::string>
                         llvm::cl::desc("Code completion cache path"),
                         llvm::cl::ZeroOrMore);
 
+static llvm::cl::opt<std::string>
+    CompletionCacheNamePrefix("completion-cache-name-prefix",
+                              llvm::cl::desc("Only dump the cached code "
+                                             "completions with this prefix"));
+
 static llvm::cl::list<std::string>
 ImportPaths("I", llvm::cl::desc("add a directory to the import search path"));
 
@@ -2721,7 +2726,8 @@ int main(int argc, char *argv[]) {
     ide::PrintingCodeCompletionConsumer Consumer(
         llvm::outs(), options::CodeCompletionKeywords);
     for (StringRef filename : options::InputFilenames) {
-      auto resultsOpt = ide::OnDiskCodeCompletionCache::getFromFile(filename);
+      auto resultsOpt = ide::OnDiskCodeCompletionCache::getFromFile(
+          filename, options::CompletionCacheNamePrefix);
       if (!resultsOpt) {
         // FIXME: error?
         continue;
@@ -1,5 +1,7 @@
 #include "swift/Basic/DemangleWrappers.h"
+#include "llvm/ADT/STLExtras.h"
 #include "gtest/gtest.h"
+#include <chrono>
 
 using namespace swift::demangle_wrappers;
 
@@ -11,3 +13,55 @@ TEST(Demangle, DemangleWrappers) {
       demangleSymbolAsString(MangledName));
 }
 
+
+static const char *const SampleSymbols[] = {
+  "_TFIvVs8_Process10_argumentsGSaSS_iU_FT_GSaSS_",
+  "_TTWC13call_protocol1CS_1PS_FS1_3foofT_Si",
+  "_TFC12dynamic_self1X1ffT_DS0_",
+  "_TTSg5SiSis3Foos_Sf___TFSqcfT_GSqx_",
+  "_TTSr5Si___TF4test7genericurFxx",
+  "_TPA__TTRXFo_oSSoSS_dSb_XFo_iSSiSS_dSb_31",
+  "_TiC4Meow5MyCls9subscriptFT1iSi_Sf",
+  "_TF8manglingX30Proprostnemluvesky_uybCEdmaEBaFT_T_",
+  "_TFE11ext_structAV11def_structA1A4testfT_T_",
+  "_TF13devirt_accessP5_DISC15getPrivateClassFT_CS_P5_DISC12PrivateClass",
+  "_TFCs13_NSSwiftArray29canStoreElementsOfDynamicTypefPMP_Sb",
+  "_TTSf1cl35_TFF7specgen6callerFSiT_U_FTSiSi_T_Si___TTSg5Si___TF7specgen"
+      "12take_closureFFTSiSi_T_T_",
+};
+
+TEST(Demangle, DemangleIntoArena) {
+  NodeArena Arena;
+  for (const char *Symbol : SampleSymbols) {
+    NodePointer FromHeap = demangleSymbolAsNode(Symbol);
+    NodePointer FromArena = demangleSymbolAsNode(Symbol, Arena);
+    ASSERT_TRUE(FromHeap != nullptr) << Symbol;
+    ASSERT_TRUE(FromArena != nullptr) << Symbol;
+    EXPECT_EQ(swift::Demangle::nodeToString(FromHeap),
+              swift::Demangle::nodeToString(FromArena));
+    EXPECT_EQ(Symbol, swift::Demangle::mangleNode(FromArena));
+  }
+}
+
+TEST(Demangle, ArenaThroughput) {
+  const unsigned Rounds = 5000;
+  auto timeDemangling = [&](NodeArena *Arena) {
+    auto Start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i != Rounds; ++i) {
+      for (const char *Symbol : SampleSymbols) {
+        NodePointer Root = Arena ? demangleSymbolAsNode(Symbol, *Arena)
+                                 : demangleSymbolAsNode(Symbol);
+        EXPECT_TRUE(Root != nullptr);
+      }
+      if (Arena)
+        Arena->reset();
+    }
+    std::chrono::duration<double> Elapsed =
+        std::chrono::steady_clock::now() - Start;
+    return Rounds * llvm::array_lengthof(SampleSymbols) / Elapsed.count();
+  };
+
+  NodeArena Arena;
+  RecordProperty("HeapSymbolsPerSecond", int(timeDemangling(nullptr)));
+  RecordProperty("ArenaSymbolsPerSecond", int(timeDemangling(&Arena)));
+}
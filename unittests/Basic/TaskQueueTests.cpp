@@ -0,0 +1,110 @@
+//===--- TaskQueueTests.cpp - for swift/Basic/TaskQueue.h -----------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/TaskQueue.h"
+#include "swift/Basic/LLVM.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+
+using namespace swift;
+using namespace swift::sys;
+
+#if LLVM_ON_UNIX && !defined(__CYGWIN__)
+
+namespace {
+
+const char *const EchoArgs[] = { "-c", "echo hello" };
+const char *const LargeOutputArgs[] = { "-c", "head -c 100000 /dev/zero" };
+const char *const ClosedOutputArgs[] = { "-c", "exec >&-; sleep 0.1; exit 3" };
+const char *const TrueArgs[] = { "-c", "exit 0" };
+
+TEST(TaskQueue, OutputAndExitCodes) {
+  TaskQueue Queue(8);
+  for (unsigned i = 0; i < 16; ++i) {
+    ArrayRef<const char *> Args;
+    switch (i % 3) {
+    case 0: Args = EchoArgs; break;
+    case 1: Args = LargeOutputArgs; break;
+    case 2: Args = ClosedOutputArgs; break;
+    }
+    Queue.addTask("/bin/sh", Args, llvm::None,
+                  reinterpret_cast<void *>(uintptr_t(i)));
+  }
+
+  unsigned NumFinished = 0;
+  bool Failed = Queue.execute(
+      nullptr,
+      [&](ProcessId Pid, int ReturnCode, StringRef Output, void *Context) {
+        ++NumFinished;
+        switch (reinterpret_cast<uintptr_t>(Context) % 3) {
+        case 0:
+          EXPECT_EQ(0, ReturnCode);
+          EXPECT_EQ("hello\n", Output);
+          break;
+        case 1:
+          EXPECT_EQ(0, ReturnCode);
+          EXPECT_EQ(100000u, Output.size());
+          break;
+        case 2:
+          // The Task closed its output long before it exited.
+          EXPECT_EQ(3, ReturnCode);
+          EXPECT_TRUE(Output.empty());
+          break;
+        }
+        return TaskFinishedResponse::ContinueExecution;
+      });
+
+  EXPECT_FALSE(Failed);
+  EXPECT_EQ(16u, NumFinished);
+}
+
+TEST(TaskQueue, StopExecution) {
+  TaskQueue Queue(1);
+  for (unsigned i = 0; i < 4; ++i)
+    Queue.addTask("/bin/sh", TrueArgs);
+
+  unsigned NumFinished = 0;
+  bool Failed = Queue.execute(
+      nullptr,
+      [&](ProcessId Pid, int ReturnCode, StringRef Output, void *Context) {
+        ++NumFinished;
+        return TaskFinishedResponse::StopExecution;
+      });
+
+  EXPECT_TRUE(Failed);
+  EXPECT_EQ(1u, NumFinished);
+  EXPECT_TRUE(Queue.hasRemainingTasks());
+}
+
+// Measures the overhead of the driver's event loop by running many jobs
+// which do nothing. Run with --gtest_also_run_disabled_tests.
+TEST(TaskQueue, DISABLED_ManyTrivialTasks) {
+  for (unsigned NumTasks : {1000u, 4000u}) {
+    TaskQueue Queue(128);
+    for (unsigned i = 0; i < NumTasks; ++i)
+      Queue.addTask("/bin/sh", TrueArgs);
+
+    auto Start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(Queue.execute());
+    auto Elapsed = std::chrono::steady_clock::now() - Start;
+    llvm::outs() << NumTasks << " tasks: "
+                 << std::chrono::duration_cast<std::chrono::milliseconds>(
+                        Elapsed).count()
+                 << "ms\n";
+  }
+}
+
+} // end anonymous namespace
+
+#endif
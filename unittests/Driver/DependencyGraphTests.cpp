@@ -1,8 +1,26 @@
 #include "swift/Driver/DependencyGraph.h"
+#include "swift/Basic/BinarySwiftDeps.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace swift;
 using LoadResult = DependencyGraphImpl::LoadResult;
+using binary_swiftdeps::Section;
+
+static std::string
+writeBinary(ArrayRef<std::tuple<Section, StringRef, bool>> entries,
+            StringRef interfaceHash = "") {
+  binary_swiftdeps::Writer writer;
+  for (auto &entry : entries)
+    writer.addEntry(std::get<0>(entry), std::get<1>(entry), std::get<2>(entry));
+  if (!interfaceHash.empty())
+    writer.setInterfaceHash(interfaceHash);
+
+  std::string result;
+  llvm::raw_string_ostream out(result);
+  writer.write(out);
+  return out.str();
+}
 
 TEST(DependencyGraph, BasicLoad) {
   DependencyGraph<uintptr_t> graph;
@@ -790,3 +808,84 @@ TEST(DependencyGraph, ChainedExternalPreMarked) {
   EXPECT_TRUE(graph.isMarked(0));
   EXPECT_FALSE(graph.isMarked(1));
 }
+
+TEST(DependencyGraph, BinaryLoad) {
+  DependencyGraph<uintptr_t> graph;
+
+  EXPECT_EQ(graph.loadFromString(0, writeBinary({
+              std::make_tuple(Section::ProvidesTopLevel, "a", true),
+              std::make_tuple(Section::ProvidesMember,
+                              StringRef("b\0bb", 4), true),
+              std::make_tuple(Section::DependsExternal, "/foo", true),
+            }, "hash")),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(1, writeBinary({
+              std::make_tuple(Section::DependsTopLevel, "a", true),
+            })),
+            LoadResult::UpToDate);
+  EXPECT_EQ(graph.loadFromString(2, writeBinary({
+              std::make_tuple(Section::DependsMember,
+                              StringRef("b\0bb", 4), false),
+            })),
+            LoadResult::UpToDate);
+
+  // Nothing provides things privately.
+  EXPECT_EQ(graph.loadFromString(3, writeBinary({
+              std::make_tuple(Section::ProvidesNominal, "c", false),
+            })),
+            LoadResult::HadError);
+
+  // Truncated files are rejected.
+  std::string truncated = writeBinary({
+    std::make_tuple(Section::DependsTopLevel, "d", true),
+  });
+  truncated.pop_back();
+  EXPECT_EQ(graph.loadFromString(4, truncated), LoadResult::HadError);
+
+  SmallVector<uintptr_t, 4> marked;
+  graph.markTransitive(marked, 0);
+  EXPECT_EQ(2u, marked.size());
+  EXPECT_TRUE(graph.isMarked(1));
+  EXPECT_FALSE(graph.isMarked(2));
+
+  std::vector<std::string> externals(graph.getExternalDependencies().begin(),
+                                     graph.getExternalDependencies().end());
+  EXPECT_EQ(std::vector<std::string>{"/foo"}, externals);
+}
+
+TEST(DependencyGraph, BinaryMatchesYAML) {
+  DependencyGraph<uintptr_t> yamlGraph;
+  DependencyGraph<uintptr_t> binaryGraph;
+
+  EXPECT_EQ(yamlGraph.loadFromString(0,
+                                     "provides-nominal: [a]\n"
+                                     "depends-top-level: [!private b]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(yamlGraph.loadFromString(1,
+                                     "provides-top-level: [b]\n"
+                                     "depends-nominal: [a]"),
+            LoadResult::UpToDate);
+  EXPECT_EQ(yamlGraph.loadFromString(2, "depends-top-level: [!private b]"),
+            LoadResult::UpToDate);
+
+  EXPECT_EQ(binaryGraph.loadFromString(0, writeBinary({
+              std::make_tuple(Section::ProvidesNominal, "a", true),
+              std::make_tuple(Section::DependsTopLevel, "b", false),
+            })),
+            LoadResult::UpToDate);
+  EXPECT_EQ(binaryGraph.loadFromString(1, writeBinary({
+              std::make_tuple(Section::ProvidesTopLevel, "b", true),
+              std::make_tuple(Section::DependsNominal, "a", true),
+            })),
+            LoadResult::UpToDate);
+  EXPECT_EQ(binaryGraph.loadFromString(2, writeBinary({
+              std::make_tuple(Section::DependsTopLevel, "b", false),
+            })),
+            LoadResult::UpToDate);
+
+  SmallVector<uintptr_t, 4> yamlMarked, binaryMarked;
+  yamlGraph.markTransitive(yamlMarked, 1);
+  binaryGraph.markTransitive(binaryMarked, 1);
+  EXPECT_EQ(yamlMarked, binaryMarked);
+  EXPECT_EQ(2u, binaryMarked.size());
+}
@@ -0,0 +1,106 @@
+//===--- CodeCompletionCache.cpp - Reading cached results by prefix -------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/IDE/CodeCompletionCache.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace swift;
+using namespace ide;
+
+namespace {
+/// A cache directory and a module file to key the cached results by, removed
+/// at the end of the test.
+class CodeCompletionCacheTest : public ::testing::Test {
+protected:
+  llvm::SmallString<128> Dir;
+  CodeCompletionCache::Key Key;
+
+  void SetUp() override {
+    ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("completion-cache", Dir));
+    llvm::SmallString<128> ModuleFilename(Dir);
+    llvm::sys::path::append(ModuleFilename, "Module.swiftmodule");
+    {
+      std::error_code EC;
+      llvm::raw_fd_ostream Out(ModuleFilename, EC, llvm::sys::fs::F_None);
+      ASSERT_FALSE(EC);
+      Out << "module";
+    }
+    Key = {ModuleFilename.str(), "Module", {}, false, false};
+  }
+
+  void TearDown() override {
+    std::error_code EC;
+    for (llvm::sys::fs::directory_iterator I(Dir, EC), E; !EC && I != E;
+         I.increment(EC))
+      llvm::sys::fs::remove(I->path());
+    llvm::sys::fs::remove(Dir);
+  }
+
+  static void addResult(CodeCompletionCache::Value &V, StringRef Name) {
+    auto *String = CodeCompletionString::create(
+        *V.Sink.Allocator,
+        CodeCompletionString::Chunk::createWithText(
+            CodeCompletionString::Chunk::ChunkKind::Text, 0, Name));
+    V.Sink.Results.push_back(new (*V.Sink.Allocator) CodeCompletionResult(
+        CodeCompletionResult::Pattern, SemanticContextKind::OtherModule, 0,
+        String));
+  }
+
+  static std::vector<std::string>
+  getNames(const CodeCompletionCache::ValueRefCntPtr &V) {
+    std::vector<std::string> Names;
+    for (auto *R : V->Sink.Results) {
+      std::string Name;
+      llvm::raw_string_ostream OS(Name);
+      R->getCompletionString()->getName(OS);
+      Names.push_back(OS.str());
+    }
+    return Names;
+  }
+};
+} // end anonymous namespace
+
+TEST_F(CodeCompletionCacheTest, ReadOnlyResultsWithNamePrefix) {
+  OnDiskCodeCompletionCache OnDisk(Dir);
+  {
+    CodeCompletionCache Writer(&OnDisk);
+    auto V = CodeCompletionCache::createValue();
+    for (StringRef Name : {"foo", "bar", "Food", "fob", "afoot"})
+      addResult(*V, Name);
+    Writer.set(Key, V);
+  }
+
+  // Only the results that start with the prefix, ignoring case, are read from
+  // disk, in the order they were written.
+  CodeCompletionCache Reader(&OnDisk);
+  auto Partial = Reader.get(Key, "fo");
+  ASSERT_TRUE(Partial.hasValue());
+  EXPECT_EQ((std::vector<std::string>{"foo", "Food", "fob"}),
+            getNames(*Partial));
+
+  Partial = Reader.get(Key, "FOO");
+  ASSERT_TRUE(Partial.hasValue());
+  EXPECT_EQ((std::vector<std::string>{"foo", "Food"}), getNames(*Partial));
+
+  Partial = Reader.get(Key, "baz");
+  ASSERT_TRUE(Partial.hasValue());
+  EXPECT_TRUE(getNames(*Partial).empty());
+
+  // The partial results aren't kept in memory for requests without a prefix.
+  auto Full = Reader.get(Key);
+  ASSERT_TRUE(Full.hasValue());
+  EXPECT_EQ((std::vector<std::string>{"foo", "bar", "Food", "fob", "afoot"}),
+            getNames(*Full));
+}
@@ -4,6 +4,7 @@
 #include "swift/Subsystems.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "gtest/gtest.h"
+#include <chrono>
 
 using namespace swift;
 using namespace llvm;
@@ -352,3 +353,63 @@ TEST_F(LexerTest, NestedPlaceholder) {
   std::vector<Token> Toks = checkLex(Source, ExpectedTokens);
   EXPECT_EQ("<#aa#>", Toks[2].getText());
 }
+
+TEST_F(LexerTest, LongRuns) {
+  const char *Source =
+      "abcdefghijklmnopqrstuvwxyz_$0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ;\n"
+      "abcdefghijklmnopqrstuvwxyz\u00e9abcdefghijklmnopqrstuvwxyz\n"
+      "// A line comment that is longer than sixteen characters \u00e9 */\n"
+      "/* A block comment /* that nests */ and spans\n"
+      "   several lines of text \u00e9 */ x\n"
+      "\t\t        \t\"A string literal with an \\(interpolation) and \\n\"";
+  std::vector<tok> ExpectedTokens{
+    tok::identifier, tok::semi, tok::identifier, tok::comment,
+    tok::comment, tok::identifier, tok::string_literal
+  };
+  std::vector<Token> Toks = checkLex(Source, ExpectedTokens,
+                                     /*KeepComments=*/true);
+  EXPECT_EQ("abcdefghijklmnopqrstuvwxyz_$0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+            Toks[0].getText());
+  EXPECT_EQ("abcdefghijklmnopqrstuvwxyz\u00e9abcdefghijklmnopqrstuvwxyz",
+            Toks[2].getText());
+  EXPECT_TRUE(Toks[4].isAtStartOfLine());
+  EXPECT_FALSE(Toks[5].isAtStartOfLine());
+  EXPECT_TRUE(Toks[6].isAtStartOfLine());
+  EXPECT_EQ(50U, Toks[6].getLength());
+}
+
+TEST_F(LexerTest, Throughput) {
+  std::string Source;
+  for (unsigned i = 0; Source.size() < 8 * 1024 * 1024; ++i) {
+    Source += "/// Returns the value of element number " + std::to_string(i) +
+              ", or nil if there is none.\n"
+              "/* Block comment for declaration " + std::to_string(i) +
+              " */\n"
+              "func lookupElementNumber" + std::to_string(i) +
+              "(_ collection: [String], at index: Int) -> String? {\n"
+              "    let message = \"index out of bounds in lookup\"\n"
+              "    guard index < collection.count else { print(message); "
+              "return nil }\n"
+              "    return collection[index] // The common case.\n"
+              "}\n\n";
+  }
+  unsigned BufferID = SourceMgr.addMemBufferCopy(Source);
+
+  auto Start = std::chrono::steady_clock::now();
+  Lexer L(LangOpts, SourceMgr, BufferID, /*Diags=*/nullptr,
+          /*InSILMode=*/false, CommentRetentionMode::ReturnAsTokens);
+  Token Tok;
+  unsigned NumTokens = 0;
+  do {
+    L.lex(Tok);
+    ++NumTokens;
+  } while (Tok.isNot(tok::eof));
+  std::chrono::duration<double> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+
+  double MegabytesPerSecond =
+      Source.size() / (1024.0 * 1024) / Elapsed.count();
+  RecordProperty("MegabytesPerSecond", int(MegabytesPerSecond));
+  RecordProperty("Tokens", int(NumTokens));
+  EXPECT_GT(NumTokens, Source.size() / 20);
+}
@@ -173,3 +173,68 @@ TEST_F(TokenizerTest, ProperlySplitTokens) {
   );
 }
 
+
+TEST_F(TokenizerTest, RetokenizeMatchesTokenize) {
+  StringRef Source =
+    "/* A block comment\n"
+    "   over two lines */\n"
+    "func foo(a: Int) -> String {\n"
+    "  let b = a + 1 // trailing\n"
+    "  return \"\\(a) and \\(b)\"\n"
+    "}\n"
+    "\n"
+    "struct S {\n"
+    "  var x = [1, 2, 3]\n"
+    "}\n";
+  auto OldBufID = makeBuffer(Source);
+  auto OldTokens = tokenize(OldBufID);
+  StringRef OldText = SM.extractText(SM.getRangeForBuffer(OldBufID));
+
+  struct Edit {
+    unsigned Offset;
+    unsigned Length;
+    StringRef Text;
+  };
+  auto find = [&](StringRef Str) -> unsigned { return Source.find(Str); };
+  Edit Edits[] = {
+    // A character in an identifier.
+    { find("foo"), 0, "x" },
+    // The start of the buffer.
+    { 0, 0, "\n" },
+    // The end of the buffer.
+    { unsigned(Source.size()), 0, "let c = 0\n" },
+    // Opening a block comment that swallows the rest of the buffer.
+    { find("struct"), 0, "/*" },
+    // Closing the block comment early.
+    { find("over"), 0, "*/" },
+    // Inside an interpolated string.
+    { find("and"), 3, "or" },
+    // Unterminating a string literal.
+    { find("\"\n}"), 1, "" },
+    // Joining two lines.
+    { find("\n  return"), 3, "" },
+    // Replacing several lines.
+    { find("let b"), find("struct") - find("let b"), "}\n" },
+  };
+
+  for (auto &E : Edits) {
+    std::string NewSource = Source.substr(0, E.Offset);
+    NewSource += E.Text;
+    NewSource += Source.substr(E.Offset + E.Length);
+    auto NewBufID = makeBuffer(NewSource);
+
+    auto Expected = tokenize(NewBufID);
+    auto Actual = swift::retokenize(LangOpts, SM, NewBufID, OldTokens,
+                                    OldText, E.Offset, E.Length,
+                                    E.Text.size());
+    ASSERT_EQ(Expected.size(), Actual.size()) << NewSource;
+    for (unsigned i = 0, e = Expected.size(); i != e; ++i) {
+      EXPECT_EQ(Expected[i].getKind(), Actual[i].getKind()) << NewSource;
+      EXPECT_EQ(Expected[i].getText().data(), Actual[i].getText().data())
+        << NewSource;
+      EXPECT_EQ(Expected[i].getLength(), Actual[i].getLength()) << NewSource;
+      EXPECT_EQ(Expected[i].isAtStartOfLine(), Actual[i].isAtStartOfLine())
+        << NewSource;
+    }
+  }
+}
@@ -0,0 +1,111 @@
+//===--- ConcurrentDeserializationTests.cpp - Sharing a ModuleFile --------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/AST/ASTContext.h"
+#include "swift/AST/Decl.h"
+#include "swift/AST/Module.h"
+#include "swift/Frontend/Frontend.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+using namespace swift;
+
+namespace {
+/// A compiler instance with the standard library loaded.
+class StdlibInstance {
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+
+public:
+  CompilerInstance CI;
+  ModuleDecl *Stdlib = nullptr;
+
+  bool setup() {
+    CompilerInvocation Invocation;
+    Invocation.setRuntimeResourcePath(SWIFTLIB_DIR);
+    Invocation.setModuleName("main");
+    Invocation.setInputKind(InputFileKind::IFK_Swift_Library);
+    Buffer = llvm::MemoryBuffer::getMemBuffer("", "main.swift");
+    Invocation.addInputBuffer(Buffer.get());
+    if (CI.setup(Invocation))
+      return false;
+
+    Stdlib = CI.getASTContext().getStdlibModule(/*loadIfAbsent=*/true);
+    return Stdlib != nullptr;
+  }
+};
+} // end anonymous namespace
+
+TEST(ConcurrentDeserialization, StdlibLookupsFromManyThreads) {
+  // Find the names of the stdlib's top-level values, and what looking them up
+  // returns, in a context of their own.
+  StdlibInstance Reference;
+  ASSERT_TRUE(Reference.setup());
+
+  SmallVector<Decl *, 1024> TopLevelDecls;
+  Reference.Stdlib->getTopLevelDecls(TopLevelDecls);
+  llvm::StringSet<> SeenNames;
+  std::vector<std::string> Names;
+  for (auto *D : TopLevelDecls) {
+    auto *VD = dyn_cast<ValueDecl>(D);
+    if (VD && !VD->getName().empty() &&
+        SeenNames.insert(VD->getName().str()).second)
+      Names.push_back(VD->getName().str());
+  }
+  ASSERT_FALSE(Names.empty());
+
+  std::vector<size_t> ExpectedCounts;
+  ASTContext &ReferenceCtx = Reference.CI.getASTContext();
+  for (auto &Name : Names) {
+    SmallVector<ValueDecl *, 4> Results;
+    Reference.Stdlib->lookupValue({}, ReferenceCtx.getIdentifier(Name),
+                                  NLKind::QualifiedLookup, Results);
+    ExpectedCounts.push_back(Results.size());
+  }
+
+  // Then look them all up again in a fresh context from several threads at
+  // once. Each thread starts at a different name and wraps around, so that
+  // the threads race on deserializing the same decls and the decls they
+  // refer to. Only deserialization is thread-safe, so the threads don't look
+  // any further into the decls they find.
+  StdlibInstance Shared;
+  ASSERT_TRUE(Shared.setup());
+  ASTContext &Ctx = Shared.CI.getASTContext();
+  std::vector<Identifier> Idents;
+  for (auto &Name : Names)
+    Idents.push_back(Ctx.getIdentifier(Name));
+
+  const unsigned NumThreads = 8;
+  std::vector<std::vector<SmallVector<ValueDecl *, 4>>> Found(
+      NumThreads, std::vector<SmallVector<ValueDecl *, 4>>(Names.size()));
+  std::vector<std::thread> Threads;
+  for (unsigned T = 0; T != NumThreads; ++T) {
+    Threads.emplace_back([&, T] {
+      for (size_t I = 0, E = Names.size(); I != E; ++I) {
+        size_t Index = (I + T * E / NumThreads) % E;
+        Shared.Stdlib->lookupValue({}, Idents[Index], NLKind::QualifiedLookup,
+                                   Found[T][Index]);
+      }
+    });
+  }
+  for (auto &Thread : Threads)
+    Thread.join();
+
+  // Every thread must have found the same decls, and as many of them as the
+  // reference lookups.
+  for (size_t Index = 0, E = Names.size(); Index != E; ++Index) {
+    EXPECT_EQ(ExpectedCounts[Index], Found[0][Index].size()) << Names[Index];
+    for (unsigned T = 1; T != NumThreads; ++T)
+      EXPECT_TRUE(Found[T][Index] == Found[0][Index]) << Names[Index];
+  }
+}
@@ -10,10 +10,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "SourceKit/Support/Concurrency.h"
 #include "SourceKit/Support/FuzzyStringMatcher.h"
 #include "gtest/gtest.h"
+#include <string>
+#include <vector>
 
 using FuzzyStringMatcher = SourceKit::FuzzyStringMatcher;
+using WorkQueue = SourceKit::WorkQueue;
 
 TEST(FuzzyStringMatcher, BasicMatching) {
   {
@@ -51,6 +55,27 @@ TEST(FuzzyStringMatcher, SingleCharacterMatching) {
   EXPECT_FALSE(FuzzyStringMatcher("a").matchesCandidate(""));
 }
 
+TEST(FuzzyStringMatcher, CharacterMaskPrefilter) {
+  auto mayMatch = [](const FuzzyStringMatcher &m, llvm::StringRef candidate) {
+    return m.mayMatchCandidate(
+        FuzzyStringMatcher::getCharacterMask(candidate));
+  };
+
+  FuzzyStringMatcher m("asDf");
+  EXPECT_TRUE(mayMatch(m, "ASDF"));
+  EXPECT_TRUE(mayMatch(m, "a_s_d_f"));
+  EXPECT_TRUE(mayMatch(m, "fdsa")); // Order is not taken into account.
+  EXPECT_FALSE(mayMatch(m, "asd"));
+  EXPECT_FALSE(mayMatch(m, ""));
+
+  // Whatever matches passes the prefilter.
+  for (llvm::StringRef candidate : {"ASDF", "xASDF", "a_s_d_f", "aSdF", "sdfa"})
+    if (m.matchesCandidate(candidate))
+      EXPECT_TRUE(mayMatch(m, candidate));
+
+  EXPECT_TRUE(mayMatch(FuzzyStringMatcher(""), ""));
+}
+
 TEST(FuzzyStringMatcher, UnicodeMatching) {
   // Single code point matching.
   EXPECT_TRUE(FuzzyStringMatcher(u8"\u2602a\U0002000Bz")
@@ -316,3 +341,30 @@ TEST(FuzzyStringMatcher, ShortUnconnectedMatches) {
   EXPECT_GT(m.scoreCandidate("xaxbxcdxxxxxx"), m.scoreCandidate("xaxbxcxd"));
   EXPECT_GT(m.scoreCandidate("xaxbxc_d"), m.scoreCandidate("xaxbxcxd"));
 }
+
+TEST(FuzzyStringMatcher, ConcurrentScoring) {
+  // Code completion scores large result sets in ranges on several threads.
+  // That must give every candidate the score it gets when scored serially.
+  FuzzyStringMatcher m("cab");
+  m.normalize = true;
+
+  for (unsigned count : {0u, 1u, 5u, 10000u}) {
+    std::vector<std::string> candidates;
+    for (unsigned i = 0; i != count; ++i) {
+      candidates.push_back("candidate" + std::to_string(i * 7919 % 10007) +
+                           (i % 3 ? "_ab" : "Abc"));
+    }
+
+    std::vector<double> serial;
+    for (auto &candidate : candidates)
+      serial.push_back(m.scoreCandidate(candidate));
+
+    std::vector<double> concurrent(count, -1.0);
+    WorkQueue::concurrentApplyRanges(count, /*MinPerThread=*/1,
+                                     [&](size_t begin, size_t end) {
+      for (size_t i = begin; i != end; ++i)
+        concurrent[i] = m.scoreCandidate(candidates[i]);
+    });
+    EXPECT_EQ(serial, concurrent) << count << " candidates";
+  }
+}
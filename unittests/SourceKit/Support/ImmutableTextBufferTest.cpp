@@ -12,6 +12,7 @@
 
 #include "SourceKit/Support/ImmutableTextBuffer.h"
 #include "gtest/gtest.h"
+#include <chrono>
 
 using namespace SourceKit;
 using namespace llvm;
@@ -43,3 +44,71 @@ TEST(EditableTextBuffer, Updates) {
 
   EXPECT_EQ(Buf->getFilename(), "/a/test");
 }
+
+TEST(EditableTextBuffer, SnapshotsKeepTheirText) {
+  EditableTextBufferRef EdBuf = new EditableTextBuffer("/a/test", "abc\ndef");
+  ImmutableTextSnapshotRef First = EdBuf->getSnapshot();
+  ImmutableTextSnapshotRef Second = EdBuf->insert(4, "xyz\n");
+  ImmutableTextSnapshotRef Third = EdBuf->erase(0, 4);
+
+  EXPECT_EQ("abc\ndef", First->getRope().str());
+  EXPECT_EQ("abc\nxyz\ndef", Second->getRope().str());
+  EXPECT_EQ("xyz\ndef", Third->getRope().str());
+
+  // Materialize the snapshots out of order.
+  EXPECT_EQ("xyz\ndef", Third->getBuffer()->getText());
+  EXPECT_EQ("abc\nxyz\ndef", Second->getBuffer()->getText());
+  EXPECT_EQ("abc\ndef", First->getBuffer()->getText());
+
+  EXPECT_EQ(std::make_pair(3u, 2u), Second->getLineAndColumn(9));
+  EXPECT_EQ(std::make_pair(3u, 2u), Second->getBuffer()->getLineAndColumn(9));
+  EXPECT_EQ(std::make_pair(2u, 2u), Third->getLineAndColumn(5));
+}
+
+namespace {
+/// Runs \p Fn \p Count times and returns the average time it took, in
+/// nanoseconds.
+template <typename Fn>
+static int64_t timePerIteration(unsigned Count, Fn &&fn) {
+  auto Start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i != Count; ++i)
+    fn(i);
+  auto End = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      End - Start).count() / Count;
+}
+} // end anonymous namespace
+
+// Records the cost of editing, taking snapshots of and looking up lines in a
+// large buffer as test properties.
+TEST(EditableTextBuffer, EditSnapshotAndLineLookupCosts) {
+  std::string Text;
+  for (unsigned i = 0; i != 100000; ++i)
+    Text += "let value" + std::to_string(i) + " = " + std::to_string(i) + "\n";
+  EditableTextBufferRef EdBuf = new EditableTextBuffer("/a/test", Text);
+  const unsigned Count = 1000;
+
+  int64_t EditNS = timePerIteration(Count, [&](unsigned i) {
+    EdBuf->insert((i * 7919) % Text.size(), "x");
+  });
+  RecordProperty("EditNanoseconds", int(EditNS));
+
+  std::vector<ImmutableTextSnapshotRef> Snapshots;
+  int64_t SnapshotNS = timePerIteration(Count, [&](unsigned i) {
+    Snapshots.push_back(EdBuf->getSnapshot());
+  });
+  RecordProperty("SnapshotNanoseconds", int(SnapshotNS));
+
+  ImmutableTextSnapshotRef Snapshot = EdBuf->getSnapshot();
+  int64_t LineLookupNS = timePerIteration(Count, [&](unsigned i) {
+    Snapshot->getLineAndColumn((i * 104729) % Snapshot->getSize());
+  });
+  RecordProperty("LineLookupNanoseconds", int(LineLookupNS));
+
+  int64_t MaterializeNS = timePerIteration(10, [&](unsigned i) {
+    EdBuf->insert(i, "x")->getBuffer();
+  });
+  RecordProperty("MaterializeNanoseconds", int(MaterializeNS));
+
+  EXPECT_EQ(Text.size() + Count + 10, EdBuf->getSnapshot()->getSize());
+}
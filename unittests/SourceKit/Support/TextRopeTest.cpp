@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "SourceKit/Support/TextRope.h"
+#include "gtest/gtest.h"
+#include <random>
+
+using namespace SourceKit;
+using namespace llvm;
+
+static std::pair<unsigned, unsigned> getLineAndColumn(StringRef Text,
+                                                      size_t Offset) {
+  StringRef Before = Text.substr(0, Offset);
+  unsigned Line = Before.count('\n') + 1;
+  size_t LastNewline = Before.rfind('\n');
+  size_t LineStart = LastNewline == StringRef::npos ? 0 : LastNewline + 1;
+  return std::make_pair(Line, Offset - LineStart + 1);
+}
+
+TEST(TextRope, Edits) {
+  TextRope Rope("hello world");
+  EXPECT_EQ(11u, Rope.size());
+  EXPECT_EQ("hello world", Rope.str());
+
+  TextRope Inserted = Rope.insert(6, "all ");
+  EXPECT_EQ("hello all world", Inserted.str());
+
+  TextRope Erased = Inserted.erase(9, 6);
+  EXPECT_EQ("hello all", Erased.str());
+
+  TextRope Replaced = Erased.replace(0, 5, "yo");
+  EXPECT_EQ("yo all", Replaced.str());
+
+  // The older versions are unchanged.
+  EXPECT_EQ("hello world", Rope.str());
+  EXPECT_EQ("hello all world", Inserted.str());
+  EXPECT_EQ("hello all", Erased.str());
+
+  EXPECT_TRUE(Replaced.erase(0, 6).empty());
+  EXPECT_TRUE(TextRope().empty());
+  EXPECT_EQ("", TextRope().str());
+}
+
+TEST(TextRope, Lines) {
+  TextRope Rope("a\nbc\n\ndef");
+  EXPECT_EQ(4u, Rope.getNumLines());
+  EXPECT_EQ(0u, *Rope.getLineStartOffset(1));
+  EXPECT_EQ(2u, *Rope.getLineStartOffset(2));
+  EXPECT_EQ(5u, *Rope.getLineStartOffset(3));
+  EXPECT_EQ(6u, *Rope.getLineStartOffset(4));
+  EXPECT_FALSE(Rope.getLineStartOffset(0).hasValue());
+  EXPECT_FALSE(Rope.getLineStartOffset(5).hasValue());
+
+  EXPECT_EQ(std::make_pair(1u, 1u), Rope.getLineAndColumn(0));
+  EXPECT_EQ(std::make_pair(1u, 2u), Rope.getLineAndColumn(1));
+  EXPECT_EQ(std::make_pair(2u, 1u), Rope.getLineAndColumn(2));
+  EXPECT_EQ(std::make_pair(3u, 1u), Rope.getLineAndColumn(5));
+  EXPECT_EQ(std::make_pair(4u, 4u), Rope.getLineAndColumn(9));
+  EXPECT_EQ(std::make_pair(0u, 0u), Rope.getLineAndColumn(10));
+}
+
+TEST(TextRope, RandomEdits) {
+  std::mt19937 Gen(42);
+  auto random = [&](size_t Max) -> size_t {
+    return std::uniform_int_distribution<size_t>(0, Max)(Gen);
+  };
+  auto randomText = [&](size_t Length) {
+    std::string Text;
+    for (size_t i = 0; i != Length; ++i)
+      Text += "ab \n"[random(3)];
+    return Text;
+  };
+
+  std::string Expected = randomText(5000);
+  TextRope Rope(Expected);
+  std::vector<std::pair<std::string, TextRope>> Versions;
+
+  for (unsigned i = 0; i != 2000; ++i) {
+    size_t Offset = random(Expected.size());
+    size_t Length = random(std::min<size_t>(Expected.size() - Offset, 50));
+    std::string Text = randomText(random(i % 10 ? 5 : 3000));
+    Expected.replace(Offset, Length, Text);
+    Rope = Rope.replace(Offset, Length, Text);
+    ASSERT_EQ(Expected.size(), Rope.size());
+
+    size_t Probe = random(Expected.size());
+    EXPECT_EQ(getLineAndColumn(Expected, Probe), Rope.getLineAndColumn(Probe));
+
+    if (i % 100 == 0)
+      Versions.emplace_back(Expected, Rope);
+  }
+
+  EXPECT_EQ(Expected, Rope.str());
+  EXPECT_EQ(StringRef(Expected).count('\n') + 1, Rope.getNumLines());
+  for (auto &Version : Versions)
+    EXPECT_EQ(Version.first, Version.second.str());
+}
@@ -0,0 +1,275 @@
+//===----------------------------------------------------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "SourceKit/Core/Context.h"
+#include "SourceKit/Core/LangSupport.h"
+#include "SourceKit/Core/NotificationCenter.h"
+#include "SourceKit/SwiftLang/Factory.h"
+#include "SwiftLangSupport.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "gtest/gtest.h"
+#include <chrono>
+
+using namespace SourceKit;
+using namespace llvm;
+
+static StringRef getRuntimeLibPath() {
+  return sys::path::parent_path(SWIFTLIB_DIR);
+}
+
+namespace {
+
+struct SyntaxMapEntry {
+  unsigned Offset;
+  unsigned Length;
+  UIdent Kind;
+
+  bool operator==(const SyntaxMapEntry &Other) const {
+    return Offset == Other.Offset && Length == Other.Length &&
+           Kind == Other.Kind;
+  }
+};
+
+class SyntaxMapConsumer : public EditorConsumer {
+public:
+  std::vector<SyntaxMapEntry> Entries;
+  unsigned AffectedOffset = 0;
+  unsigned AffectedLength = 0;
+
+private:
+  bool needsSemanticInfo() override { return false; }
+
+  void handleRequestError(const char *Description) override {
+    llvm_unreachable("unexpected error");
+  }
+
+  bool handleSyntaxMap(unsigned Offset, unsigned Length, UIdent Kind) override {
+    Entries.push_back({Offset, Length, Kind});
+    return true;
+  }
+
+  bool handleSemanticAnnotation(unsigned Offset, unsigned Length,
+                                UIdent Kind, bool isSystem) override {
+    return false;
+  }
+
+  bool beginDocumentSubStructure(unsigned Offset, unsigned Length,
+                                 UIdent Kind, UIdent AccessLevel,
+                                 UIdent SetterAccessLevel,
+                                 unsigned NameOffset,
+                                 unsigned NameLength,
+                                 unsigned BodyOffset,
+                                 unsigned BodyLength,
+                                 StringRef DisplayName,
+                                 StringRef TypeName,
+                                 StringRef RuntimeName,
+                                 StringRef SelectorName,
+                                 ArrayRef<StringRef> InheritedTypes,
+                                 ArrayRef<UIdent> Attrs) override {
+    return false;
+  }
+
+  bool endDocumentSubStructure() override { return false; }
+
+  bool handleDocumentSubStructureElement(UIdent Kind,
+                                         unsigned Offset,
+                                         unsigned Length) override {
+    return false;
+  }
+
+  bool recordAffectedRange(unsigned Offset, unsigned Length) override {
+    AffectedOffset = Offset;
+    AffectedLength = Length;
+    return true;
+  }
+
+  bool recordAffectedLineRange(unsigned Line, unsigned Length) override {
+    return false;
+  }
+
+  bool recordFormattedText(StringRef Text) override { return false; }
+
+  bool setDiagnosticStage(UIdent DiagStage) override { return false; }
+  bool handleDiagnostic(const DiagnosticEntryInfo &Info,
+                        UIdent DiagStage) override {
+    return false;
+  }
+
+  bool handleSourceText(StringRef Text) override { return false; }
+};
+
+class EditingTest : public ::testing::Test {
+  SourceKit::Context Ctx{ getRuntimeLibPath(), SourceKit::createSwiftLangSupport };
+
+public:
+  LangSupport &getLang() { return Ctx.getSwiftLangSupport(); }
+
+  SwiftLangSupport &getSwiftLang() {
+    return static_cast<SwiftLangSupport &>(getLang());
+  }
+
+  void open(StringRef DocName, StringRef Text, SyntaxMapConsumer &Consumer) {
+    auto Buf = MemoryBuffer::getMemBufferCopy(Text, DocName);
+    getLang().editorOpen(DocName, Buf.get(), /*EnableSyntaxMap=*/true,
+                         Consumer, /*Args=*/{});
+  }
+
+  void replaceText(StringRef DocName, unsigned Offset, unsigned Length,
+                   StringRef Text, SyntaxMapConsumer &Consumer) {
+    auto Buf = MemoryBuffer::getMemBufferCopy(Text, DocName);
+    getLang().editorReplaceText(DocName, Buf.get(), Offset, Length, Consumer);
+  }
+
+  /// Returns a document of about 10k lines.
+  static std::string makeLargeDocument() {
+    std::string Text;
+    for (unsigned i = 0; i != 1000; ++i) {
+      std::string N = std::to_string(i);
+      Text += "/// The type number " + N + ".\n";
+      Text += "struct S" + N + " {\n";
+      Text += "  var value: Int = " + N + "\n";
+      Text += "  /* The description\n";
+      Text += "     of the value. */\n";
+      Text += "  func describe() -> String {\n";
+      Text += "    return \"S" + N + "(\\(value))\" // trailing\n";
+      Text += "  }\n";
+      Text += "}\n";
+      Text += "\n";
+    }
+    return Text;
+  }
+
+  /// Checks that the syntax map reported for an edit of \p Text matches the
+  /// one of the edited text opened from scratch, and returns how long the edit
+  /// took, in microseconds.
+  int64_t checkEdit(StringRef Text, unsigned Offset, unsigned Length,
+                    StringRef NewText) {
+    const char *DocName = "/edited.swift";
+    SyntaxMapConsumer OpenConsumer;
+    open(DocName, Text, OpenConsumer);
+
+    SyntaxMapConsumer EditConsumer;
+    auto Start = std::chrono::steady_clock::now();
+    replaceText(DocName, Offset, Length, NewText, EditConsumer);
+    auto End = std::chrono::steady_clock::now();
+
+    checkSyntaxMap(applyEdit(Text, Offset, Length, NewText), EditConsumer);
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        End - Start).count();
+  }
+
+  static std::string applyEdit(StringRef Text, unsigned Offset,
+                               unsigned Length, StringRef NewText) {
+    std::string Edited = Text.substr(0, Offset);
+    Edited += NewText;
+    Edited += Text.substr(Offset + Length);
+    return Edited;
+  }
+
+  /// Checks that the syntax map reported to \p Consumer matches the one of
+  /// \p Text opened from scratch, in the range reported as affected.
+  void checkSyntaxMap(StringRef Text, const SyntaxMapConsumer &Consumer) {
+    SyntaxMapConsumer FreshConsumer;
+    open("/fresh.swift", Text, FreshConsumer);
+
+    std::vector<SyntaxMapEntry> Expected;
+    for (auto &Entry : FreshConsumer.Entries) {
+      if (Entry.Offset >= Consumer.AffectedOffset &&
+          Entry.Offset < Consumer.AffectedOffset + Consumer.AffectedLength)
+        Expected.push_back(Entry);
+    }
+    EXPECT_TRUE(Expected == Consumer.Entries);
+  }
+
+  ImmutableTextSnapshotRef replaceText(SwiftEditorDocument &Doc,
+                                       unsigned Offset, unsigned Length,
+                                       StringRef Text) {
+    auto Buf = MemoryBuffer::getMemBufferCopy(Text, "");
+    return Doc.replaceText(Offset, Length, Buf.get(),
+                           /*ProvideSemanticInfo=*/false);
+  }
+
+  /// Parses \p Snapshot of \p Doc and checks the syntax map reported for it
+  /// against \p Text opened from scratch.
+  void parseAndCheck(SwiftEditorDocument &Doc,
+                     ImmutableTextSnapshotRef Snapshot, StringRef Text) {
+    Doc.parse(Snapshot, getSwiftLang());
+    SyntaxMapConsumer Consumer;
+    Doc.readSyntaxInfo(Consumer);
+    checkSyntaxMap(Text, Consumer);
+  }
+};
+
+} // anonymous namespace
+
+TEST_F(EditingTest, SingleCharacterEditInLargeFile) {
+  std::string Text = makeLargeDocument();
+  unsigned Offset = StringRef(Text).find("value: Int = 500");
+  int64_t Latency = checkEdit(Text, Offset, 0, "x");
+  RecordProperty("EditLatencyMicroseconds", int(Latency));
+}
+
+TEST_F(EditingTest, OpenBlockCommentInLargeFile) {
+  std::string Text = makeLargeDocument();
+  unsigned Offset = StringRef(Text).find("struct S999");
+  int64_t Latency = checkEdit(Text, Offset, 0, "/*");
+  RecordProperty("EditLatencyMicroseconds", int(Latency));
+}
+
+TEST_F(EditingTest, CloseBlockCommentInLargeFile) {
+  std::string Text = makeLargeDocument();
+  unsigned Offset = StringRef(Text).find("of the value. */\n  func describe");
+  int64_t Latency = checkEdit(Text, Offset, 0, "*/");
+  RecordProperty("EditLatencyMicroseconds", int(Latency));
+}
+
+TEST_F(EditingTest, TwoEditsBeforeOneParse) {
+  std::string Text = makeLargeDocument();
+  SwiftEditorDocumentRef Doc =
+      new SwiftEditorDocument("/edited.swift", getSwiftLang());
+  auto Buf = MemoryBuffer::getMemBufferCopy(Text, "/edited.swift");
+  parseAndCheck(*Doc, Doc->initializeText(Buf.get(), {}), Text);
+
+  unsigned Offset1 = StringRef(Text).find("value: Int = 500");
+  std::string Text1 = applyEdit(Text, Offset1, 0, "x");
+  replaceText(*Doc, Offset1, 0, "x");
+
+  unsigned Offset2 = StringRef(Text1).find("struct S700");
+  std::string Text2 = applyEdit(Text1, Offset2, 0, "/*");
+  parseAndCheck(*Doc, replaceText(*Doc, Offset2, 0, "/*"), Text2);
+}
+
+TEST_F(EditingTest, ParseStaleSnapshot) {
+  std::string Text = makeLargeDocument();
+  SwiftEditorDocumentRef Doc =
+      new SwiftEditorDocument("/edited.swift", getSwiftLang());
+  auto Buf = MemoryBuffer::getMemBufferCopy(Text, "/edited.swift");
+  parseAndCheck(*Doc, Doc->initializeText(Buf.get(), {}), Text);
+
+  // Both edits are made before the first of them is parsed, as when a parse
+  // races with the next edit.
+  unsigned Offset1 = StringRef(Text).find("value: Int = 500");
+  std::string Text1 = applyEdit(Text, Offset1, 0, "x");
+  ImmutableTextSnapshotRef Snapshot1 = replaceText(*Doc, Offset1, 0, "x");
+
+  unsigned Offset2 = StringRef(Text1).find("struct S700");
+  std::string Text2 = applyEdit(Text1, Offset2, 0, "/*");
+  ImmutableTextSnapshotRef Snapshot2 = replaceText(*Doc, Offset2, 0, "/*");
+
+  parseAndCheck(*Doc, Snapshot1, Text1);
+  parseAndCheck(*Doc, Snapshot2, Text2);
+
+  // A snapshot older than the last one parsed is lexed from scratch.
+  parseAndCheck(*Doc, Snapshot1, Text1);
+}
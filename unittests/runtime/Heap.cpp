@@ -0,0 +1,139 @@
+//===--- Heap.cpp - Swift heap allocation tests ---------------------------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Runtime/HeapObject.h"
+#include "swift/Runtime/Heap.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace swift;
+
+TEST(HeapTest, slowAllocHonorsAlignment) {
+  for (size_t alignMask : {0, 7, 15, 31, 63, 127, 4095}) {
+    for (size_t size : {1, 16, 100, 1000}) {
+      void *p = swift_slowAlloc(size, alignMask);
+      EXPECT_EQ(0u, uintptr_t(p) & alignMask);
+      memset(p, 0xAB, size);
+      swift_slowDealloc(p, size, alignMask);
+    }
+  }
+}
+
+#if SWIFT_RUNTIME_HAS_SLAB_ALLOCATOR
+
+TEST(HeapTest, slabAllocDistinctBlocks) {
+  for (size_t size = 0; size <= SlabAllocatorMaxSize; size += 8) {
+    std::set<void *> seen;
+    std::vector<void *> blocks;
+    for (unsigned i = 0; i < 1000; ++i) {
+      void *p = _swift_slabAlloc(size);
+      EXPECT_EQ(0u, uintptr_t(p) % SlabAllocatorAlignment);
+      EXPECT_TRUE(seen.insert(p).second);
+      memset(p, 0xAB, size);
+      blocks.push_back(p);
+    }
+    for (void *p : blocks)
+      _swift_slabDealloc(p, size);
+  }
+}
+
+TEST(HeapTest, slabAllocCrossThreadDealloc) {
+  // Blocks allocated on one thread and freed on another must end up back in
+  // circulation without corrupting either thread's cache.
+  const unsigned numBlocks = 10000;
+  const size_t size = 48;
+
+  std::vector<void *> blocks;
+  std::thread producer([&] {
+    for (unsigned i = 0; i < numBlocks; ++i) {
+      void *p = _swift_slabAlloc(size);
+      memset(p, 0xAB, size);
+      blocks.push_back(p);
+    }
+  });
+  producer.join();
+
+  std::thread consumer([&] {
+    for (void *p : blocks)
+      _swift_slabDealloc(p, size);
+  });
+  consumer.join();
+
+  std::set<void *> seen;
+  for (unsigned i = 0; i < numBlocks; ++i)
+    EXPECT_TRUE(seen.insert(_swift_slabAlloc(size)).second);
+  for (void *p : seen)
+    _swift_slabDealloc(p, size);
+}
+
+TEST(HeapTest, slabAllocSize) {
+  int onStack;
+  EXPECT_EQ(0u, _swift_slabAllocSize(&onStack));
+  void *fromMalloc = malloc(32);
+  EXPECT_EQ(0u, _swift_slabAllocSize(fromMalloc));
+  free(fromMalloc);
+
+  for (size_t size = 0; size <= SlabAllocatorMaxSize; size += 8) {
+    std::vector<void *> blocks;
+    for (unsigned i = 0; i < 100; ++i) {
+      void *p = _swift_slabAlloc(size);
+      size_t usable = _swift_slabAllocSize(p);
+      // The usable size is that of the size class, which deallocating with
+      // must map back to.
+      EXPECT_GE(usable, size);
+      EXPECT_LT(usable, size + SlabAllocatorAlignment + (size ? 0 : 1));
+      EXPECT_EQ(0u, usable % SlabAllocatorAlignment);
+      memset(p, 0xAB, usable);
+      blocks.push_back(p);
+    }
+    for (void *p : blocks)
+      _swift_slabDealloc(p, _swift_slabAllocSize(p));
+  }
+}
+
+// Compare the slab allocator against malloc for an allocation pattern like
+// that of the ObjectAllocation benchmark. This is a benchmark rather than a
+// test; run it with --gtest_also_run_disabled_tests.
+TEST(HeapTest, DISABLED_slabAllocVersusMalloc) {
+  const unsigned numIterations = 10000000;
+  const unsigned liveObjects = 64;
+  const size_t size = 32;
+
+  auto measure = [&](const char *name, void *(*alloc)(size_t),
+                     void (*dealloc)(void *, size_t)) {
+    void *live[liveObjects] = {};
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < numIterations; ++i) {
+      auto &slot = live[i % liveObjects];
+      if (slot)
+        dealloc(slot, size);
+      slot = alloc(size);
+    }
+    for (auto p : live)
+      dealloc(p, size);
+    auto end = std::chrono::steady_clock::now();
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        end - start).count();
+    printf("%s: %.1f ns/allocation\n", name, double(ns) / numIterations);
+  };
+
+  measure("malloc", [](size_t size) { return malloc(size); },
+          [](void *p, size_t size) { free(p); });
+  measure("slab", _swift_slabAlloc, _swift_slabDealloc);
+}
+
+#endif
@@ -12,9 +12,13 @@
 
 #include "swift/Runtime/Metadata.h"
 #include "swift/Runtime/Concurrent.h"
+#include "llvm/ADT/Hashing.h"
 #include "gtest/gtest.h"
+#include <chrono>
+#include <cstring>
 #include <iterator>
 #include <functional>
+#include <thread>
 #include <sys/mman.h>
 #include <vector>
 #include <pthread.h>
@@ -225,6 +229,7 @@ TEST(Concurrent, ConcurrentMap) {
     int compareWithKey(size_t key) const {
       return (key == Key ? 0 : (key < Key ? -1 : 1));
     }
+    static size_t getKeyHash(size_t key) { return key; }
     static size_t getExtraAllocationSize(size_t key) { return 0; }
   };
 
@@ -248,6 +253,95 @@ TEST(Concurrent, ConcurrentMap) {
   }
 }
 
+TEST(Concurrent, ConcurrentMapGrowth) {
+  // Insert enough entries to force several incremental resizes, and check
+  // that concurrent readers can find everything inserted so far.
+  const size_t numElem = 20000;
+
+  struct Entry {
+    size_t Key;
+    Entry(size_t key) : Key(key) {}
+    int compareWithKey(size_t key) const {
+      return (key == Key ? 0 : (key < Key ? -1 : 1));
+    }
+    static size_t getKeyHash(size_t key) { return key * 0x9E3779B1; }
+    static size_t getExtraAllocationSize(size_t key) { return 0; }
+  };
+
+  ConcurrentMap<Entry> Map;
+
+  std::atomic<size_t> totalInserted(0);
+  RaceTest<int*>(
+    [&]() -> int* {
+      for (size_t i = 0; i < numElem; i++) {
+        auto result = Map.getOrInsert(i);
+        EXPECT_EQ(i, result.first->Key);
+        if (result.second)
+          totalInserted++;
+
+        auto found = Map.find(i / 2);
+        EXPECT_TRUE(found);
+        if (found)
+          EXPECT_EQ(i / 2, found->Key);
+      }
+      return nullptr;
+    }
+  );
+
+  // Every key was inserted by exactly one thread.
+  EXPECT_EQ(numElem, totalInserted.load());
+
+  for (size_t i = 0; i < numElem; i++)
+    EXPECT_TRUE(Map.find(i));
+  EXPECT_FALSE(Map.find(numElem));
+}
+
+// Lookup latency of ConcurrentMap at various sizes. This is a benchmark
+// rather than a test; run it with --gtest_also_run_disabled_tests.
+TEST(Concurrent, DISABLED_ConcurrentMapLookupLatency) {
+  struct Entry {
+    uintptr_t Key;
+    Entry(uintptr_t key) : Key(key) {}
+    int compareWithKey(uintptr_t key) const {
+      return (key == Key ? 0 : (key < Key ? -1 : 1));
+    }
+    static size_t getKeyHash(uintptr_t key) {
+      return llvm::hash_value(key);
+    }
+    static size_t getExtraAllocationSize(uintptr_t key) { return 0; }
+  };
+
+  const size_t numLookups = 10000000;
+
+  for (size_t numElem : {1000, 100000, 1000000}) {
+    ConcurrentMap<Entry> Map;
+
+    // Use pointer-like keys, as the runtime caches do.
+    std::vector<uintptr_t> keys;
+    for (size_t i = 0; i < numElem; i++)
+      keys.push_back(0x10000 + i * 48);
+    for (auto key : keys)
+      Map.getOrInsert(key);
+
+    // Visit the keys in a scrambled order to defeat the prefetcher.
+    size_t index = 0;
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numLookups; i++) {
+      index = (index + 7919) % numElem;
+      if (Map.find(keys[index]))
+        found++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_EQ(numLookups, found);
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        end - start).count();
+    printf("ConcurrentMap: %zu entries: %.1f ns/lookup\n",
+           numElem, double(ns) / numLookups);
+  }
+}
+
 
 TEST(MetadataTest, getGenericMetadata) {
   auto metadataTemplate = (GenericMetadata*) &MetadataTest1;
@@ -289,6 +383,46 @@ TEST(MetadataTest, getGenericMetadata) {
     });
 }
 
+// Throughput of cache hits in swift_getGenericMetadata as the number of
+// threads grows. Hits don't take a lock or write to shared memory, so this
+// should scale linearly with the number of cores. This is a benchmark
+// rather than a test; run it with --gtest_also_run_disabled_tests.
+TEST(MetadataTest, DISABLED_getGenericMetadataScaling) {
+  auto metadataTemplate = (GenericMetadata*) &MetadataTest1;
+  void *args[] = { &Global2 };
+  auto expected = swift_getGenericMetadata(metadataTemplate, args);
+
+  const size_t lookupsPerThread = 10000000;
+
+  for (unsigned numThreads = 1; numThreads <= 64; numThreads *= 2) {
+    std::atomic<size_t> mismatches(0);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < numThreads; i++) {
+      threads.push_back(std::thread([&] {
+        void *threadArgs[] = { &Global2 };
+        for (size_t j = 0; j < lookupsPerThread; j++) {
+          if (swift_getGenericMetadata(metadataTemplate, threadArgs)
+                != expected)
+            mismatches++;
+        }
+      }));
+    }
+    for (auto &thread : threads)
+      thread.join();
+    auto end = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(0u, mismatches.load());
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        end - start).count();
+    printf("swift_getGenericMetadata: %2u threads: %.1f M lookups/s\n",
+           numThreads,
+           double(lookupsPerThread) * numThreads / 1000.0 / (ms ? ms : 1));
+  }
+}
+
 FullMetadata<ClassMetadata> MetadataTest2 = {
   { { nullptr }, { &_TWVBo } },
   { { { MetadataKind::Class } }, nullptr, 0, ClassFlags(), nullptr, 0, 0, 0, 0, 0 }
@@ -341,6 +475,56 @@ TEST(MetadataTest, getMetatypeMetadata) {
   ASSERT_EQ(inst1, inst5->InstanceType);
 }
 
+TEST(MetadataTest, enumerateMetadataAllocatorStatistics) {
+  // Make sure the metatype cache has allocated something.
+  auto inst = swift_getMetatypeMetadata(&_TMBi8_.base);
+  ASSERT_EQ(&_TMBi8_.base, inst->InstanceType);
+
+  struct Totals {
+    size_t Reserved = 0;
+    size_t Wasted = 0;
+  } totals;
+
+  swift_enumerateMetadataAllocatorStatistics(
+    [](const char *cacheName, size_t bytesReserved, size_t bytesWasted,
+       void *context) {
+      EXPECT_LE(bytesWasted, bytesReserved);
+      if (strcmp(cacheName, "MetatypeCache") != 0)
+        return;
+      auto totals = static_cast<Totals *>(context);
+      totals->Reserved += bytesReserved;
+      totals->Wasted += bytesWasted;
+    }, &totals);
+
+  EXPECT_GT(totals.Reserved, totals.Wasted);
+}
+
+#if SWIFT_RUNTIME_SUPPORTS_THREAD_LOCAL
+static size_t getMetatypeCacheBytesWasted() {
+  size_t wasted = 0;
+  swift_enumerateMetadataAllocatorStatistics(
+    [](const char *cacheName, size_t bytesReserved, size_t bytesWasted,
+       void *context) {
+      if (strcmp(cacheName, "MetatypeCache") == 0)
+        *static_cast<size_t *>(context) += bytesWasted;
+    }, &wasted);
+  return wasted;
+}
+
+TEST(MetadataTest, metadataAllocatorThreadExitWaste) {
+  size_t wastedBefore = getMetatypeCacheBytesWasted();
+
+  // Instantiate a metatype no other test uses on a thread of its own. When
+  // the thread exits, the unused tail of its chunk is counted as wasted.
+  std::thread([] {
+    auto inst = swift_getMetatypeMetadata(&_TMBi16_.base);
+    EXPECT_EQ(&_TMBi16_.base, inst->InstanceType);
+  }).join();
+
+  EXPECT_GT(getMetatypeCacheBytesWasted(), wastedBefore);
+}
+#endif
+
 ProtocolDescriptor ProtocolA{
   "_TMp8Metadata9ProtocolA",
   nullptr,
@@ -0,0 +1,185 @@
+//===--- main.cpp - Time loading and marking a dependency graph -----------===//
+//
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2014 - 2016 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+//===----------------------------------------------------------------------===//
+//
+// Generates the reference dependencies of a synthetic module, in both the YAML
+// and the binary swiftdeps format, and times loading them into a
+// DependencyGraph and marking the files that need to be rebuilt.
+//
+// Usage: main [number of files] [names provided per file]
+//
+//===----------------------------------------------------------------------===//
+
+#include "swift/Basic/BinarySwiftDeps.h"
+#include "swift/Driver/DependencyGraph.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace swift;
+using binary_swiftdeps::Section;
+
+namespace {
+/// The names a file provides and depends on.
+struct FileDeps {
+  std::vector<std::string> ProvidesTopLevel;
+  std::vector<std::string> ProvidesNominal;
+  std::vector<std::pair<std::string, std::string>> ProvidesMember;
+  std::vector<std::string> DependsTopLevel;
+  std::vector<std::string> DependsNominal;
+  std::vector<std::pair<std::string, std::string>> DependsMember;
+  std::vector<std::string> DependsExternal;
+};
+
+std::vector<FileDeps> generate(unsigned numFiles, unsigned namesPerFile) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<unsigned> pickFile(0, numFiles - 1);
+  std::uniform_int_distribution<unsigned> pickName(0, namesPerFile - 1);
+
+  auto topLevelName = [](unsigned file, unsigned i) {
+    return "function" + std::to_string(file) + "_" + std::to_string(i);
+  };
+  auto nominalName = [](unsigned file) {
+    return "V4main4Type" + std::to_string(file);
+  };
+  auto memberName = [](unsigned i) { return "member" + std::to_string(i); };
+
+  std::vector<FileDeps> files(numFiles);
+  for (unsigned file = 0; file != numFiles; ++file) {
+    FileDeps &deps = files[file];
+    deps.ProvidesNominal.push_back(nominalName(file));
+    for (unsigned i = 0; i != namesPerFile; ++i) {
+      deps.ProvidesTopLevel.push_back(topLevelName(file, i));
+      deps.ProvidesMember.push_back({nominalName(file), memberName(i)});
+    }
+    for (unsigned i = 0; i != namesPerFile; ++i) {
+      unsigned other = pickFile(rng);
+      deps.DependsTopLevel.push_back(topLevelName(other, pickName(rng)));
+      deps.DependsNominal.push_back(nominalName(other));
+      deps.DependsMember.push_back({nominalName(other),
+                                    memberName(pickName(rng))});
+    }
+    deps.DependsExternal.push_back("/sdk/Module" + std::to_string(file % 10) +
+                                   ".swiftmodule");
+  }
+  return files;
+}
+
+std::string writeYAML(const FileDeps &deps) {
+  std::string result;
+  llvm::raw_string_ostream out(result);
+  auto writeNames = [&](StringRef key, const std::vector<std::string> &names) {
+    out << key << ":\n";
+    for (auto &name : names)
+      out << "- \"" << name << "\"\n";
+  };
+  auto writeMembers = [&](StringRef key,
+                          const std::vector<std::pair<std::string,
+                                                      std::string>> &names) {
+    out << key << ":\n";
+    for (auto &name : names)
+      out << "- [\"" << name.first << "\", \"" << name.second << "\"]\n";
+  };
+  writeNames("provides-top-level", deps.ProvidesTopLevel);
+  writeNames("provides-nominal", deps.ProvidesNominal);
+  writeMembers("provides-member", deps.ProvidesMember);
+  writeNames("depends-top-level", deps.DependsTopLevel);
+  writeNames("depends-nominal", deps.DependsNominal);
+  writeMembers("depends-member", deps.DependsMember);
+  writeNames("depends-external", deps.DependsExternal);
+  return out.str();
+}
+
+std::string writeBinary(const FileDeps &deps) {
+  binary_swiftdeps::Writer writer;
+  auto addNames = [&](Section kind, const std::vector<std::string> &names) {
+    for (auto &name : names)
+      writer.addEntry(kind, name);
+  };
+  auto addMembers = [&](Section kind,
+                        const std::vector<std::pair<std::string,
+                                                    std::string>> &names) {
+    for (auto &name : names)
+      writer.addEntry(kind, name.first + '\0' + name.second);
+  };
+  addNames(Section::ProvidesTopLevel, deps.ProvidesTopLevel);
+  addNames(Section::ProvidesNominal, deps.ProvidesNominal);
+  addMembers(Section::ProvidesMember, deps.ProvidesMember);
+  addNames(Section::DependsTopLevel, deps.DependsTopLevel);
+  addNames(Section::DependsNominal, deps.DependsNominal);
+  addMembers(Section::DependsMember, deps.DependsMember);
+  addNames(Section::DependsExternal, deps.DependsExternal);
+
+  std::string result;
+  llvm::raw_string_ostream out(result);
+  writer.write(out);
+  return out.str();
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+/// Loads \p contents into a fresh graph, then marks the files that depend on
+/// the first one, as if it had changed, and prints how long each step took.
+void run(StringRef format, const std::vector<std::string> &contents) {
+  size_t totalSize = 0;
+  for (auto &data : contents)
+    totalSize += data.size();
+
+  DependencyGraph<uintptr_t> graph;
+  auto start = std::chrono::steady_clock::now();
+  for (uintptr_t file = 0, e = contents.size(); file != e; ++file) {
+    auto result = graph.loadFromString(file, contents[file]);
+    if (result != DependencyGraphImpl::LoadResult::UpToDate) {
+      llvm::errs() << "error: could not load file " << file << "\n";
+      exit(1);
+    }
+  }
+  double loadTime = millisecondsSince(start);
+
+  start = std::chrono::steady_clock::now();
+  SmallVector<uintptr_t, 16> marked;
+  graph.markTransitive(marked, 0);
+  double markTime = millisecondsSince(start);
+
+  llvm::outs() << format << ": " << totalSize << " bytes, load "
+               << llvm::format("%.1f", loadTime) << " ms, mark "
+               << llvm::format("%.1f", markTime) << " ms ("
+               << marked.size() << " files marked)\n";
+}
+} // end anonymous namespace
+
+int main(int argc, char **argv) {
+  unsigned numFiles = argc > 1 ? atoi(argv[1]) : 1000;
+  unsigned namesPerFile = argc > 2 ? atoi(argv[2]) : 50;
+  if (numFiles == 0 || namesPerFile == 0) {
+    llvm::errs() << "usage: " << argv[0]
+                 << " [number of files] [names provided per file]\n";
+    return 1;
+  }
+
+  std::vector<FileDeps> files = generate(numFiles, namesPerFile);
+  std::vector<std::string> yaml, binary;
+  for (auto &deps : files) {
+    yaml.push_back(writeYAML(deps));
+    binary.push_back(writeBinary(deps));
+  }
+
+  run("yaml", yaml);
+  run("binary", binary);
+  return 0;
+}
@@ -0,0 +1,18 @@
+// RUN: %target-swift-frontend -parse -print-stats %s 2>&1 | FileCheck %s
+// REQUIRES: asserts
+
+// Long chains of overloaded operators over literals.
+
+// CHECK-DAG: {{[1-9][0-9]*}} Constraint solver overall - # of connected components reused
+// CHECK-DAG: Constraint solver overall - # of solution states explored
+
+let a = 1 + 2 * 3 - 4 + 5 * 6 - 7 + 8 * 9 - 10
+let b = 1.0 + 2 * 3.0 - 4 + 5 * 6 - 7.0 + 8
+let c: Double = 1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10
+let d = -(1 + 2) * -(3 + 4) * -(5 + 6) * -(7 + 8)
+
+// The first argument is solved again, in the same state, for each overload.
+func clamp(_ x: Int, to limit: Int) -> Int { return min(x, limit) }
+func clamp(_ x: Int, to limit: Double) -> Double { return min(Double(x), limit) }
+
+let e = clamp(1 + 2 * 3 - 4 + 5 * 6 - 7 + 8 * 9, to: 10 * 11)
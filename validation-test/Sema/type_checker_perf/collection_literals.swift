@@ -0,0 +1,21 @@
+// RUN: %target-swift-frontend -parse -print-stats %s 2>&1 | FileCheck %s
+// REQUIRES: asserts
+
+// Collection literals containing arithmetic on literals.
+
+// CHECK-DAG: {{[1-9][0-9]*}} Constraint solver overall - # of connected components reused
+// CHECK-DAG: Constraint solver overall - # of solution states explored
+
+let h = [1 + 1, 2 * 2, 3 - 3, 4 + 4, 5 * 5, 6 - 6, 7 + 7, 8 * 8]
+let i = [1: 1 + 1, 2: 2 * 2, 3: 3 - 3, 4: 4 + 4]
+let j = [(1 + 2, 3.0 * 4), (5 - 6, 7.0 + 8), (9 * 10, 11.0 - 12)]
+
+// The first argument is solved again, in the same state, for each overload.
+func sum(_ xs: [Int], scaledBy factor: Int) -> Int {
+  return xs.reduce(0, +) * factor
+}
+func sum(_ xs: [Int], scaledBy factor: Double) -> Double {
+  return Double(xs.reduce(0, +)) * factor
+}
+
+let k = sum([1 + 1, 2 * 2, 3 - 3, 4 + 4, 5 * 5, 6 - 6], scaledBy: 7 + 7)
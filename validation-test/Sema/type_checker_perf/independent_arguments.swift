@@ -0,0 +1,20 @@
+// RUN: %target-swift-frontend -parse -print-stats %s 2>&1 | FileCheck %s
+// REQUIRES: asserts
+
+// Calls to overloaded functions whose arguments are independent of each
+// other once an overload has been picked.
+
+// CHECK-DAG: {{[1-9][0-9]*}} Constraint solver overall - # of connected components reused
+// CHECK-DAG: Constraint solver overall - # of solution states explored
+
+func combine(_ x: Int, _ y: Int, _ z: Int) -> Int { return x + y + z }
+func combine(_ x: Double, _ y: Double, _ z: Double) -> Double { return x + y + z }
+func combine(_ x: Float, _ y: Float, _ z: Float) -> Float { return x + y + z }
+func combine(_ x: Int, _ y: Int, _ z: Double) -> Double {
+  return Double(x + y) + z
+}
+
+let x = 3
+let e = combine(x + 1, x * 2 + 3, x - 4)
+let f = combine(1 + 2 + 3, 4 * 5 * 6, 7 - 8 - 9)
+let g = combine(1.5 * 2, 3 + 4.5, 6 - 7)